@@ -0,0 +1,73 @@
+Write-Host "Building compiler daemon..."
+
+# Compile source files
+$sources = @(
+    "run_daemon.cpp",
+    "daemon/daemon.cpp",
+    "utils/thread_pool.cpp",
+    "pipeline/pipeline.cpp",
+    "pipeline/compile_cache.cpp",
+    "pipeline/incremental_compiler.cpp",
+    "lexer/lexer.cpp",
+    "symbol_table/symbol_table.cpp",
+    "parser/parsing_table.cpp",
+    "parser/compiled_grammar.cpp",
+    "parser/grammar_file.cpp",
+    "parser/ll_parser.cpp",
+    "parser/parse_trace.cpp",
+    "parser/trace_file.cpp",
+    "parser/cst.cpp",
+    "parser/cst_compaction.cpp",
+    "parser/tree_writer.cpp",
+    "parser/tree_file.cpp",
+    "utils/artifact_loader.cpp",
+    "utils/json_reader.cpp",
+    "utils/json_emitter.cpp",
+    "utils/output_buffer.cpp",
+    "utils/mapped_file.cpp",
+    "utils/first_follow.cpp",
+    "utils/utils.cpp",
+    "utils/left_recursion.cpp",
+    "utils/left_factoring.cpp",
+    "utils/trie/memory_efficient_trie.cpp",
+    "grammar/grammar.cpp",
+    "grammar/ebnf.cpp",
+    "grammar/grammar_module.cpp",
+    "grammar/grammar_transform.cpp",
+    "grammar/grammar_reduction.cpp",
+    "grammar/left_recursion_engine.cpp"
+)
+
+$objects = @()
+foreach ($source in $sources) {
+    $obj = $source -replace '\.cpp$', '.o'
+    $command = "g++ -std=c++17 -c $source -pthread -I include -I . -o $obj"
+    Write-Host "Compiling $source..."
+    Invoke-Expression $command
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "Failed to compile $source"
+        exit 1
+    }
+    $objects += $obj
+}
+
+# Link the daemon, then the test client against the same objects
+$objList = $objects -join " "
+$command = "g++ $objList -pthread -o daemon_run.exe"
+Write-Host "Linking..."
+Invoke-Expression $command
+$daemonStatus = $LASTEXITCODE
+
+$libObjects = ($objects | Where-Object { $_ -ne "run_daemon.o" }) -join " "
+$command = "g++ -std=c++17 run_daemon_client.cpp $libObjects -pthread -I include -I . -o daemon_client_run.exe"
+Invoke-Expression $command
+
+if ($daemonStatus -eq 0 -and $LASTEXITCODE -eq 0) {
+    Write-Host "Build successful! Executables created at daemon_run.exe and daemon_client_run.exe"
+    # Clean up object files
+    foreach ($obj in $objects) {
+        Remove-Item $obj
+    }
+} else {
+    Write-Host "Linking failed!"
+}
@@ -4,19 +4,31 @@ Write-Host "Building parsing table component..."
 $sources = @(
     "run_parsing_table.cpp",
     "parser/parsing_table.cpp",
+    "parser/compiled_grammar.cpp",
+    "parser/grammar_file.cpp",
+    "utils/artifact_loader.cpp",
+    "utils/json_reader.cpp",
+    "utils/json_emitter.cpp",
+    "utils/output_buffer.cpp",
+    "utils/mapped_file.cpp",
     "utils/first_follow.cpp",
     "utils/utils.cpp",
+    "utils/thread_pool.cpp",
     "utils/left_recursion.cpp",
     "utils/left_factoring.cpp",
     "utils/trie/memory_efficient_trie.cpp",
     "grammar/grammar.cpp",
-    "grammar/grammar_transform.cpp"
+    "grammar/ebnf.cpp",
+    "grammar/grammar_module.cpp",
+    "grammar/grammar_transform.cpp",
+    "grammar/grammar_reduction.cpp",
+    "grammar/left_recursion_engine.cpp"
 )
 
 $objects = @()
 foreach ($source in $sources) {
     $obj = $source -replace '\.cpp$', '.o'
-    $command = "g++ -std=c++17 -c $source -I include -o $obj"
+    $command = "g++ -std=c++17 -c $source -pthread -I include -o $obj"
     Write-Host "Compiling $source..."
     Invoke-Expression $command
     if ($LASTEXITCODE -ne 0) {
@@ -28,7 +40,7 @@ foreach ($source in $sources) {
 
 # Link the object files
 $objList = $objects -join " "
-$command = "g++ $objList -o parsing_table_run.exe"
+$command = "g++ $objList -pthread -o parsing_table_run.exe"
 Write-Host "Linking..."
 Invoke-Expression $command
 
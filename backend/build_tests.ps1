@@ -0,0 +1,90 @@
+Write-Host "Building tests..."
+
+# Compile source files
+$sources = @(
+    "pipeline/pipeline.cpp",
+    "pipeline/compile_cache.cpp",
+    "pipeline/incremental_compiler.cpp",
+    "lexer/lexer.cpp",
+    "symbol_table/symbol_table.cpp",
+    "parser/parsing_table.cpp",
+    "parser/compiled_grammar.cpp",
+    "parser/grammar_file.cpp",
+    "parser/ll_parser.cpp",
+    "parser/parse_trace.cpp",
+    "parser/trace_file.cpp",
+    "parser/cst.cpp",
+    "parser/cst_compaction.cpp",
+    "parser/tree_writer.cpp",
+    "parser/tree_file.cpp",
+    "utils/artifact_loader.cpp",
+    "utils/json_reader.cpp",
+    "utils/json_emitter.cpp",
+    "utils/output_buffer.cpp",
+    "utils/mapped_file.cpp",
+    "utils/first_follow.cpp",
+    "utils/utils.cpp",
+    "utils/thread_pool.cpp",
+    "utils/left_recursion.cpp",
+    "utils/left_factoring.cpp",
+    "utils/trie/memory_efficient_trie.cpp",
+    "grammar/grammar.cpp",
+    "grammar/ebnf.cpp",
+    "grammar/grammar_module.cpp",
+    "grammar/grammar_transform.cpp",
+    "grammar/grammar_reduction.cpp",
+    "grammar/left_recursion_engine.cpp"
+)
+
+# Standalone test programs under test/, each exits with 1 on failure
+$tests = @(
+    "test/test_parsing_table.cpp",
+    "test/test_incremental_compiler.cpp",
+    "test/test_left_recursion_engine.cpp",
+    "test/test_left_factoring.cpp",
+    "test/test_grammar_reduction.cpp"
+)
+
+$objects = @()
+foreach ($source in $sources) {
+    $obj = $source -replace '\.cpp$', '.o'
+    $command = "g++ -std=c++17 -O2 -c $source -pthread -I include -I . -o $obj"
+    Write-Host "Compiling $source..."
+    Invoke-Expression $command
+    if ($LASTEXITCODE -ne 0) {
+        Write-Host "Failed to compile $source"
+        exit 1
+    }
+    $objects += $obj
+}
+
+# Link and run every test against the same objects
+$objList = $objects -join " "
+$failed = @()
+foreach ($test in $tests) {
+    $exe = ($test -replace '\.cpp$', '.exe')
+    $command = "g++ -std=c++17 -O2 $test $objList -pthread -I include -I . -o $exe"
+    Write-Host "Building $test..."
+    Invoke-Expression $command
+    if ($LASTEXITCODE -ne 0) {
+        $failed += $test
+        continue
+    }
+    Write-Host "Running $exe..."
+    Invoke-Expression "./$exe"
+    if ($LASTEXITCODE -ne 0) {
+        $failed += $test
+    }
+}
+
+# Clean up object files
+foreach ($obj in $objects) {
+    Remove-Item $obj
+}
+
+if ($failed.Count -eq 0) {
+    Write-Host "All tests passed!"
+} else {
+    Write-Host "Failed: $($failed -join ', ')"
+    exit 1
+}
@@ -0,0 +1,549 @@
+#include "daemon/daemon.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "grammar/grammar.h"
+#include "parser/tree_writer.h"
+#include "pipeline/incremental_compiler.h"
+#include "pipeline/pipeline.h"
+#include "utils/json_emitter.h"
+#include "utils/json_reader.h"
+#include "utils/output_buffer.h"
+#include "utils/thread_pool.h"
+
+namespace jucc::daemon {
+
+namespace {
+
+// a frame larger than this is treated as a corrupt length
+constexpr uint32_t MAX_FRAME_SIZE = 64U << 20;
+
+}  // namespace
+
+struct Daemon::Grammar {
+  std::shared_ptr<const parser::LLGrammar> tables;  // shared by the parsers of every session
+  std::vector<std::string> conflicts;
+  size_t num_terminals;
+  size_t num_non_terminals;
+
+  // what an edit recompiles from when the editor holds another grammar
+  std::string source;
+  std::vector<std::pair<std::string, grammar::Rules>> edits;
+  std::shared_ptr<Editor> editor;  // shared along a chain of edits
+};
+
+struct Daemon::Editor {
+  std::mutex mutex;  // one edit of the chain at a time
+  pipeline::IncrementalCompiler compiler;
+  std::string grammar;  // id of the grammar compiler holds, empty before the first edit
+};
+
+struct Daemon::Session {
+  parser::LLParser parser;
+  bool accepted;
+};
+
+struct Daemon::Request {
+  std::string op;
+  bool has_id{false};
+  bool id_is_string{false};
+  int64_t id{0};
+  std::string id_string;
+
+  std::string grammar;
+  std::string session;
+  std::string parent;
+  bool has_rules{false};
+  grammar::Rules rules;
+  bool has_source{false};
+  std::string source;
+  bool has_tokens{false};
+  std::vector<std::string> tokens;
+  int64_t from{0};
+  int64_t count{100};
+  int64_t node{-1};
+  int64_t depth{1};
+};
+
+bool ReadFrame(std::istream &in, std::string &payload) {
+  unsigned char length[4];
+  if (!in.read(reinterpret_cast<char *>(length), sizeof(length))) {
+    return false;
+  }
+  uint32_t size = length[0] | (length[1] << 8U) | (length[2] << 16U) | (static_cast<uint32_t>(length[3]) << 24U);
+  if (size > MAX_FRAME_SIZE) {
+    return false;
+  }
+  payload.resize(size);
+  return static_cast<bool>(in.read(payload.data(), size));
+}
+
+void WriteFrame(std::ostream &out, std::string_view payload) {
+  auto size = static_cast<uint32_t>(payload.size());
+  char length[4] = {static_cast<char>(size & 0xFF), static_cast<char>((size >> 8) & 0xFF),
+                    static_cast<char>((size >> 16) & 0xFF), static_cast<char>((size >> 24) & 0xFF)};
+  out.write(length, sizeof(length));
+  out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+  out.flush();
+}
+
+Daemon::Daemon(DaemonOptions options) : options_(options) {}
+
+Daemon::~Daemon() = default;
+
+Daemon::Request Daemon::ParseRequest(const std::string &payload) {
+  Request request;
+  std::istringstream in(payload);
+  utils::JsonReader reader(in, payload.size() + 1);
+  std::string key;
+  reader.BeginObject();
+  while (reader.NextKey(key)) {
+    if (key == "op") {
+      reader.ReadString(request.op);
+    } else if (key == "id") {
+      request.has_id = true;
+      request.id_is_string = reader.PeekType() == utils::JsonReader::Type::STRING;
+      if (request.id_is_string) {
+        reader.ReadString(request.id_string);
+      } else {
+        request.id = reader.ReadInt();
+      }
+    } else if (key == "grammar") {
+      reader.ReadString(request.grammar);
+    } else if (key == "session") {
+      reader.ReadString(request.session);
+    } else if (key == "parent") {
+      reader.ReadString(request.parent);
+    } else if (key == "rules") {
+      request.has_rules = true;
+      reader.BeginArray();
+      while (reader.NextElement()) {
+        std::vector<std::string> entities;
+        reader.BeginArray();
+        while (reader.NextElement()) {
+          entities.emplace_back();
+          reader.ReadString(entities.back());
+        }
+        request.rules.emplace_back(std::move(entities));
+      }
+    } else if (key == "source") {
+      request.has_source = true;
+      reader.ReadString(request.source);
+    } else if (key == "tokens") {
+      request.has_tokens = true;
+      reader.BeginArray();
+      while (reader.NextElement()) {
+        request.tokens.emplace_back();
+        reader.ReadString(request.tokens.back());
+      }
+    } else if (key == "from") {
+      request.from = reader.ReadInt();
+    } else if (key == "count") {
+      request.count = reader.ReadInt();
+    } else if (key == "node") {
+      request.node = reader.ReadInt();
+    } else if (key == "depth") {
+      request.depth = reader.ReadInt();
+    } else {
+      reader.Skip();
+    }
+  }
+  reader.ExpectEnd();
+  return request;
+}
+
+std::string Daemon::Respond(const Request *request, const std::function<void(utils::JsonEmitter &)> &body) {
+  std::ostringstream text;
+  {
+    utils::OutputBuffer out(text);
+    utils::JsonEmitter json(out, true);
+    json.BeginObject();
+    if (request != nullptr && request->has_id) {
+      json.Key("id");
+      if (request->id_is_string) {
+        json.String(request->id_string);
+      } else {
+        json.Int(request->id);
+      }
+    }
+    body(json);
+    json.EndObject();
+  }
+  return text.str();
+}
+
+std::string Daemon::ErrorResponse(const Request *request, const std::string &error) {
+  return Respond(request, [&error](utils::JsonEmitter &json) {
+    json.Key("ok");
+    json.Bool(false);
+    json.Key("error");
+    json.String(error);
+  });
+}
+
+std::string Daemon::Dispatch(const Request &request) {
+  using Handler = void (Daemon::*)(const Request &, utils::JsonEmitter &);
+  static const std::pair<const char *, Handler> handlers[] = {
+      {"compile", &Daemon::Compile}, {"edit", &Daemon::Edit},   {"lex", &Daemon::Lex},
+      {"parse", &Daemon::Parse},     {"trace", &Daemon::Trace}, {"tree", &Daemon::Tree},
+      {"close", &Daemon::Close},     {"shutdown", &Daemon::Shutdown},
+  };
+  Handler handler = nullptr;
+  for (const auto &entry : handlers) {
+    if (request.op == entry.first) {
+      handler = entry.second;
+    }
+  }
+  if (handler == nullptr) {
+    return ErrorResponse(&request, "unknown op: " + request.op);
+  }
+
+  try {
+    return Respond(&request, [this, &request, handler](utils::JsonEmitter &json) {
+      json.Key("ok");
+      json.Bool(true);
+      (this->*handler)(request, json);
+    });
+  } catch (const std::exception &e) {
+    return ErrorResponse(&request, e.what());
+  }
+}
+
+std::string Daemon::Handle(const std::string &payload, bool *shutdown) {
+  Request request;
+  try {
+    request = ParseRequest(payload);
+  } catch (const std::exception &e) {
+    return ErrorResponse(nullptr, std::string("bad request: ") + e.what());
+  }
+  if (shutdown != nullptr) {
+    *shutdown = request.op == "shutdown";
+  }
+  return Dispatch(request);
+}
+
+std::shared_ptr<const Daemon::Grammar> Daemon::FindGrammar(const std::string &id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = grammars_.find(id);
+  if (it == grammars_.end()) {
+    throw std::runtime_error("no grammar " + id);
+  }
+  return it->second;
+}
+
+std::shared_ptr<const Daemon::Session> Daemon::FindSession(const std::string &id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sessions_.find(id);
+  if (it == sessions_.end()) {
+    throw std::runtime_error("no session " + id);
+  }
+  return it->second;
+}
+
+void Daemon::Compile(const Request &request, utils::JsonEmitter &json) {
+  std::ifstream file(request.grammar, std::ios::binary);
+  if (!file.is_open()) {
+    throw std::runtime_error("could not open " + request.grammar);
+  }
+  std::ostringstream text;
+  text << file.rdbuf();
+  std::string source = text.str();
+  // an edited module must not hit the grammar compiled from its old text
+  std::string base_dir = std::filesystem::path(request.grammar).parent_path().string();
+  std::string key = request.grammar + '\n' + source + pipeline::ImportedModulesText(source, base_dir);
+
+  std::string id;
+  std::shared_ptr<const Grammar> grammar;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = grammar_by_content_.find(key);
+    if (it != grammar_by_content_.end()) {
+      id = it->second;
+      grammar = grammars_.at(id);
+    }
+  }
+
+  if (!grammar) {
+    // compiled outside the lock, a concurrent compile of the same file may win the insert below
+    pipeline::PipelineOptions pipeline_options;
+    pipeline_options.cache_dir = options_.cache_dir;
+    pipeline::Pipeline pipeline(pipeline_options);
+    // compiled from the text read above, the file is not read again
+    std::istringstream input(source);
+    if (!pipeline.LoadGrammar(input, base_dir) || !pipeline.BuildTable()) {
+      throw std::runtime_error(pipeline.GetError());
+    }
+    auto compiled = std::make_shared<Grammar>();
+    compiled->tables = pipeline.GetParser().GetGrammar();
+    compiled->conflicts = pipeline.GetConflicts();
+    compiled->num_terminals = pipeline.GetTerminals().size();
+    compiled->num_non_terminals = pipeline.GetNonTerminals().size();
+    compiled->source = std::move(source);
+    compiled->editor = std::make_shared<Editor>();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto inserted = grammar_by_content_.emplace(key, "g" + std::to_string(next_grammar_));
+    id = inserted.first->second;
+    if (inserted.second) {
+      next_grammar_++;
+      grammars_.emplace(id, compiled);
+    }
+    grammar = grammars_.at(id);
+  }
+
+  WriteGrammar(json, id, *grammar);
+}
+
+void Daemon::WriteGrammar(utils::JsonEmitter &json, const std::string &id, const Grammar &grammar) {
+  json.Key("grammar");
+  json.String(id);
+  json.Key("conflicts");
+  json.BeginArray();
+  for (const auto &conflict : grammar.conflicts) {
+    json.String(conflict);
+  }
+  json.EndArray();
+  json.Key("terminals");
+  json.Int(static_cast<int64_t>(grammar.num_terminals));
+  json.Key("non_terminals");
+  json.Int(static_cast<int64_t>(grammar.num_non_terminals));
+}
+
+void Daemon::Edit(const Request &request, utils::JsonEmitter &json) {
+  std::shared_ptr<const Grammar> grammar = FindGrammar(request.grammar);
+  if (request.parent.empty() || !request.has_rules) {
+    throw std::runtime_error("edit needs a parent and its rules");
+  }
+
+  Editor &editor = *grammar->editor;
+  std::lock_guard<std::mutex> edit_lock(editor.mutex);
+  pipeline::IncrementalCompiler &compiler = editor.compiler;
+  if (editor.grammar != request.grammar) {
+    // the editor is elsewhere in the chain, or has not compiled it yet
+    editor.grammar.clear();
+    std::istringstream input(grammar->source);
+    if (!compiler.Load(input)) {
+      throw std::runtime_error(compiler.GetError());
+    }
+    for (const auto &edit : grammar->edits) {
+      compiler.ReplaceRules(edit.first, edit.second);
+    }
+    editor.grammar = request.grammar;
+  }
+  if (!compiler.ReplaceRules(request.parent, request.rules)) {
+    throw std::runtime_error(compiler.GetError());
+  }
+  // from here on the compiler holds the edited grammar, not request.grammar
+  editor.grammar.clear();
+
+  parser::LLParser parser;
+  if (!parser.Initialize(compiler.GetProductions(), compiler.GetTerminals(), compiler.GetNonTerminals(),
+                         compiler.GetStartSymbol(), compiler.GetTable(), compiler.GetGenerated())) {
+    throw std::runtime_error("could not build a parser for the edited grammar");
+  }
+  auto edited = std::make_shared<Grammar>();
+  edited->tables = parser.GetGrammar();
+  edited->conflicts = compiler.GetConflicts();
+  edited->num_terminals = compiler.GetTerminals().size();
+  edited->num_non_terminals = compiler.GetNonTerminals().size();
+  edited->source = grammar->source;
+  edited->edits = grammar->edits;
+  edited->edits.emplace_back(request.parent, request.rules);
+  edited->editor = grammar->editor;
+
+  std::string id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    id = "g" + std::to_string(next_grammar_++);
+    grammars_.emplace(id, edited);
+  }
+  editor.grammar = id;
+
+  WriteGrammar(json, id, *edited);
+  const pipeline::EditStats &stats = compiler.GetLastEdit();
+  json.Key("recomputed");
+  json.BeginObject(true);
+  json.Key("groups");
+  json.Int(static_cast<int64_t>(stats.groups));
+  json.Key("productions");
+  json.Int(static_cast<int64_t>(stats.productions));
+  json.Key("first");
+  json.Int(static_cast<int64_t>(stats.first));
+  json.Key("follow");
+  json.Int(static_cast<int64_t>(stats.follow));
+  json.Key("rows");
+  json.Int(static_cast<int64_t>(stats.rows));
+  json.EndObject();
+}
+
+void Daemon::Lex(const Request &request, utils::JsonEmitter &json) {
+  std::istringstream source(request.source);
+  lexer::Lexer lexer;
+  while (lexer.GetToken(source) != lexer::TOK_EOF) {
+  }
+  json.Key("tokens");
+  json.BeginArray();
+  for (const auto &token : lexer.GetTokens()) {
+    json.BeginObject();
+    json.Key("type");
+    json.String(token.type);
+    json.Key("value");
+    json.String(token.value);
+    json.Key("line");
+    json.Int(token.line);
+    json.Key("error");
+    json.Bool(token.error);
+    json.EndObject();
+  }
+  json.EndArray();
+}
+
+void Daemon::Parse(const Request &request, utils::JsonEmitter &json) {
+  std::shared_ptr<const Grammar> grammar = FindGrammar(request.grammar);
+  std::vector<std::string> tokens = request.tokens;
+  if (request.has_source) {
+    std::istringstream source(request.source);
+    lexer::Lexer lexer;
+    while (lexer.GetToken(source) != lexer::TOK_EOF) {
+    }
+    tokens = pipeline::TokenTerminals(lexer.GetTokens());
+  } else if (!request.has_tokens) {
+    throw std::runtime_error("parse needs a source or tokens");
+  }
+  tokens.emplace_back(utils::STRING_ENDMARKER);
+
+  auto session = std::make_shared<Session>(Session{parser::LLParser(grammar->tables), false});
+  session->accepted = session->parser.Parse(tokens);
+
+  std::string id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    id = "s" + std::to_string(next_session_++);
+    sessions_.emplace(id, session);
+    session_order_.push_back(id);
+    while (sessions_.size() > options_.max_sessions && !session_order_.empty()) {
+      sessions_.erase(session_order_.front());
+      session_order_.pop_front();
+    }
+  }
+
+  const parser::ConcreteSyntaxTree &tree = session->parser.GetTree();
+  json.Key("session");
+  json.String(id);
+  json.Key("accepted");
+  json.Bool(session->accepted);
+  json.Key("steps");
+  json.Int(static_cast<int64_t>(session->parser.GetTraceSize()));
+  json.Key("nodes");
+  json.Int(static_cast<int64_t>(tree.Size()));
+  json.Key("root");
+  if (tree.Empty()) {
+    json.Null();
+  } else {
+    json.Int(tree.Root());
+  }
+}
+
+void Daemon::Trace(const Request &request, utils::JsonEmitter &json) {
+  std::shared_ptr<const Session> session = FindSession(request.session);
+  auto steps = static_cast<int64_t>(session->parser.GetTraceSize());
+  int64_t from = std::max<int64_t>(0, std::min(request.from, steps));
+  int64_t to = std::min(steps, from + std::max<int64_t>(0, request.count));
+
+  json.Key("steps");
+  json.Int(steps);
+  json.Key("entries");
+  json.BeginArray();
+  for (int64_t step = from; step < to; step++) {
+    parser::WriteTraceEntryJson(json, session->parser.GetTraceEntry(static_cast<size_t>(step)));
+  }
+  json.EndArray();
+}
+
+void Daemon::Tree(const Request &request, utils::JsonEmitter &json) {
+  std::shared_ptr<const Session> session = FindSession(request.session);
+  const parser::ConcreteSyntaxTree &tree = session->parser.GetTree();
+  if (tree.Empty()) {
+    throw std::runtime_error("session " + request.session + " has no tree");
+  }
+  parser::NodeId node = request.node < 0 ? tree.Root() : static_cast<parser::NodeId>(request.node);
+  if (request.node >= static_cast<int64_t>(tree.Size())) {
+    throw std::runtime_error("no node " + std::to_string(request.node));
+  }
+
+  std::ostringstream slice;
+  {
+    utils::OutputBuffer out(slice);
+    parser::TreeWriterOptions options;
+    options.compact = true;
+    parser::TreantWriter::WriteSlice(tree.GetSlice(node, static_cast<uint32_t>(std::max<int64_t>(0, request.depth))),
+                                     session->parser.GetSymbolNames(), out, options);
+  }
+  std::string text = slice.str();
+  while (!text.empty() && text.back() == '\n') {
+    text.pop_back();
+  }
+  json.Key("slice");
+  json.Raw(text);
+}
+
+void Daemon::Close(const Request &request, utils::JsonEmitter &json) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool closed = false;
+  if (!request.session.empty()) {
+    closed = sessions_.erase(request.session) != 0;
+    session_order_.erase(std::remove(session_order_.begin(), session_order_.end(), request.session),
+                         session_order_.end());
+  }
+  if (!request.grammar.empty() && grammars_.erase(request.grammar) != 0) {
+    closed = true;
+    for (auto it = grammar_by_content_.begin(); it != grammar_by_content_.end();) {
+      it = it->second == request.grammar ? grammar_by_content_.erase(it) : std::next(it);
+    }
+  }
+  // sessions of a closed grammar stay usable, their parsers keep the tables alive
+  json.Key("closed");
+  json.Bool(closed);
+}
+
+void Daemon::Shutdown(const Request & /*request*/, utils::JsonEmitter & /*json*/) {}
+
+size_t Daemon::Serve(std::istream &in, std::ostream &out) {
+  std::mutex out_mutex;
+  size_t served = 0;
+  utils::ThreadPool pool(options_.num_threads);
+  auto write = [&out, &out_mutex](const std::string &response) {
+    std::lock_guard<std::mutex> lock(out_mutex);
+    WriteFrame(out, response);
+  };
+
+  std::string payload;
+  while (ReadFrame(in, payload)) {
+    served++;
+    // the request is decoded here so that a shutdown stops reading right away
+    Request request;
+    try {
+      request = ParseRequest(payload);
+    } catch (const std::exception &e) {
+      write(ErrorResponse(nullptr, std::string("bad request: ") + e.what()));
+      continue;
+    }
+    if (request.op == "shutdown") {
+      pool.Wait();
+      write(Dispatch(request));
+      break;
+    }
+    pool.Submit([this, request = std::move(request), &write]() { write(Dispatch(request)); });
+  }
+  pool.Wait();
+  return served;
+}
+
+}  // namespace jucc::daemon
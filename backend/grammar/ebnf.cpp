@@ -0,0 +1,226 @@
+#include "grammar/ebnf.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace jucc::grammar {
+
+EbnfExpander::EbnfExpander(const std::unordered_set<std::string> &terminals,
+                           const std::unordered_set<std::string> &non_terminals)
+    : terminals_(terminals), non_terminals_(non_terminals) {}
+
+bool EbnfExpander::IsSymbol(const std::string &token) const {
+  return token == EPSILON || terminals_.count(token) != 0U || non_terminals_.count(token) != 0U;
+}
+
+bool EbnfExpander::Lex(const std::vector<std::string> &line, bool &plain) {
+  tokens_.clear();
+  plain = true;
+  for (const auto &token : line) {
+    if (IsSymbol(token)) {
+      tokens_.push_back({Kind::SYMBOL, token});
+      continue;
+    }
+    plain = false;
+    if (token == "(") {
+      tokens_.push_back({Kind::OPEN, ""});
+      continue;
+    }
+    if (token == "|") {
+      tokens_.push_back({Kind::BAR, ""});
+      continue;
+    }
+
+    // X*, )*, or a lone * after a separate operand
+    Kind op = Kind::SYMBOL;
+    switch (token.back()) {
+      case '*':
+        op = Kind::STAR;
+        break;
+      case '+':
+        op = Kind::PLUS;
+        break;
+      case '?':
+        op = Kind::OPTIONAL;
+        break;
+      default:
+        break;
+    }
+    std::string stem = op == Kind::SYMBOL ? token : token.substr(0, token.size() - 1);
+    if (stem == ")") {
+      tokens_.push_back({Kind::CLOSE, ""});
+    } else if (!stem.empty() && op != Kind::SYMBOL && IsSymbol(stem)) {
+      tokens_.push_back({Kind::SYMBOL, stem});
+    } else if (!stem.empty()) {
+      error_ = "grammar parsing error: undefined symbol: " + token;
+      return false;
+    }
+    if (op != Kind::SYMBOL) {
+      tokens_.push_back({op, ""});
+    }
+  }
+  return true;
+}
+
+bool EbnfExpander::ParseAlternatives(bool nested, Alternatives &alternatives) {
+  alternatives.emplace_back();
+  while (next_ < tokens_.size()) {
+    Kind kind = tokens_[next_].kind;
+    if (kind == Kind::CLOSE) {
+      if (!nested) {
+        error_ = "grammar parsing error: unbalanced ')' in a rule of " + parent_;
+        return false;
+      }
+      next_++;
+      return true;
+    }
+    if (kind == Kind::BAR) {
+      next_++;
+      alternatives.emplace_back();
+      continue;
+    }
+    if (!ParseItem(alternatives.back())) {
+      return false;
+    }
+  }
+  if (nested) {
+    error_ = "grammar parsing error: unbalanced '(' in a rule of " + parent_;
+    return false;
+  }
+  return true;
+}
+
+bool EbnfExpander::ParseItem(Sequence &sequence) {
+  // helpers of this item go before the ones its operand makes
+  size_t position = helpers_.size();
+  Alternatives operand;
+  const Token &token = tokens_[next_++];
+  if (token.kind == Kind::SYMBOL) {
+    operand.push_back({token.symbol});
+  } else if (token.kind == Kind::OPEN) {
+    if (!ParseAlternatives(true, operand)) {
+      return false;
+    }
+  } else {
+    error_ = "grammar parsing error: operator without operand in a rule of " + parent_;
+    return false;
+  }
+
+  Kind op = Kind::SYMBOL;
+  if (next_ < tokens_.size() &&
+      (tokens_[next_].kind == Kind::STAR || tokens_[next_].kind == Kind::PLUS ||
+       tokens_[next_].kind == Kind::OPTIONAL)) {
+    op = tokens_[next_++].kind;
+  }
+
+  if (op == Kind::OPTIONAL) {
+    sequence.push_back(MakeHelper(Kind::OPTIONAL, operand, position));
+    return true;
+  }
+  Sequence element = operand.size() == 1 ? operand[0] : Sequence{MakeHelper(Kind::OPEN, operand, position)};
+  if (op == Kind::SYMBOL) {
+    sequence.insert(sequence.end(), element.begin(), element.end());
+    return true;
+  }
+
+  if (MakeRule(element).GetEntities() == std::vector<std::string>{EPSILON}) {
+    error_ = "grammar parsing error: repetition of EPSILON in a rule of " + parent_;
+    return false;
+  }
+  std::string repetition = MakeHelper(Kind::STAR, Alternatives{element}, position);
+  if (op == Kind::PLUS) {
+    sequence.insert(sequence.end(), element.begin(), element.end());
+  }
+  sequence.push_back(repetition);
+  return true;
+}
+
+std::string EbnfExpander::MakeHelper(Kind kind, const Alternatives &operand, size_t position) {
+  std::string key(1, static_cast<char>('0' + static_cast<int>(kind)));
+  for (const auto &alternative : operand) {
+    key += '\n';
+    for (const auto &symbol : alternative) {
+      key += symbol;
+      key += ' ';
+    }
+  }
+  auto it = shared_.find(key);
+  if (it != shared_.end()) {
+    return it->second;
+  }
+
+  std::string name = NewName(kind == Kind::STAR ? "_rep" : kind == Kind::OPTIONAL ? "_opt" : "_grp");
+  if (kind == Kind::STAR) {
+    loops_.insert(name);
+  }
+  Rules rules;
+  auto add = [&](Rule rule) {
+    if (std::find_if(rules.begin(), rules.end(), [&](const Rule &other) {
+          return other.GetEntities() == rule.GetEntities();
+        }) == rules.end()) {
+      rules.push_back(std::move(rule));
+    }
+  };
+  for (const auto &alternative : operand) {
+    Sequence body = alternative;
+    if (kind == Kind::STAR) {
+      body.push_back(name);
+    }
+    add(MakeRule(std::move(body)));
+  }
+  if (kind != Kind::OPEN) {
+    add(Rule({EPSILON}));
+  }
+  helpers_.insert(helpers_.begin() + static_cast<std::ptrdiff_t>(position), Production(name, std::move(rules)));
+  shared_.emplace(std::move(key), name);
+  return name;
+}
+
+std::string EbnfExpander::NewName(const char *suffix) {
+  std::string base = parent_ + suffix;
+  std::string name = base;
+  for (int i = 1; IsSymbol(name) || names_.count(name) != 0U; i++) {
+    name = base + "_" + std::to_string(i);
+  }
+  names_.insert(name);
+  return name;
+}
+
+Rule EbnfExpander::MakeRule(Sequence sequence) {
+  // EPSILON only stands for the empty sequence
+  sequence.erase(std::remove(sequence.begin(), sequence.end(), std::string(EPSILON)), sequence.end());
+  if (sequence.empty()) {
+    sequence.emplace_back(EPSILON);
+  }
+  return Rule(std::move(sequence));
+}
+
+bool EbnfExpander::Expand(const std::string &parent, const std::vector<std::string> &line, Rules &rules) {
+  parent_ = parent;
+  bool plain = true;
+  if (!Lex(line, plain)) {
+    return false;
+  }
+  if (plain) {
+    rules.emplace_back(line);
+    return true;
+  }
+
+  next_ = 0;
+  Alternatives alternatives;
+  if (!ParseAlternatives(false, alternatives)) {
+    return false;
+  }
+  for (auto &alternative : alternatives) {
+    rules.push_back(MakeRule(std::move(alternative)));
+  }
+  return true;
+}
+
+Productions EbnfExpander::TakeHelpers() {
+  Productions helpers = std::move(helpers_);
+  helpers_.clear();
+  return helpers;
+}
+
+}  // namespace jucc::grammar
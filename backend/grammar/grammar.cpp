@@ -1,15 +1,193 @@
 #include "../include/grammar/grammar.h"
+#include "../include/grammar/ebnf.h"
+#include "../include/grammar/grammar_module.h"
 #include "../include/grammar/grammar_transform.h"
+#include "../include/grammar/grammar_reduction.h"
 #include "../include/json_writer.h"
+#include "../include/utils/utils.h"
 #include<bits/stdc++.h>
 #include <iostream>  
 #include <algorithm>
+#include <cstring>
+#include <filesystem>
 #include <sstream>
+#include <string_view>
 #include <unordered_map>
 #include <unordered_set>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JUCC_GRAMMAR_SSE2 1
+#endif
+
 namespace jucc::grammar {
 
+namespace {
+
+/**
+ * Whitespace as std::isspace has it in the C locale.
+ */
+bool IsBlank(char c) { return c == ' ' || static_cast<unsigned char>(c - '\t') <= '\r' - '\t'; }
+
+#ifdef JUCC_GRAMMAR_SSE2
+/**
+ * Bit i is set if data[i] is whitespace, for the 16 bytes at data.
+ */
+unsigned BlankMask(const char *data) {
+  const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+  // unsigned c - '\t' <= 4 is min(c - '\t', 4) == c - '\t'
+  const __m128i shifted = _mm_sub_epi8(chunk, _mm_set1_epi8('\t'));
+  __m128i blanks = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                                _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8('\r' - '\t')), shifted));
+  return static_cast<unsigned>(_mm_movemask_epi8(blanks));
+}
+
+unsigned TrailingZeros(unsigned mask) {
+#if defined(__GNUC__)
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+  unsigned count = 0;
+  while ((mask & 1U) == 0) {
+    mask >>= 1;
+    count++;
+  }
+  return count;
+#endif
+}
+#endif
+
+/**
+ * Appends the whitespace separated tokens of [begin, end) to tokens. With
+ * SSE2 every token boundary in 16 bytes comes out of one comparison.
+ */
+void SplitLine(const char *begin, const char *end, std::vector<std::string_view> &tokens) {
+  const char *token = nullptr;  // start of the token being read
+  const char *p = begin;
+#ifdef JUCC_GRAMMAR_SSE2
+  for (; end - p >= 16; p += 16) {
+    unsigned blanks = BlankMask(p);
+    // a boundary is a byte unlike the one before it, tokens start and end in turn
+    unsigned edges = (blanks ^ ((blanks << 1) | (token == nullptr ? 1U : 0U))) & 0xFFFFU;
+    while (edges != 0) {
+      const char *at = p + TrailingZeros(edges);
+      edges &= edges - 1;
+      if (token == nullptr) {
+        token = at;
+      } else {
+        tokens.emplace_back(token, static_cast<size_t>(at - token));
+        token = nullptr;
+      }
+    }
+  }
+#endif
+  for (; p < end; p++) {
+    if (!IsBlank(*p)) {
+      if (token == nullptr) {
+        token = p;
+      }
+    } else if (token != nullptr) {
+      tokens.emplace_back(token, static_cast<size_t>(p - token));
+      token = nullptr;
+    }
+  }
+  if (token != nullptr) {
+    tokens.emplace_back(token, static_cast<size_t>(end - token));
+  }
+}
+
+/**
+ * Reads what is left of input into text in one block.
+ */
+void ReadAll(std::istream &input, std::string &text) {
+  std::streampos begin = input.tellg();
+  if (begin != std::streampos(-1) && input.seekg(0, std::ios::end)) {
+    std::streamoff size = input.tellg() - begin;
+    input.seekg(begin);
+    if (size > 0) {
+      text.resize(static_cast<size_t>(size));
+      input.read(&text[0], size);
+      text.resize(static_cast<size_t>(input.gcount()));
+    }
+    return;
+  }
+  input.clear();
+  std::ostringstream buffer;
+  buffer << input.rdbuf();
+  text = buffer.str();
+}
+
+class SymbolTable {
+  /**
+   * Ids for the symbols of a grammar text, in the order they are first
+   * seen, found by FNV-1a in an open addressing table. Names are copied
+   * next to one another, a lookup touches the slot and one name.
+   */
+  struct Slot {
+    uint32_t hash;
+    uint32_t id;  // id + 1, 0 for an empty slot
+  };
+
+  std::string bytes_;                                 // every name back to back
+  std::vector<std::pair<uint32_t, uint32_t>> names_;  // offset and size in bytes_ per id
+  std::vector<uint8_t> kinds_;                        // Parser::Parse flags per id
+  std::vector<Slot> slots_;                           // linear probing, at most half full
+
+  static uint32_t Hash(std::string_view name) {
+    uint32_t hash = 2166136261U;
+    for (char c : name) {
+      hash = (hash ^ static_cast<unsigned char>(c)) * 16777619U;
+    }
+    return hash;
+  }
+
+  void Grow() {
+    std::vector<Slot> slots(2 * slots_.size(), Slot{0, 0});
+    auto mask = static_cast<uint32_t>(slots.size() - 1);
+    for (const auto &slot : slots_) {
+      if (slot.id != 0) {
+        uint32_t at = slot.hash & mask;
+        while (slots[at].id != 0) {
+          at = (at + 1) & mask;
+        }
+        slots[at] = slot;
+      }
+    }
+    slots_ = std::move(slots);
+  }
+
+ public:
+  SymbolTable() : slots_(1024, Slot{0, 0}) {}
+
+  uint32_t Intern(std::string_view name) {
+    uint32_t hash = Hash(name);
+    auto mask = static_cast<uint32_t>(slots_.size() - 1);
+    uint32_t at = hash & mask;
+    while (slots_[at].id != 0) {
+      if (slots_[at].hash == hash && Name(slots_[at].id - 1) == name) {
+        return slots_[at].id - 1;
+      }
+      at = (at + 1) & mask;
+    }
+    auto id = static_cast<uint32_t>(names_.size());
+    names_.emplace_back(static_cast<uint32_t>(bytes_.size()), static_cast<uint32_t>(name.size()));
+    bytes_.append(name);
+    kinds_.push_back(0);
+    slots_[at] = {hash, id + 1};
+    if (2 * names_.size() > slots_.size()) {
+      Grow();
+    }
+    return id;
+  }
+
+  [[nodiscard]] uint32_t Size() const { return static_cast<uint32_t>(names_.size()); }
+  [[nodiscard]] std::string_view Name(uint32_t id) const {
+    return std::string_view(bytes_).substr(names_[id].first, names_[id].second);
+  }
+  uint8_t &Kind(uint32_t id) { return kinds_[id]; }
+};
+
+}  // namespace
+
 bool HasParent(const grammar::Productions &productions, const std::string &parent) {
   return std::any_of(productions.begin(), productions.end(),
                      [&](const grammar::Production &prod) { return prod.GetParent() == parent; });
@@ -24,22 +202,18 @@ grammar::Rules GetRulesForParent(const grammar::Productions &productions, const
   return grammar::Rules();
 }
 
-Parser::Parser(const char *filepath) { file_ = std::ifstream(filepath); }
-
-Parser::~Parser() {
+Parser::Parser(const char *filepath) {
+  file_ = std::ifstream(filepath, std::ios::binary);
   if (file_.is_open()) {
-    file_.close();
+    input_ = &file_;
   }
+  base_dir_ = std::filesystem::path(filepath).parent_path().string();
 }
 
-std::vector<std::string> Parser::FastTokenize(const std::string &s) {
-  std::vector<std::string> res;
-  std::stringstream ss(s);
-  std::string token;
-  while (ss >> token) {
-    res.push_back(token);
+Parser::~Parser() {
+  if (file_.is_open()) {
+    file_.close();
   }
-  return res;
 }
 
 /**
@@ -49,39 +223,89 @@ std::vector<std::string> Parser::FastTokenize(const std::string &s) {
  * a % block closing token.
  * RuleState keeps track of additonal states required to parse a rule inside of a
  * %rule block.
+ *
+ * The text is read in one block and split in place; symbols are interned as
+ * they are read and rules kept as symbol ids until the productions are built,
+ * so a large grammar costs one string per entity of the result.
  */
 bool Parser::Parse() {
   enum ParseState { BASIC, TERMINALS, NON_TERMINALS, START, RULES };
   enum RuleState { LEFT, COLON, ENTITY };
-
-  if (!file_.is_open()) {
+  enum SymbolKind : uint8_t {
+    TERMINAL = 1,
+    NON_TERMINAL = 2,
+    IMPORTED_TERMINAL = 4,
+    IMPORTED_NON_TERMINAL = 8,
+    VISIBLE = TERMINAL | NON_TERMINAL | IMPORTED_TERMINAL | IMPORTED_NON_TERMINAL,
+  };
+  struct PendingRule {
+    uint32_t group;  // index of the parent in parents
+    uint32_t begin;  // of its symbols in entities
+    uint32_t end;
+  };
+
+  if (input_ == nullptr) {
     error_ = "grammar parsing error: file not found";
     return false;
   }
 
-    ParseState curr_parse_state = BASIC;
-    std::string line;
-    std::unordered_map<std::string, std::vector<std::vector<std::string>>> grammar;
+  std::string text;
+  ReadAll(*input_, text);
 
-      std::string production_parent;
-      std::vector<std::string> rule_entities;
+  SymbolTable symbols;
+  const uint32_t epsilon = symbols.Intern(EPSILON);
+  ParseState curr_parse_state = BASIC;
   RuleState curr_rule_state = LEFT;
+  bool duplicate_terminals = false;
+  bool duplicate_non_terminals = false;
+  std::vector<uint32_t> declared_non_terminals;
+  std::vector<std::string> import_paths;
+
+  // rules per parent, parents in the order their first rule appears so the
+  // productions (and everything derived from them) do not depend on hashing
+  std::vector<uint32_t> parents;
+  std::vector<uint32_t> group_of;  // index in parents by symbol id, UINT32_MAX if none yet
+  std::vector<PendingRule> rules;
+  std::vector<uint32_t> entities;  // of every rule back to back, then of the one being read
+  uint32_t production_parent = 0;
+  size_t rule_begin = 0;
+  auto add_rule = [&]() {
+    if (group_of.size() <= production_parent) {
+      group_of.resize(production_parent + 1, UINT32_MAX);
+    }
+    if (group_of[production_parent] == UINT32_MAX) {
+      group_of[production_parent] = static_cast<uint32_t>(parents.size());
+      parents.push_back(production_parent);
+    }
+    rules.push_back({group_of[production_parent], static_cast<uint32_t>(rule_begin),
+                     static_cast<uint32_t>(entities.size())});
+    rule_begin = entities.size();
+  };
+
+  std::vector<std::string_view> tokens;
+  const char *next = text.data();
+  const char *text_end = next + text.size();
+  while (next < text_end) {
+    const char *line = next;
+    const auto *line_end = static_cast<const char *>(std::memchr(line, '\n', static_cast<size_t>(text_end - line)));
+    if (line_end == nullptr) {
+      line_end = text_end;
+    }
+    next = line_end == text_end ? text_end : line_end + 1;
 
-  while (getline(file_, line)) {
     // Skip empty lines and comments
-    if (line.empty() || line[0] == '#') {
-        continue;
-      }
-    
-      std::vector<std::string> tokens = FastTokenize(line);
+    if (line == line_end || line[0] == '#') {
+      continue;
+    }
+    tokens.clear();
+    SplitLine(line, line_end, tokens);
     if (tokens.empty()) continue;
 
     // Handle section markers
     if (tokens[0][0] == '%') {
       if (tokens[0] == "%end") {
-        if (curr_parse_state == RULES && !rule_entities.empty()) {
-          grammar[production_parent].push_back(rule_entities);
-          rule_entities.clear();
+        if (curr_parse_state == RULES && entities.size() != rule_begin) {
+          add_rule();
         }
         curr_parse_state = BASIC;
       } else if (tokens[0] == "%terminals") {
@@ -93,132 +317,221 @@ bool Parser::Parse() {
       } else if (tokens[0] == "%rules") {
         curr_parse_state = RULES;
         curr_rule_state = LEFT;
-      } else {
-        error_ = "grammar parsing error: invalid section marker: " + tokens[0];
+      } else if (tokens[0] == "%import") {
+        if (curr_parse_state != BASIC || tokens.size() != 2) {
+          error_ = "grammar parsing error: %import expects one path outside sections";
           return false;
         }
+        import_paths.push_back(ResolveImport(base_dir_, std::string(tokens[1])));
+      } else {
+        error_ = "grammar parsing error: invalid section marker: " + std::string(tokens[0]);
+        return false;
+      }
       continue;
     }
 
     // Process tokens based on current state
     if (curr_parse_state == BASIC) {
-      error_ = "grammar parsing error: token outside section: " + tokens[0];
+      error_ = "grammar parsing error: token outside section: " + std::string(tokens[0]);
       return false;
     }
 
-      for (const auto &token : tokens) {
-        switch (curr_parse_state) {
-          case TERMINALS:
-            if (token == std::string(EPSILON)) {
-              error_ = "grammar parsing error: EPSILON is reserved";
-              return false;
-            }
-          std::cout << "Adding terminal: '" << token << "'" << std::endl;
-            terminals_.push_back(token);
-            break;
-
-          case NON_TERMINALS:
-            if (token == std::string(EPSILON)) {
-              error_ = "grammar parsing error: EPSILON is reserved";
-              return false;
-            }
-            non_terminals_.push_back(token);
-            break;
+    for (const auto &token : tokens) {
+      uint32_t symbol = symbols.Intern(token);
+      switch (curr_parse_state) {
+        case TERMINALS:
+          if (symbol == epsilon) {
+            error_ = "grammar parsing error: EPSILON is reserved";
+            return false;
+          }
+          if (log_ != nullptr) {
+            *log_ << "Adding terminal: '" << token << "'\n";
+          }
+          duplicate_terminals |= (symbols.Kind(symbol) & TERMINAL) != 0;
+          symbols.Kind(symbol) |= TERMINAL;
+          terminals_.emplace_back(token);
+          break;
+
+        case NON_TERMINALS:
+          if (symbol == epsilon) {
+            error_ = "grammar parsing error: EPSILON is reserved";
+            return false;
+          }
+          duplicate_non_terminals |= (symbols.Kind(symbol) & NON_TERMINAL) != 0;
+          symbols.Kind(symbol) |= NON_TERMINAL;
+          declared_non_terminals.push_back(symbol);
+          non_terminals_.emplace_back(token);
+          break;
 
-          case START:
+        case START:
           if (!start_symbol_.empty()) {
-              error_ = "grammar parsing error: ambiguous start symbol";
-              return false;
-            }
-            start_symbol_ = token;
-            break;
-
-          case RULES:
-            switch (curr_rule_state) {
-              case LEFT:
-                if (token == std::string(EPSILON)) {
-                  error_ = "grammar parsing error: production cannot start with EPSILON";
-                  return false;
-                }
-                production_parent = token;
-                curr_rule_state = COLON;
-                break;
-
-              case COLON:
-                if (token != ":") {
-                  error_ = "grammar parsing error: rules syntax error ':' expected: " + token;
-                  return false;
-                }
-                curr_rule_state = ENTITY;
-                break;
-
-              case ENTITY:
-                rule_entities.push_back(token);
-                break;
-            }
-            break;
+            error_ = "grammar parsing error: ambiguous start symbol";
+            return false;
+          }
+          start_symbol_ = std::string(token);
+          break;
+
+        case RULES:
+          switch (curr_rule_state) {
+            case LEFT:
+              if (symbol == epsilon) {
+                error_ = "grammar parsing error: production cannot start with EPSILON";
+                return false;
+              }
+              production_parent = symbol;
+              curr_rule_state = COLON;
+              break;
+
+            case COLON:
+              if (token != ":") {
+                error_ = "grammar parsing error: rules syntax error ':' expected: " + std::string(token);
+                return false;
+              }
+              curr_rule_state = ENTITY;
+              break;
+
+            case ENTITY:
+              entities.push_back(symbol);
+              break;
+          }
+          break;
 
         case BASIC:
-          error_ = "grammar parsing error: invalid token outside block: " + token;
+          error_ = "grammar parsing error: invalid token outside block: " + std::string(token);
           return false;
-        }
+      }
     }
 
     // Handle end of rule line
-    if (curr_parse_state == RULES && curr_rule_state == ENTITY && !rule_entities.empty()) {
-      grammar[production_parent].push_back(rule_entities);
-      rule_entities.clear();
+    if (curr_parse_state == RULES && curr_rule_state == ENTITY && entities.size() != rule_begin) {
+      add_rule();
       curr_rule_state = LEFT;
     }
   }
 
   // Validate grammar
-  std::unordered_set<std::string> terminals(terminals_.begin(), terminals_.end());
-  std::unordered_set<std::string> non_terminals(non_terminals_.begin(), non_terminals_.end());
-
-    if (terminals.size() != terminals_.size()) {
+  if (duplicate_terminals) {
     error_ = "grammar parsing error: duplicate terminals";
-      return false;
-    }
+    return false;
+  }
 
-  if (non_terminals.size() != non_terminals_.size()) {
+  if (duplicate_non_terminals) {
     error_ = "grammar parsing error: duplicate non-terminals";
-        return false;
-    }
+    return false;
+  }
 
-  for (const auto& nt : non_terminals) {
-    if (terminals.find(nt) != terminals.end()) {
-      error_ = "grammar parsing error: symbol '" + nt + "' cannot be both terminal and non-terminal";
+  for (uint32_t nt : declared_non_terminals) {
+    if ((symbols.Kind(nt) & TERMINAL) != 0) {
+      error_ = "grammar parsing error: symbol '" + std::string(symbols.Name(nt)) +
+               "' cannot be both terminal and non-terminal";
       return false;
     }
   }
 
-  // Convert grammar to Productions
-  for (const auto& entry : grammar) {
-    const std::string& parent = entry.first;
-    const auto& rules = entry.second;
-    
-    if (non_terminals.find(parent) == non_terminals.end()) {
-        error_ = "grammar parsing error: undefined non-terminal: " + parent;
+  // Symbols of the imported modules can be used but not defined again
+  if (!LoadImports(import_paths)) {
+    return false;
+  }
+  for (const auto& module : imports_) {
+    for (const auto& nt : module->non_terminals) {
+      uint8_t &kind = symbols.Kind(symbols.Intern(nt));
+      if ((kind & NON_TERMINAL) != 0) {
+        error_ = "grammar parsing error: non-terminal '" + nt + "' is already defined in " + module->path;
+        return false;
+      }
+      if ((kind & TERMINAL) != 0) {
+        error_ = "grammar parsing error: symbol '" + nt + "' cannot be both terminal and non-terminal";
+        return false;
+      }
+      kind |= IMPORTED_NON_TERMINAL;
+    }
+    for (const auto& term : module->terminals) {
+      uint8_t &kind = symbols.Kind(symbols.Intern(term));
+      if ((kind & NON_TERMINAL) != 0) {
+        error_ = "grammar parsing error: symbol '" + term + "' cannot be both terminal and non-terminal";
         return false;
       }
+      kind |= IMPORTED_TERMINAL;
+    }
+  }
+
+  // Rules of a parent in the order they were read
+  std::vector<uint32_t> group_end(parents.size() + 1, 0);
+  for (const auto& rule : rules) {
+    group_end[rule.group + 1]++;
+  }
+  for (size_t group = 0; group < parents.size(); group++) {
+    group_end[group + 1] += group_end[group];
+  }
+  std::vector<uint32_t> order(rules.size());
+  std::vector<uint32_t> filled(group_end.begin(), group_end.end() - 1);
+  for (uint32_t rule = 0; rule < rules.size(); rule++) {
+    order[filled[rules[rule].group]++] = rule;
+  }
+
+  // Convert grammar to Productions, expanding EBNF operators. Lines that
+  // only name symbols are taken as they are; the expander and the symbol
+  // sets it works on are only made for the first line that needs them.
+  std::unordered_set<std::string> visible_terminals;
+  std::unordered_set<std::string> visible_non_terminals;
+  std::unique_ptr<EbnfExpander> ebnf;
+  grammar_.reserve(parents.size());
+  for (size_t group = 0; group < parents.size(); group++) {
+    uint32_t parent_symbol = parents[group];
+    if ((symbols.Kind(parent_symbol) & NON_TERMINAL) == 0) {
+      error_ = "grammar parsing error: undefined non-terminal: " + std::string(symbols.Name(parent_symbol));
+      return false;
+    }
+    std::string parent(symbols.Name(parent_symbol));
 
     Rules prod_rules;
-    for (const auto& rule : rules) {
-        for (const auto& symbol : rule) {
-            if (symbol != EPSILON && 
-                terminals.find(symbol) == terminals.end() && 
-                non_terminals.find(symbol) == non_terminals.end()) {
-                error_ = "grammar parsing error: undefined symbol: " + symbol;
-            return false;
+    prod_rules.reserve(group_end[group + 1] - group_end[group]);
+    for (uint32_t i = group_end[group]; i < group_end[group + 1]; i++) {
+      const PendingRule& rule = rules[order[i]];
+      std::vector<std::string> line;
+      line.reserve(rule.end - rule.begin);
+      bool plain = true;
+      for (uint32_t at = rule.begin; at < rule.end; at++) {
+        line.emplace_back(symbols.Name(entities[at]));
+        plain = plain && (entities[at] == epsilon || (symbols.Kind(entities[at]) & VISIBLE) != 0);
+      }
+      if (plain) {
+        prod_rules.emplace_back(std::move(line));
+        continue;
+      }
+
+      if (!ebnf) {
+        for (uint32_t symbol = 0; symbol < symbols.Size(); symbol++) {
+          if ((symbols.Kind(symbol) & (TERMINAL | IMPORTED_TERMINAL)) != 0) {
+            visible_terminals.emplace(symbols.Name(symbol));
+          }
+          if ((symbols.Kind(symbol) & (NON_TERMINAL | IMPORTED_NON_TERMINAL)) != 0) {
+            visible_non_terminals.emplace(symbols.Name(symbol));
           }
         }
-        prod_rules.push_back(Rule(rule));
+        ebnf = std::make_unique<EbnfExpander>(visible_terminals, visible_non_terminals);
+      }
+      if (!ebnf->Expand(parent, line, prod_rules)) {
+        error_ = ebnf->GetError();
+        return false;
+      }
     }
-    grammar_.push_back(Production(parent, prod_rules));
+    grammar_.emplace_back(std::move(parent), std::move(prod_rules));
+
+    // Helpers for the EBNF operators follow the production they came from
+    if (ebnf) {
+      for (auto& helper : ebnf->TakeHelpers()) {
+        non_terminals_.push_back(helper.GetParent());
+        generated_.helpers.push_back(helper.GetParent());
+        if (ebnf->IsLoop(helper.GetParent())) {
+          generated_.loops.push_back(helper.GetParent());
+        }
+        grammar_.push_back(std::move(helper));
+      }
     }
+  }
 
-    return true;
+  return true;
 }
 
 std::string Rule::ToString() const {
@@ -239,11 +552,124 @@ bool Rule::HasPrefix(const Rule& prefix) const {
     return std::equal(prefix_entities.begin(), prefix_entities.end(), entities_.begin());
   }
 
-void Parser::DumpGrammarAsJson(const std::string &filepath) {
+bool Parser::LoadImports(const std::vector<std::string> &paths) {
+    imports_.clear();
+    std::unordered_set<const GrammarModule*> listed;
+    auto add = [&](const std::shared_ptr<const GrammarModule>& module) {
+        if (listed.insert(module.get()).second) {
+            imports_.push_back(module);
+        }
+    };
+    for (const auto& path : paths) {
+        std::string error;
+        auto module = ModuleCache::Shared().Load(path, error);
+        if (!module) {
+            error_ = error;
+            return false;
+        }
+        add(module);
+        for (const auto& used : module->imports) {
+            add(used);
+        }
+    }
+
+    // Two modules defining the same non-terminal can not both be used
+    std::unordered_map<std::string, const std::string*> defined_in;
+    for (const auto& module : imports_) {
+        for (const auto& nt : module->non_terminals) {
+            auto inserted = defined_in.emplace(nt, &module->path);
+            if (!inserted.second) {
+                error_ = "grammar parsing error: non-terminal '" + nt + "' is defined in both " +
+                         *inserted.first->second + " and " + module->path;
+                return false;
+            }
+        }
+    }
+    for (const auto& module : imports_) {
+        for (const auto& term : module->terminals) {
+            if (defined_in.find(term) != defined_in.end()) {
+                error_ = "grammar parsing error: symbol '" + term + "' cannot be both terminal and non-terminal";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool Parser::CheckImportClashes(const std::string& stage) {
+    if (imports_.empty()) {
+        return true;
+    }
+    std::unordered_set<std::string> imported;
+    for (const auto& module : imports_) {
+        imported.insert(module->non_terminals.begin(), module->non_terminals.end());
+        imported.insert(module->terminals.begin(), module->terminals.end());
+    }
+    for (const auto& prod : grammar_) {
+        if (imported.find(prod.GetParent()) != imported.end()) {
+            error_ = "Error during " + stage + ": new non-terminal '" + prod.GetParent() +
+                     "' clashes with an imported symbol";
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::string> Parser::GetTerminals() {
+    if (imports_.empty()) {
+        return terminals_;
+    }
+    std::vector<std::string> terminals = terminals_;
+    std::unordered_set<std::string> listed(terminals_.begin(), terminals_.end());
+    for (const auto& module : imports_) {
+        for (const auto& term : module->terminals) {
+            if (listed.insert(term).second) {
+                terminals.push_back(term);
+            }
+        }
+    }
+    return terminals;
+}
+
+std::vector<std::string> Parser::GetNonTerminals() {
+    std::vector<std::string> non_terminals = non_terminals_;
+    for (const auto& module : imports_) {
+        non_terminals.insert(non_terminals.end(), module->non_terminals.begin(), module->non_terminals.end());
+    }
+    return non_terminals;
+}
+
+Productions Parser::GetProductions() {
+    Productions productions = grammar_;
+    for (const auto& module : imports_) {
+        productions.insert(productions.end(), module->productions.begin(), module->productions.end());
+    }
+    return productions;
+}
+
+GeneratedSymbols Parser::GetGenerated() {
+    GeneratedSymbols generated = generated_;
+    for (const auto& module : imports_) {
+        generated.helpers.insert(generated.helpers.end(), module->generated.helpers.begin(),
+                                 module->generated.helpers.end());
+        generated.loops.insert(generated.loops.end(), module->generated.loops.begin(),
+                               module->generated.loops.end());
+    }
+    return generated;
+}
+
+void Parser::DumpGrammarAsJson(const std::string &filepath, bool compact) {
+    grammar::DumpGrammarAsJson(GetTerminals(), GetNonTerminals(), start_symbol_, GetProductions(), GetGenerated(),
+                               filepath, compact);
+}
+
+void DumpGrammarAsJson(const std::vector<std::string> &terminals, const std::vector<std::string> &non_terminals,
+                       const std::string &start_symbol, const Productions &productions,
+                       const GeneratedSymbols &generated, const std::string &filepath, bool compact) {
     std::vector<std::pair<std::string, std::vector<std::vector<std::string>>>> productions_data;
     
     // Convert productions to the format expected by JsonWriter
-    for (const auto& prod : grammar_) {
+    for (const auto& prod : productions) {
         std::vector<std::vector<std::string>> rules_data;
         for (const auto& rule : prod.GetRules()) {
             rules_data.push_back(rule.GetEntities());
@@ -253,15 +679,17 @@ void Parser::DumpGrammarAsJson(const std::string &filepath) {
 
     // Write to JSON using our JsonWriter
     JsonWriter::WriteGrammarToJson(
-        terminals_,
-        non_terminals_,
-        start_symbol_,
+        terminals,
+        non_terminals,
+        start_symbol,
         productions_data,
-        filepath
+        generated,
+        filepath,
+        compact
     );
 }
 
-void DumpGrammarAsJson(const Productions &productions, const std::string &filepath) {
+void DumpGrammarAsJson(const Productions &productions, const std::string &filepath, bool compact) {
     std::vector<std::pair<std::string, std::vector<std::vector<std::string>>>> productions_data;
     
     // Convert productions to the format expected by JsonWriter
@@ -279,42 +707,88 @@ void DumpGrammarAsJson(const Productions &productions, const std::string &filepa
         std::vector<std::string>(),  // empty non-terminals
         "",                          // empty start symbol
         productions_data,
-        filepath
+        GeneratedSymbols(),          // nothing marked as generated
+        filepath,
+        compact
     );
 }
 
+bool Parser::Reduce(unsigned reductions, ReductionReport* report) {
+    try {
+        grammar_ = ReduceGrammar(grammar_, start_symbol_, reductions, report);
+
+        // Drop the non-terminals that are gone
+        std::unordered_set<std::string> parents;
+        for (const auto& prod : grammar_) {
+            parents.insert(prod.GetParent());
+        }
+        auto gone = [&](const std::string& non_terminal) { return parents.find(non_terminal) == parents.end(); };
+        non_terminals_.erase(std::remove_if(non_terminals_.begin(), non_terminals_.end(), gone), non_terminals_.end());
+        generated_.helpers.erase(std::remove_if(generated_.helpers.begin(), generated_.helpers.end(), gone),
+                                 generated_.helpers.end());
+        generated_.loops.erase(std::remove_if(generated_.loops.begin(), generated_.loops.end(), gone),
+                               generated_.loops.end());
+        return true;
+    } catch (const std::exception& e) {
+        error_ = "Error during grammar reduction: " + std::string(e.what());
+        return false;
+    }
+}
+
 bool Parser::EliminateLeftRecursion() {
     try {
         grammar_ = GrammarTransform::EliminateLeftRecursion(grammar_);
-        
+
         // Update non-terminals list with new ones
         std::unordered_set<std::string> non_term_set(non_terminals_.begin(), non_terminals_.end());
         for (const auto& prod : grammar_) {
             if (non_term_set.find(prod.GetParent()) == non_term_set.end()) {
                 non_terminals_.push_back(prod.GetParent());
+                generated_.helpers.push_back(prod.GetParent());
                 non_term_set.insert(prod.GetParent());
             }
         }
-        return true;
+        return CheckImportClashes("left recursion elimination");
     } catch (const std::exception& e) {
         error_ = "Error during left recursion elimination: " + std::string(e.what());
         return false;
     }
 }
 
-bool Parser::ApplyLeftFactoring() {
+bool Parser::RemoveAllPossibleAmbiguity(utils::ThreadPool* pool, utils::LeftRecursionReport* report) {
+    try {
+        grammar_ = utils::RemoveAllPossibleAmbiguity(grammar_, pool, report);
+
+        // Update non-terminals list with new ones
+        std::unordered_set<std::string> non_term_set(non_terminals_.begin(), non_terminals_.end());
+        for (const auto& prod : grammar_) {
+            if (non_term_set.find(prod.GetParent()) == non_term_set.end()) {
+                non_terminals_.push_back(prod.GetParent());
+                generated_.helpers.push_back(prod.GetParent());
+                non_term_set.insert(prod.GetParent());
+            }
+        }
+        return CheckImportClashes("ambiguity removal");
+    } catch (const std::exception& e) {
+        error_ = "Error during ambiguity removal: " + std::string(e.what());
+        return false;
+    }
+}
+
+bool Parser::ApplyLeftFactoring(utils::ThreadPool* pool) {
     try {
-        grammar_ = GrammarTransform::ApplyLeftFactoring(grammar_);
-        
+        grammar_ = GrammarTransform::ApplyLeftFactoring(grammar_, pool);
+
         // Update non-terminals list with new ones
         std::unordered_set<std::string> non_term_set(non_terminals_.begin(), non_terminals_.end());
         for (const auto& prod : grammar_) {
             if (non_term_set.find(prod.GetParent()) == non_term_set.end()) {
                 non_terminals_.push_back(prod.GetParent());
+                generated_.helpers.push_back(prod.GetParent());
                 non_term_set.insert(prod.GetParent());
 }
         }
-        return true;
+        return CheckImportClashes("left factoring");
     } catch (const std::exception& e) {
         error_ = "Error during left factoring: " + std::string(e.what());
         return false;
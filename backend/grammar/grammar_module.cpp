@@ -0,0 +1,144 @@
+#include "grammar/grammar_module.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace jucc::grammar {
+
+namespace {
+
+// modules being compiled by this thread, innermost last
+thread_local std::vector<std::string> loading;
+
+}  // namespace
+
+std::string ResolveImport(const std::string &base_dir, const std::string &path) {
+  std::filesystem::path resolved(path);
+  if (resolved.is_relative() && !base_dir.empty()) {
+    resolved = std::filesystem::path(base_dir) / resolved;
+  }
+  // one entry per file however it is spelled
+  std::error_code error;
+  std::filesystem::path absolute = std::filesystem::absolute(resolved, error);
+  return (error ? resolved : absolute).lexically_normal().string();
+}
+
+void CalcModuleSummary(const Productions &productions, const GrammarModules &imports,
+                       std::unordered_map<std::string, bool> &nullables, utils::SymbolsMap &firsts) {
+  std::unordered_map<std::string, bool> known_nullables;
+  utils::SymbolsMap known_firsts;
+  for (const auto &module : imports) {
+    known_nullables.insert(module->nullables.begin(), module->nullables.end());
+    known_firsts.insert(module->firsts.begin(), module->firsts.end());
+  }
+
+  Productions emptied = productions;
+  for (auto &prod : emptied) {
+    Rules rules = prod.GetRules();
+    for (auto &rule : rules) {
+      const auto &entities = rule.GetEntities();
+      if (entities.size() == 1 && entities[0] == std::string(EPSILON)) {
+        rule.SetEntities({});
+      }
+    }
+    prod.SetRules(rules);
+  }
+
+  nullables = utils::CalcNullables(emptied, &known_nullables);
+  firsts = utils::CalcFirsts(emptied, nullables, &known_firsts);
+  for (const auto &entry : known_nullables) {
+    nullables.erase(entry.first);
+  }
+}
+
+std::shared_ptr<const GrammarModule> Parser::MakeModule(const std::string &path) {
+  auto module = std::make_shared<GrammarModule>();
+  module->path = path;
+  module->terminals = terminals_;
+  module->non_terminals = non_terminals_;
+  module->productions = grammar_;
+  module->generated = generated_;
+  module->imports = imports_;
+  CalcModuleSummary(grammar_, imports_, module->nullables, module->firsts);
+  return module;
+}
+
+ModuleCache &ModuleCache::Shared() {
+  static ModuleCache cache;
+  return cache;
+}
+
+std::shared_ptr<const GrammarModule> ModuleCache::Load(const std::string &path, std::string &error) {
+  if (std::find(loading.begin(), loading.end(), path) != loading.end()) {
+    error = "grammar parsing error: import cycle through " + path;
+    return nullptr;
+  }
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    error = "grammar parsing error: module not found: " + path;
+    return nullptr;
+  }
+  std::ostringstream buffer;
+  buffer << file.rdbuf();
+  std::string text = buffer.str();
+
+  std::shared_ptr<const GrammarModule> cached;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = modules_.find(path);
+    if (it != modules_.end() && it->second.text == text) {
+      cached = it->second.module;
+    }
+  }
+  if (cached) {
+    bool current = true;
+    for (const auto &used : cached->imports) {
+      auto again = Load(used->path, error);
+      if (!again) {
+        return nullptr;
+      }
+      if (again != used) {
+        current = false;
+        break;
+      }
+    }
+    if (current) {
+      return cached;
+    }
+  }
+
+  loading.push_back(path);
+  std::istringstream input(text);
+  Parser parser(input, std::filesystem::path(path).parent_path().string());
+  bool compiled = parser.Parse() && parser.EliminateLeftRecursion() && parser.ApplyLeftFactoring();
+  loading.pop_back();
+  if (!compiled) {
+    // name the innermost module only
+    error = parser.GetError();
+    if (error.find(" (in module ") == std::string::npos) {
+      error += " (in module " + path + ")";
+    }
+    return nullptr;
+  }
+
+  auto module = parser.MakeModule(path);
+  std::lock_guard<std::mutex> lock(mutex_);
+  modules_[path] = {std::move(text), module};
+  compiles_++;
+  return module;
+}
+
+size_t ModuleCache::GetCompiles() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return compiles_;
+}
+
+void ModuleCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  modules_.clear();
+  compiles_ = 0;
+}
+
+}  // namespace jucc::grammar
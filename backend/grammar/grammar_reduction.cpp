@@ -0,0 +1,357 @@
+#include "grammar/grammar_reduction.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace jucc::grammar {
+
+namespace {
+
+using Index = std::unordered_map<std::string, size_t>;
+
+Index ParentIndex(const Productions &productions) {
+  Index index;
+  for (size_t i = 0; i < productions.size(); i++) {
+    index.emplace(productions[i].GetParent(), i);
+  }
+  return index;
+}
+
+bool IsEpsilonRule(const Rule &rule) {
+  const auto &entities = rule.GetEntities();
+  return entities.size() == 1 && entities[0] == std::string(EPSILON);
+}
+
+// identifies a rule among the rules of one production
+std::string RuleKey(const std::vector<std::string> &entities) {
+  std::string key;
+  for (const auto &entity : entities) {
+    key += entity;
+    key += '\x1f';
+  }
+  return key;
+}
+
+/**
+ * Keeps the productions whose parent is in keep, dropping from them every
+ * rule that uses a non terminal not in keep.
+ */
+Productions Restrict(const Productions &productions, const Index &index, const std::vector<bool> &keep) {
+  Productions kept;
+  for (size_t i = 0; i < productions.size(); i++) {
+    if (!keep[i]) {
+      continue;
+    }
+    Rules rules;
+    for (const auto &rule : productions[i].GetRules()) {
+      bool usable = std::all_of(rule.GetEntities().begin(), rule.GetEntities().end(), [&](const std::string &entity) {
+        auto it = index.find(entity);
+        return it == index.end() || keep[it->second];
+      });
+      if (usable) {
+        rules.push_back(rule);
+      }
+    }
+    kept.emplace_back(productions[i].GetParent(), std::move(rules));
+  }
+  return kept;
+}
+
+std::vector<bool> Nullables(const Productions &productions, const Index &index) {
+  std::vector<bool> nullable(productions.size(), false);
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 0; i < productions.size(); i++) {
+      if (nullable[i]) {
+        continue;
+      }
+      for (const auto &rule : productions[i].GetRules()) {
+        bool empty = IsEpsilonRule(rule) ||
+                     std::all_of(rule.GetEntities().begin(), rule.GetEntities().end(), [&](const std::string &entity) {
+                       auto it = index.find(entity);
+                       return it != index.end() && nullable[it->second];
+                     });
+        if (empty) {
+          nullable[i] = true;
+          changed = true;
+          break;
+        }
+      }
+    }
+  }
+  return nullable;
+}
+
+}  // namespace
+
+unsigned ReductionFromName(const std::string &name) {
+  if (name == "useless") {
+    return REDUCE_USELESS;
+  }
+  if (name == "units") {
+    return REDUCE_UNIT_RULES;
+  }
+  if (name == "duplicates") {
+    return REDUCE_DUPLICATES;
+  }
+  if (name == "all") {
+    return REDUCE_ALL;
+  }
+  return REDUCE_NONE;
+}
+
+Productions RemoveUselessSymbols(const Productions &productions, const std::string &start_symbol,
+                                 ReductionReport *report) {
+  Index index = ParentIndex(productions);
+
+  // productive: every rule counts the non terminals it still waits for, a
+  // rule reaching 0 makes its parent productive
+  struct RuleRef {
+    size_t production;
+    size_t rule;
+  };
+  std::vector<std::vector<size_t>> waiting(productions.size());
+  std::unordered_map<size_t, std::vector<RuleRef>> users;
+  std::vector<bool> productive(productions.size(), false);
+  std::vector<size_t> queue;
+  for (size_t i = 0; i < productions.size(); i++) {
+    const auto &rules = productions[i].GetRules();
+    waiting[i].assign(rules.size(), 0);
+    for (size_t r = 0; r < rules.size(); r++) {
+      for (const auto &entity : rules[r].GetEntities()) {
+        auto it = index.find(entity);
+        if (it != index.end()) {
+          waiting[i][r]++;
+          users[it->second].push_back({i, r});
+        }
+      }
+      if (waiting[i][r] == 0 && !productive[i]) {
+        productive[i] = true;
+        queue.push_back(i);
+      }
+    }
+  }
+  while (!queue.empty()) {
+    size_t done = queue.back();
+    queue.pop_back();
+    for (const auto &user : users[done]) {
+      if (--waiting[user.production][user.rule] == 0 && !productive[user.production]) {
+        productive[user.production] = true;
+        queue.push_back(user.production);
+      }
+    }
+  }
+
+  auto start = index.find(start_symbol);
+  for (size_t i = 0; i < productions.size() && report != nullptr; i++) {
+    // a start symbol deriving nothing is kept, and found again by a later run
+    const std::string &parent = productions[i].GetParent();
+    if (!productive[i] &&
+        std::find(report->unproductive.begin(), report->unproductive.end(), parent) == report->unproductive.end()) {
+      report->unproductive.push_back(parent);
+    }
+  }
+  if (start != index.end()) {
+    productive[start->second] = true;
+  }
+  Productions reduced = Restrict(productions, index, productive);
+
+  // reachable from the start symbol over the rules that are left
+  index = ParentIndex(reduced);
+  std::vector<bool> reachable(reduced.size(), false);
+  start = index.find(start_symbol);
+  if (start != index.end()) {
+    reachable[start->second] = true;
+    queue.assign(1, start->second);
+  }
+  while (!queue.empty()) {
+    size_t at = queue.back();
+    queue.pop_back();
+    for (const auto &rule : reduced[at].GetRules()) {
+      for (const auto &entity : rule.GetEntities()) {
+        auto it = index.find(entity);
+        if (it != index.end() && !reachable[it->second]) {
+          reachable[it->second] = true;
+          queue.push_back(it->second);
+        }
+      }
+    }
+  }
+
+  if (report != nullptr) {
+    for (size_t i = 0; i < reduced.size(); i++) {
+      if (!reachable[i]) {
+        report->unreachable.push_back(reduced[i].GetParent());
+      }
+    }
+  }
+  return Restrict(reduced, index, reachable);
+}
+
+Productions InlineUnitRules(const Productions &productions, ReductionReport *report) {
+  Index index = ParentIndex(productions);
+  std::vector<bool> left_recursive(productions.size(), false);
+  for (const auto &component : utils::LeftRecursiveComponents(productions)) {
+    for (size_t member : component) {
+      left_recursive[member] = true;
+    }
+  }
+  auto unit_target = [&](const Rule &rule) -> const Production * {
+    const auto &entities = rule.GetEntities();
+    if (entities.size() != 1) {
+      return nullptr;
+    }
+    auto it = index.find(entities[0]);
+    return it == index.end() || left_recursive[it->second] ? nullptr : &productions[it->second];
+  };
+
+  Productions inlined;
+  inlined.reserve(productions.size());
+  for (const auto &production : productions) {
+    Rules rules;
+    std::unordered_set<std::string> seen_rules;
+    std::unordered_set<std::string> visited{production.GetParent()};
+    // depth first, so a unit rule's replacements take its place
+    std::vector<std::pair<const Production *, size_t>> stack{{&production, 0}};
+    while (!stack.empty()) {
+      auto &[at, next] = stack.back();
+      if (next == at->GetRules().size()) {
+        stack.pop_back();
+        continue;
+      }
+      const Rule &rule = at->GetRules()[next++];
+      const Production *target = unit_target(rule);
+      if (target == nullptr) {
+        if (seen_rules.insert(RuleKey(rule.GetEntities())).second) {
+          rules.push_back(rule);
+        }
+        continue;
+      }
+      if (at == &production && report != nullptr) {
+        report->units.emplace_back(production.GetParent(), target->GetParent());
+      }
+      if (visited.insert(target->GetParent()).second) {
+        stack.emplace_back(target, 0);
+      }
+    }
+    inlined.emplace_back(production.GetParent(), std::move(rules));
+  }
+  return inlined;
+}
+
+Productions MergeIdenticalNonTerminals(const Productions &productions, const std::string &start_symbol,
+                                       ReductionReport *report) {
+  Index index = ParentIndex(productions);
+  std::vector<bool> nullable = Nullables(productions, index);
+
+  // class of every production: all non nullable ones start in class 0,
+  // every nullable one in a class of its own
+  std::vector<size_t> classes(productions.size(), 0);
+  size_t num_classes = 1;
+  for (size_t i = 0; i < productions.size(); i++) {
+    if (nullable[i]) {
+      classes[i] = num_classes++;
+    }
+  }
+
+  // refine by (class, rules with non terminals written as their class)
+  // until no class splits any more
+  while (true) {
+    std::unordered_map<std::string, size_t> refined_ids;
+    std::vector<size_t> refined(productions.size());
+    for (size_t i = 0; i < productions.size(); i++) {
+      std::vector<std::string> rule_keys;
+      for (const auto &rule : productions[i].GetRules()) {
+        std::string key;
+        for (const auto &entity : rule.GetEntities()) {
+          auto it = index.find(entity);
+          key += it == index.end() ? entity : "\x1e" + std::to_string(classes[it->second]);
+          key += '\x1f';
+        }
+        rule_keys.push_back(std::move(key));
+      }
+      std::sort(rule_keys.begin(), rule_keys.end());
+      rule_keys.erase(std::unique(rule_keys.begin(), rule_keys.end()), rule_keys.end());
+
+      std::string signature = std::to_string(classes[i]) + '\x1d';
+      for (const auto &key : rule_keys) {
+        signature += key;
+        signature += '\x1d';
+      }
+      refined[i] = refined_ids.emplace(std::move(signature), refined_ids.size()).first->second;
+    }
+    bool stable = refined_ids.size() == num_classes;
+    classes = std::move(refined);
+    num_classes = refined_ids.size();
+    if (stable) {
+      break;
+    }
+  }
+
+  // every class is kept as its first member, or as the start symbol
+  std::vector<size_t> representative(num_classes, productions.size());
+  auto start = index.find(start_symbol);
+  if (start != index.end()) {
+    representative[classes[start->second]] = start->second;
+  }
+  for (size_t i = 0; i < productions.size(); i++) {
+    if (representative[classes[i]] == productions.size()) {
+      representative[classes[i]] = i;
+    }
+  }
+
+  Productions merged;
+  for (size_t i = 0; i < productions.size(); i++) {
+    if (representative[classes[i]] != i) {
+      if (report != nullptr) {
+        report->merged.emplace_back(productions[i].GetParent(),
+                                    productions[representative[classes[i]]].GetParent());
+      }
+      continue;
+    }
+    Rules rules;
+    std::unordered_set<std::string> seen_rules;
+    for (const auto &rule : productions[i].GetRules()) {
+      std::vector<std::string> entities = rule.GetEntities();
+      for (auto &entity : entities) {
+        auto it = index.find(entity);
+        if (it != index.end()) {
+          entity = productions[representative[classes[it->second]]].GetParent();
+        }
+      }
+      // A : B | C with B and C merged is A : B once
+      if (seen_rules.insert(RuleKey(entities)).second) {
+        rules.emplace_back(std::move(entities));
+      }
+    }
+    merged.emplace_back(productions[i].GetParent(), std::move(rules));
+  }
+  return merged;
+}
+
+Productions ReduceGrammar(const Productions &productions, const std::string &start_symbol, unsigned reductions,
+                          ReductionReport *report) {
+  Productions reduced = productions;
+  if ((reductions & REDUCE_USELESS) != 0) {
+    reduced = RemoveUselessSymbols(reduced, start_symbol, report);
+  }
+  if ((reductions & REDUCE_UNIT_RULES) != 0) {
+    reduced = InlineUnitRules(reduced, report);
+    if ((reductions & REDUCE_USELESS) != 0) {
+      reduced = RemoveUselessSymbols(reduced, start_symbol, report);
+    }
+  }
+  if ((reductions & REDUCE_DUPLICATES) != 0) {
+    reduced = MergeIdenticalNonTerminals(reduced, start_symbol, report);
+  }
+
+  if (report != nullptr) {
+    report->before = utils::MeasureGrammar(productions);
+    report->after = utils::MeasureGrammar(reduced);
+  }
+  return reduced;
+}
+
+}  // namespace jucc::grammar
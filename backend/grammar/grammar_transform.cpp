@@ -1,6 +1,8 @@
 #include "../include/grammar/grammar_transform.h"
+#include "../include/grammar/left_recursion_engine.h"
+#include "../include/utils/left_factoring.h"
 #include <algorithm>
-#include <sstream>
+#include <iterator>
 
 namespace jucc {
 namespace grammar {
@@ -59,96 +61,24 @@ Productions GrammarTransform::EliminateImmediateLeftRecursion(const Production&
 }
 
 Productions GrammarTransform::EliminateLeftRecursion(const Productions& productions) {
-    Productions result = productions;
-    
-    // For each non-terminal Ai
-    for (size_t i = 0; i < result.size(); i++) {
-        // Replace each production of the form Ai → Ajγ where j < i
-        for (size_t j = 0; j < i; j++) {
-            Production& curr_prod = result[i];
-            const Production& prev_prod = result[j];
-            
-            Rules new_rules;
-            for (const auto& rule : curr_prod.GetRules()) {
-                const auto& entities = rule.GetEntities();
-                if (!entities.empty() && entities[0] == prev_prod.GetParent()) {
-                    // Replace Aj with its rules
-                    for (const auto& prev_rule : prev_prod.GetRules()) {
-                        std::vector<std::string> new_entities = prev_rule.GetEntities();
-                        new_entities.insert(new_entities.end(), 
-                                         entities.begin() + 1, 
-                                         entities.end());
-                        new_rules.push_back(Rule(new_entities));
-                    }
-                } else {
-                    new_rules.push_back(rule);
-                }
-            }
-            curr_prod.SetRules(new_rules);
-        }
-        
-        // Eliminate immediate left recursion
-        auto transformed = EliminateImmediateLeftRecursion(result[i]);
-        if (transformed.size() > 1) {
-            result[i] = transformed[0];
-            result.insert(result.begin() + i + 1, transformed[1]);
-        }
-    }
-    
-    return result;
+    return LeftRecursionEngine(productions).Run();
 }
 
 std::string GrammarTransform::GenerateNewNonTerminal(
     const std::string& base,
-    const std::unordered_set<std::string>& existing_names) {
+    const std::unordered_set<std::string>& existing_names,
+    int& suffix) {
     
-    std::string new_name = base;
-    int suffix = 1;
-    
-    while (existing_names.find(new_name) != existing_names.end()) {
-        std::stringstream ss;
-        ss << base << "_" << suffix++;
-        new_name = ss.str();
-    }
+    std::string new_name;
+    do {
+        new_name = suffix == 0 ? base : base + "_" + std::to_string(suffix);
+        suffix++;
+    } while (existing_names.find(new_name) != existing_names.end());
     
     return new_name;
 }
 
-std::vector<std::string> GrammarTransform::FindLongestCommonPrefix(const Rules& rules) {
-    if (rules.empty()) return {};
-    
-    std::vector<std::string> prefix;
-    size_t min_length = SIZE_MAX;
-    
-    // Find minimum length rule
-    for (const auto& rule : rules) {
-        min_length = std::min(min_length, rule.GetEntities().size());
-    }
-    
-    // Compare entities at each position
-    for (size_t i = 0; i < min_length; i++) {
-        const std::string& curr_entity = rules[0].GetEntities()[i];
-        bool is_common = true;
-        
-        for (size_t j = 1; j < rules.size(); j++) {
-            if (rules[j].GetEntities()[i] != curr_entity) {
-                is_common = false;
-                break;
-            }
-        }
-        
-        if (is_common) {
-            prefix.push_back(curr_entity);
-        } else {
-            break;
-        }
-    }
-    
-    return prefix;
-}
-
-Productions GrammarTransform::ApplyLeftFactoring(const Productions& productions) {
-    Productions result;
+Productions GrammarTransform::ApplyLeftFactoring(const Productions& productions, utils::ThreadPool* pool) {
     std::unordered_set<std::string> non_terminals;
     
     // Collect all non-terminal names
@@ -156,70 +86,42 @@ Productions GrammarTransform::ApplyLeftFactoring(const Productions& productions)
         non_terminals.insert(prod.GetParent());
     }
     
-    // Process each production
-    for (const auto& prod : productions) {
-        const Rules& rules = prod.GetRules();
-        
-        // Find rules with common prefixes
-        std::vector<bool> processed(rules.size(), false);
-        Rules new_rules;
-        
-        for (size_t i = 0; i < rules.size(); i++) {
-            if (processed[i]) continue;
-            
-            // Find rules with common prefix
-            Rules common_prefix_rules = {rules[i]};
-            for (size_t j = i + 1; j < rules.size(); j++) {
-                if (!processed[j] && rules[i].HasPrefix(rules[j])) {
-                    common_prefix_rules.push_back(rules[j]);
-                    processed[j] = true;
-                }
-            }
-            
-            if (common_prefix_rules.size() > 1) {
-                // Extract common prefix
-                auto prefix = FindLongestCommonPrefix(common_prefix_rules);
-                if (!prefix.empty()) {
-                    // Create new non-terminal
-                    std::string new_nt = GenerateNewNonTerminal(
-                        prod.GetParent() + "_fact",
-                        non_terminals
-                    );
-                    non_terminals.insert(new_nt);
-                    
-                    // Create new rule with prefix and new non-terminal
-                    std::vector<std::string> new_rule_entities = prefix;
-                    new_rule_entities.push_back(new_nt);
-                    new_rules.push_back(Rule(new_rule_entities));
-                    
-                    // Create new production for the new non-terminal
-                    Rules new_nt_rules;
-                    for (const auto& rule : common_prefix_rules) {
-                        const auto& entities = rule.GetEntities();
-                        if (entities.size() > prefix.size()) {
-                            new_nt_rules.push_back(Rule(
-                                std::vector<std::string>(
-                                    entities.begin() + prefix.size(),
-                                    entities.end()
-                                )
-                            ));
-                        } else {
-                            new_nt_rules.push_back(Rule({EPSILON}));
-                        }
-                    }
-                    result.push_back(Production(new_nt, new_nt_rules));
-                }
-            } else {
-                new_rules.push_back(rules[i]);
-            }
-            processed[i] = true;
+    // Each production only checks its new names against the grammar's own:
+    // A_fact_N can not clash with B_fact_M for A != B, so no task depends on
+    // another and the names are the same whatever the schedule
+    std::vector<Productions> factored(productions.size());
+    auto factor = [&](size_t i) { factored[i] = FactorProduction(productions[i], non_terminals); };
+    if (pool != nullptr) {
+        pool->ParallelFor(productions.size(), factor);
+    } else {
+        for (size_t i = 0; i < productions.size(); i++) {
+            factor(i);
         }
-        
-        result.push_back(Production(prod.GetParent(), new_rules));
+    }
+    
+    // Merge in grammar order
+    Productions result;
+    for (auto& prods : factored) {
+        result.insert(result.end(),
+                      std::make_move_iterator(prods.begin()),
+                      std::make_move_iterator(prods.end()));
     }
     
     return result;
 }
 
+Productions GrammarTransform::FactorProduction(const Production& production,
+                                               const std::unordered_set<std::string>& non_terminals) {
+    std::string base = production.GetParent() + "_fact";
+    int suffix = 0;
+    Productions factored = utils::FactorPrefixes(production, [&]() {
+        return GenerateNewNonTerminal(base, non_terminals, suffix);
+    });
+    
+    // New non-terminals before the production they were factored out of
+    std::rotate(factored.begin(), factored.begin() + 1, factored.end());
+    return factored;
+}
+
 } // namespace grammar
 } // namespace jucc 
\ No newline at end of file
@@ -0,0 +1,270 @@
+#include "grammar/left_recursion_engine.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+namespace jucc::grammar {
+
+LeftRecursionEngine::LeftRecursionEngine(const Productions &productions) {
+  for (const auto &production : productions) {
+    Symbol parent = Intern(production.GetParent());
+    if (group_[parent] == kNoGroup) {
+      group_[parent] = static_cast<uint32_t>(parents_.size());
+      parents_.push_back(parent);
+      rules_.emplace_back();
+    }
+    auto bodies = InternRules(production.GetRules());
+    auto &rules = rules_[group_[parent]];
+    rules.insert(rules.end(), std::make_move_iterator(bodies.begin()), std::make_move_iterator(bodies.end()));
+  }
+  chains_.resize(parents_.size());
+  reads_.resize(parents_.size());
+  readers_.resize(parents_.size());
+}
+
+LeftRecursionEngine::Symbol LeftRecursionEngine::Intern(const std::string &name) {
+  auto it = ids_.find(name);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+  Symbol id = AddSymbol(name);
+  ids_.emplace(name, id);
+  return id;
+}
+
+LeftRecursionEngine::Symbol LeftRecursionEngine::AddSymbol(std::string name) {
+  auto id = static_cast<Symbol>(names_.size());
+  names_.push_back(std::move(name));
+  bodies_.emplace_back();
+  position_.push_back(kUnplaced);
+  group_.push_back(kNoGroup);
+  return id;
+}
+
+std::vector<LeftRecursionEngine::Body> LeftRecursionEngine::InternRules(const Rules &rules) {
+  std::vector<Body> bodies;
+  bodies.reserve(rules.size());
+  for (const auto &rule : rules) {
+    Body body;
+    body.reserve(rule.GetEntities().size());
+    for (const auto &entity : rule.GetEntities()) {
+      body.push_back(Intern(entity));
+    }
+    bodies.push_back(std::move(body));
+  }
+  return bodies;
+}
+
+void LeftRecursionEngine::Substitute(Symbol parent, std::vector<uint32_t> &reads) {
+  Position placed = position_[parent];
+  // positions of the earlier non terminals some body starts with, smallest first
+  using Lead = std::pair<Position, Symbol>;
+  std::priority_queue<Lead, std::vector<Lead>, std::greater<>> pending;
+  auto note_lead = [&](const Body &body) {
+    if (!body.empty() && position_[body[0]] < placed) {
+      pending.emplace(position_[body[0]], body[0]);
+    }
+  };
+
+  for (const auto &body : bodies_[parent]) {
+    note_lead(body);
+  }
+
+  Position done = 0;
+  bool any_done = false;
+  while (!pending.empty()) {
+    auto [position, lead] = pending.top();
+    pending.pop();
+    if (any_done && position <= done) {
+      continue;
+    }
+    done = position;
+    any_done = true;
+    reads.push_back(static_cast<uint32_t>(position >> 32));
+
+    const std::vector<Body> &replacements = bodies_[lead];
+    std::vector<Body> &bodies = bodies_[parent];
+    std::vector<Body> rewritten;
+    rewritten.reserve(bodies.size() + replacements.size());
+    for (auto &body : bodies) {
+      if (body.empty() || body[0] != lead) {
+        rewritten.push_back(std::move(body));
+        continue;
+      }
+      stats_.substitutions++;
+      for (const auto &replacement : replacements) {
+        Body joined;
+        joined.reserve(replacement.size() + body.size() - 1);
+        joined.insert(joined.end(), replacement.begin(), replacement.end());
+        joined.insert(joined.end(), body.begin() + 1, body.end());
+        note_lead(joined);
+        rewritten.push_back(std::move(joined));
+      }
+    }
+    bodies = std::move(rewritten);
+  }
+}
+
+LeftRecursionEngine::Symbol LeftRecursionEngine::EliminateImmediate(Symbol parent, Symbol prime) {
+  bool recursive = false;
+  for (const auto &body : bodies_[parent]) {
+    if (!body.empty() && body[0] == parent) {
+      recursive = true;
+      break;
+    }
+  }
+  if (!recursive) {
+    return kNoSymbol;
+  }
+
+  // A -> A a | b  becomes  A -> b A_prime, A_prime -> a A_prime | EPSILON
+  Symbol epsilon = Intern(EPSILON);
+  if (prime == kNoSymbol) {
+    prime = AddSymbol(names_[parent] + "_prime");
+    stats_.new_non_terminals++;
+  }
+  std::vector<Body> &bodies = bodies_[parent];
+  std::vector<Body> &prime_bodies = bodies_[prime];
+  prime_bodies.clear();
+  std::vector<Body> kept;
+  for (auto &body : bodies) {
+    if (body.size() == 1 && body[0] == parent) {
+      // A -> A adds nothing and would give A_prime -> A_prime, drop it
+      continue;
+    }
+    if (!body.empty() && body[0] == parent) {
+      body.erase(body.begin());
+      body.push_back(prime);
+      prime_bodies.push_back(std::move(body));
+    } else {
+      body.push_back(prime);
+      kept.push_back(std::move(body));
+    }
+  }
+  if (kept.empty()) {
+    kept.push_back({prime});
+  }
+  prime_bodies.push_back({epsilon});
+  bodies = std::move(kept);
+  return prime;
+}
+
+void LeftRecursionEngine::ProcessGroup(uint32_t group) {
+  std::vector<Symbol> old_chain = std::move(chains_[group]);
+  for (Symbol symbol : old_chain) {
+    position_[symbol] = kUnplaced;
+  }
+  for (uint32_t read : reads_[group]) {
+    auto &readers = readers_[read];
+    readers.erase(std::find(readers.begin(), readers.end(), group));
+  }
+  reads_[group].clear();
+
+  Symbol parent = parents_[group];
+  bodies_[parent] = rules_[group];
+  chains_[group].clear();
+  // a new A_prime is placed and processed right after A, reusing the
+  // symbol an earlier run made for it
+  for (Symbol next = parent; next != kNoSymbol;) {
+    size_t place = chains_[group].size();
+    position_[next] = (static_cast<Position>(group) << 32) | place;
+    chains_[group].push_back(next);
+    Substitute(next, reads_[group]);
+    next = EliminateImmediate(next, place + 1 < old_chain.size() ? old_chain[place + 1] : kNoSymbol);
+  }
+  for (size_t i = chains_[group].size(); i < old_chain.size(); i++) {
+    bodies_[old_chain[i]].clear();
+  }
+
+  auto &reads = reads_[group];
+  std::sort(reads.begin(), reads.end());
+  reads.erase(std::unique(reads.begin(), reads.end()), reads.end());
+  // a prime reading its own parent is redone with it
+  reads.erase(std::remove(reads.begin(), reads.end(), group), reads.end());
+  for (uint32_t read : reads) {
+    readers_[read].push_back(group);
+  }
+}
+
+Productions LeftRecursionEngine::Run() {
+  for (uint32_t group = 0; group < parents_.size(); group++) {
+    ProcessGroup(group);
+  }
+
+  Productions result;
+  result.reserve(parents_.size());
+  for (size_t group = 0; group < parents_.size(); group++) {
+    Productions productions = GetGroup(group);
+    result.insert(result.end(), std::make_move_iterator(productions.begin()),
+                  std::make_move_iterator(productions.end()));
+  }
+  return result;
+}
+
+std::vector<size_t> LeftRecursionEngine::Replace(const std::string &parent, const Rules &rules) {
+  auto it = ids_.find(parent);
+  if (it == ids_.end() || group_[it->second] == kNoGroup) {
+    throw std::invalid_argument("no production for " + parent);
+  }
+  uint32_t edited = group_[it->second];
+  rules_[edited] = InternRules(rules);
+
+  // readers are always placed after what they read, so every group is
+  // final by the time it is popped
+  std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<>> dirty;
+  std::vector<bool> queued(parents_.size(), false);
+  dirty.push(edited);
+  queued[edited] = true;
+  std::vector<size_t> changed;
+  std::vector<std::vector<Body>> before;
+  while (!dirty.empty()) {
+    uint32_t group = dirty.top();
+    dirty.pop();
+    before.clear();
+    for (Symbol symbol : chains_[group]) {
+      before.push_back(bodies_[symbol]);
+    }
+    ProcessGroup(group);
+    stats_.reprocessed++;
+
+    bool same = before.size() == chains_[group].size();
+    for (size_t i = 0; same && i < before.size(); i++) {
+      same = before[i] == bodies_[chains_[group][i]];
+    }
+    if (same) {
+      continue;
+    }
+    changed.push_back(group);
+    for (uint32_t reader : readers_[group]) {
+      if (!queued[reader]) {
+        queued[reader] = true;
+        dirty.push(reader);
+      }
+    }
+  }
+  return changed;
+}
+
+Productions LeftRecursionEngine::GetGroup(size_t group) const {
+  Productions result;
+  result.reserve(chains_[group].size());
+  for (Symbol parent : chains_[group]) {
+    Rules rules;
+    rules.reserve(bodies_[parent].size());
+    for (const auto &body : bodies_[parent]) {
+      std::vector<std::string> entities;
+      entities.reserve(body.size());
+      for (Symbol symbol : body) {
+        entities.push_back(names_[symbol]);
+      }
+      rules.emplace_back(std::move(entities));
+    }
+    result.emplace_back(names_[parent], std::move(rules));
+  }
+  return result;
+}
+
+}  // namespace jucc::grammar
@@ -0,0 +1,131 @@
+#ifndef JUCC_DAEMON_DAEMON_H
+#define JUCC_DAEMON_DAEMON_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "parser/ll_parser.h"
+#include "utils/json_emitter.h"
+
+namespace jucc::daemon {
+
+/**
+ * Long running compiler process.
+ *
+ * Requests and responses are frames: a u32 little endian payload length
+ * followed by a JSON object. Every request may carry an "id" that is echoed
+ * in its response; responses are written as requests finish, which is not
+ * necessarily the order they came in, so a request that uses the result
+ * of another (a parse of a new grammar) is sent once that response is in.
+ *
+ *   {"op": "compile", "grammar": "grammar.txt"}
+ *       -> {"grammar": "g1", "conflicts": [...], "terminals": n, "non_terminals": n}
+ *   {"op": "edit", "grammar": "g1", "parent": "E", "rules": [["E", "+", "T"], ["T"]]}
+ *       -> {"grammar": "g2", ... as compile, "recomputed": {"groups", "productions", "first", "follow", "rows"}}
+ *   {"op": "lex", "source": "int x;"}
+ *       -> {"tokens": [{"type", "value", "line", "error"}, ...]}
+ *   {"op": "parse", "grammar": "g1", "source": "..."} or "tokens": ["id", "+", ...]
+ *       -> {"session": "s1", "accepted": bool, "steps": n, "nodes": n, "root": id}
+ *   {"op": "trace", "session": "s1", "from": 0, "count": 100}
+ *       -> {"steps": n, "entries": [trace entries as in parse_trace.json]}
+ *   {"op": "tree", "session": "s1", "node": id, "depth": 3}
+ *       -> {"slice": Treant.js slice as served by tree_slice_run}, node defaults to the root
+ *   {"op": "close", "session": "s1"} or {"op": "close", "grammar": "g1"}
+ *   {"op": "shutdown"}
+ * Successful responses have "ok": true, failed ones "ok": false and "error".
+ *
+ * Compiled grammars are kept until closed; compiling the same file again
+ * with unchanged contents returns the existing grammar. An edit replaces
+ * the rules of one production of the grammar as written, before any
+ * transform, and returns a new grammar: g1 stays as it was for the sessions
+ * using it. Edits are recompiled by a pipeline::IncrementalCompiler, which
+ * only redoes what the edited production reaches when g1 is the grammar
+ * its chain of edits last produced; editing any other grammar recompiles
+ * its text and edits first. Grammars with %import can not be edited. With a cache_dir,
+ * grammars compiled by an earlier run are read back from the compile cache.
+ * Parse sessions hold the trace and tree of one parse; the oldest are
+ * dropped once there are more than max_sessions.
+ */
+struct DaemonOptions {
+  size_t num_threads{0};  // one per hardware thread if 0
+  size_t max_sessions{64};
+  std::string cache_dir;  // on disk compile cache shared across restarts, none if empty
+};
+
+/**
+ * Reads one frame into payload.
+ * @returns false at end of input or on a truncated frame
+ */
+bool ReadFrame(std::istream & /*in*/, std::string & /*payload*/);
+
+/**
+ * Writes payload as one frame and flushes out.
+ */
+void WriteFrame(std::ostream & /*out*/, std::string_view /*payload*/);
+
+class Daemon {
+  struct Grammar;
+  struct Editor;
+  struct Session;
+  struct Request;
+
+  DaemonOptions options_;
+
+  std::mutex mutex_;  // guards everything below
+  std::unordered_map<std::string, std::shared_ptr<const Grammar>> grammars_;
+  std::unordered_map<std::string, std::string> grammar_by_content_;
+  std::unordered_map<std::string, std::shared_ptr<const Session>> sessions_;
+  std::deque<std::string> session_order_;
+  uint64_t next_grammar_{1};
+  uint64_t next_session_{1};
+
+  static Request ParseRequest(const std::string & /*payload*/);
+  static std::string Respond(const Request * /*request*/, const std::function<void(utils::JsonEmitter &)> & /*body*/);
+  static std::string ErrorResponse(const Request * /*request*/, const std::string & /*error*/);
+  static void WriteGrammar(utils::JsonEmitter & /*json*/, const std::string & /*id*/, const Grammar & /*grammar*/);
+  std::string Dispatch(const Request & /*request*/);
+
+  // each writes the members of a successful response and throws on failure
+  void Compile(const Request & /*request*/, utils::JsonEmitter & /*json*/);
+  void Edit(const Request & /*request*/, utils::JsonEmitter & /*json*/);
+  void Lex(const Request & /*request*/, utils::JsonEmitter & /*json*/);
+  void Parse(const Request & /*request*/, utils::JsonEmitter & /*json*/);
+  void Trace(const Request & /*request*/, utils::JsonEmitter & /*json*/);
+  void Tree(const Request & /*request*/, utils::JsonEmitter & /*json*/);
+  void Close(const Request & /*request*/, utils::JsonEmitter & /*json*/);
+  void Shutdown(const Request & /*request*/, utils::JsonEmitter & /*json*/);
+
+  std::shared_ptr<const Grammar> FindGrammar(const std::string & /*id*/);
+  std::shared_ptr<const Session> FindSession(const std::string & /*id*/);
+
+ public:
+  explicit Daemon(DaemonOptions options = DaemonOptions());
+  ~Daemon();
+
+  /**
+   * Handles one request payload and returns the response payload.
+   * Safe to call from several threads at once.
+   * @param shutdown set to true for a shutdown request
+   */
+  std::string Handle(const std::string & /*request*/, bool *shutdown = nullptr);
+
+  /**
+   * Reads frames from in until end of input or a shutdown request and
+   * handles them on a thread pool, writing responses to out.
+   * @returns the number of requests served
+   */
+  size_t Serve(std::istream & /*in*/, std::ostream & /*out*/);
+};
+
+}  // namespace jucc::daemon
+
+#endif  // JUCC_DAEMON_DAEMON_H
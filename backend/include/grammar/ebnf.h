@@ -0,0 +1,96 @@
+#ifndef JUCC_GRAMMAR_EBNF_H
+#define JUCC_GRAMMAR_EBNF_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "grammar/grammar.h"
+
+namespace jucc::grammar {
+
+class EbnfExpander {
+  /**
+   * Rewrites the EBNF operators of a %rules line into plain rules and
+   * helper productions:
+   *
+   *   A : X*        A : A_rep       A_rep : X A_rep | EPSILON
+   *   A : X+        A : X A_rep     A_rep : X A_rep | EPSILON
+   *   A : X?        A : A_opt       A_opt : X | EPSILON
+   *   A : ( X | Y ) A : A_grp       A_grp : X | Y
+   *   A : X | Y     A : X, A : Y
+   *
+   * Operators are separate tokens or glued to the end of a symbol or of a
+   * closing parenthesis, as in X* or )+. A token that is a declared symbol
+   * is always that symbol, so grammars declaring ( ) * + ? | as terminals
+   * read as before. A group of one alternative is spliced in place, one of
+   * several is repeated through its own A_grp so that left factoring it
+   * leaves the loop rule alone.
+   *
+   * Every A_rep rule ends in A_rep, which the driver and the tree builder
+   * run as a loop, see LLDriver::Parse and ConcreteSyntaxTree::Builder.
+   * Helpers for the same operator over the same operand are made once and
+   * shared. Within a line a helper comes before the helpers of its operand:
+   * left recursion elimination substitutes rules starting with a non
+   * terminal placed earlier, which would unroll the loop.
+   */
+  enum class Kind { SYMBOL, OPEN, CLOSE, BAR, STAR, PLUS, OPTIONAL };
+
+  struct Token {
+    Kind kind;
+    std::string symbol;  // for SYMBOL
+  };
+
+  using Sequence = std::vector<std::string>;
+  using Alternatives = std::vector<Sequence>;
+
+  const std::unordered_set<std::string> &terminals_;
+  const std::unordered_set<std::string> &non_terminals_;
+  std::unordered_set<std::string> names_;                // helpers made so far
+  std::unordered_set<std::string> loops_;                // those of them made for * and +
+  std::unordered_map<std::string, std::string> shared_;  // operator and operand to the helper made for them
+  Productions helpers_;                                  // made since the last TakeHelpers
+  std::string parent_;
+  std::vector<Token> tokens_;
+  size_t next_{0};
+  std::string error_;
+
+  [[nodiscard]] bool IsSymbol(const std::string &token) const;
+  bool Lex(const std::vector<std::string> & /*line*/, bool & /*plain*/);
+  bool ParseAlternatives(bool /*nested*/, Alternatives & /*alternatives*/);
+  bool ParseItem(Sequence & /*sequence*/);
+  std::string MakeHelper(Kind /*kind*/, const Alternatives & /*operand*/, size_t /*position*/);
+  std::string NewName(const char * /*suffix*/);
+  static Rule MakeRule(Sequence /*sequence*/);
+
+ public:
+  EbnfExpander(const std::unordered_set<std::string> & /*terminals*/,
+               const std::unordered_set<std::string> & /*non_terminals*/);
+
+  /**
+   * Appends the rules a %rules line of parent stands for. A line without
+   * operators is one rule, exactly as written.
+   * @returns false and sets the error if the line does not parse or uses an
+   * undefined symbol
+   */
+  bool Expand(const std::string & /*parent*/, const std::vector<std::string> & /*line*/, Rules & /*rules*/);
+
+  /**
+   * Hands over the helper productions made since the last call, in the
+   * order they belong in the grammar.
+   */
+  Productions TakeHelpers();
+
+  /**
+   * Whether name is the A_rep helper of a repetition made so far.
+   */
+  [[nodiscard]] bool IsLoop(const std::string &name) const { return loops_.count(name) != 0U; }
+
+  [[nodiscard]] const std::string &GetError() const { return error_; }
+};
+
+}  // namespace jucc::grammar
+
+#endif  // JUCC_GRAMMAR_EBNF_H
@@ -2,14 +2,25 @@
 #define JUCC_GRAMMAR_GRAMMAR_H
 
 #include <fstream>
+#include <istream>
+#include <memory>
+#include <ostream>
 #include <string>
 #include <utility>
 #include <vector>
 
 namespace jucc {
+namespace utils {
+class ThreadPool;
+struct LeftRecursionReport;
+}  // namespace utils
+
 namespace grammar {
 const char EPSILON[] = "EPSILON";
 
+struct ReductionReport;
+struct GrammarModule;
+
 class Rule {
   /**
    * An entity is a single terminal or non terminal in the right hand side
@@ -60,6 +71,15 @@ class Production {
 
 using Productions = std::vector<Production>;
 
+/**
+ * Non terminals made by the transforms rather than declared in the grammar,
+ * as the transforms named them.
+ */
+struct GeneratedSymbols {
+  std::vector<std::string> helpers;  // every one: EBNF helpers, left recursion and left factoring tails
+  std::vector<std::string> loops;    // the A_rep helpers of EBNF repetitions, whose rules ending in A_rep loop
+};
+
 /**
  * Search if a production exists for a given parent
  * utility function
@@ -75,16 +95,27 @@ Rules GetRulesForParent(const grammar::Productions & /*productions*/, const std:
 
 class Parser {
   std::ifstream file_;
+  std::istream *input_{nullptr};            // file_ or the stream passed in, null if the file did not open
+  std::string base_dir_;                    // %import paths are relative to it
   std::vector<std::string> terminals_;      // Terminals defined in grammar file
   std::vector<std::string> non_terminals_;  // Non terminals defined in grammar file
   std::string start_symbol_;                // Start symbol for the grammar
   Productions grammar_;                     // Production rules
+  GeneratedSymbols generated_;              // among non_terminals_
+  std::vector<std::shared_ptr<const GrammarModule>> imports_;  // every module used, directly or not
   std::string error_;                       // parser error message
+  std::ostream *log_{nullptr};              // progress messages go here if set
 
   /**
-   * Splits input string via spaces.
+   * Loads the modules named by %import and checks that they define
+   * different non terminals than the grammar and one another.
    */
-  static std::vector<std::string> FastTokenize(const std::string &s);
+  bool LoadImports(const std::vector<std::string> & /*paths*/);
+
+  /**
+   * Fails if a transform named a new non terminal after a symbol of a module.
+   */
+  bool CheckImportClashes(const std::string & /*stage*/);
 
  public:
   /**
@@ -93,6 +124,14 @@ class Parser {
    */
   explicit Parser(const char *filepath);
 
+  /**
+   * Reads the grammar from input, which must outlive the parser.
+   * @param base_dir directory %import paths are relative to, the working
+   * directory if empty
+   */
+  explicit Parser(std::istream &input, std::string base_dir = "")
+      : input_(&input), base_dir_(std::move(base_dir)) {}
+
   /**
    * Destructor
    * closes std::ifstream file_
@@ -101,11 +140,22 @@ class Parser {
 
   /**
    * Parses the input file and populates private variables.
+   * A "%import path" line outside the sections makes the symbols of the
+   * module at path usable in the rules, see ModuleCache; the module's own
+   * productions come precompiled and are not transformed again.
    * Returns true if successful.
    * On error returns false and sets error_.
    */
   bool Parse();
 
+  /**
+   * Runs the grammar reduction passes selected in reductions, see
+   * grammar::ReduceGrammar. Meant to run right after Parse.
+   * @param report receives what every pass removed if given
+   * @return true if successful, false otherwise
+   */
+  bool Reduce(unsigned /*reductions*/, ReductionReport * /*report*/ = nullptr);
+
   /**
    * Eliminates left recursion from the grammar
    * @return true if successful, false otherwise
@@ -114,22 +164,60 @@ class Parser {
 
   /**
    * Applies left factoring to the grammar
+   * @param pool factors productions in parallel on it if given
    * @return true if successful, false otherwise
    */
-  bool ApplyLeftFactoring();
+  bool ApplyLeftFactoring(utils::ThreadPool * /*pool*/ = nullptr);
+
+  /**
+   * Removes left recursion and left factors with
+   * utils::RemoveAllPossibleAmbiguity, in place of EliminateLeftRecursion
+   * and ApplyLeftFactoring: left recursive components are rewritten with
+   * Paull's substitution and new non terminals are named A' and A'@.
+   * @param pool transforms components and productions in parallel on it if given
+   * @param report receives the grammar size before and after left recursion
+   * removal if given
+   * @return true if successful, false otherwise
+   */
+  bool RemoveAllPossibleAmbiguity(utils::ThreadPool * /*pool*/ = nullptr,
+                                  utils::LeftRecursionReport * /*report*/ = nullptr);
 
   /**
    * Getters for each private variable.
+   * Terminals, non terminals, productions and generated symbols are those
+   * of the grammar followed by those of its imports that are not already
+   * listed.
    */
-  std::vector<std::string> GetTerminals() { return terminals_; }
-  std::vector<std::string> GetNonTerminals() { return non_terminals_; }
+  std::vector<std::string> GetTerminals();
+  std::vector<std::string> GetNonTerminals();
   std::string GetStartSymbol() { return start_symbol_; }
-  Productions GetProductions() { return grammar_; }
+  Productions GetProductions();
+  GeneratedSymbols GetGenerated();
   std::string GetError() { return error_; }
-  void DumpGrammarAsJson(const std::string &filepath);
+  const std::vector<std::shared_ptr<const GrammarModule>> &GetImports() { return imports_; }
+
+  /**
+   * Parse reports what it reads to log, not owned; nothing is written
+   * unless one is set.
+   */
+  void SetLog(std::ostream *log) { log_ = log; }
+
+  /**
+   * Packages what this grammar defines, after the transforms, as the
+   * module at path.
+   */
+  std::shared_ptr<const GrammarModule> MakeModule(const std::string & /*path*/);
+  void DumpGrammarAsJson(const std::string &filepath, bool compact = false);
 };
 
-void DumpGrammarAsJson(const Productions &productions, const std::string &filepath);
+void DumpGrammarAsJson(const Productions &productions, const std::string &filepath, bool compact = false);
+
+/**
+ * Writes grammar.json for a complete grammar, as Parser::DumpGrammarAsJson does.
+ */
+void DumpGrammarAsJson(const std::vector<std::string> &terminals, const std::vector<std::string> &non_terminals,
+                       const std::string &start_symbol, const Productions &productions,
+                       const GeneratedSymbols &generated, const std::string &filepath, bool compact = false);
 }  // namespace grammar
 }  // namespace jucc
 
@@ -0,0 +1,95 @@
+#ifndef JUCC_GRAMMAR_GRAMMAR_MODULE_H
+#define JUCC_GRAMMAR_GRAMMAR_MODULE_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "grammar/grammar.h"
+#include "utils/first_follow.h"
+
+namespace jucc::grammar {
+
+/**
+ * A .g file compiled on its own for %import: its productions after left
+ * recursion elimination and left factoring, with the nullability and FIRST
+ * of its symbols.
+ *
+ * A module can not see the grammars importing it, so placing its productions
+ * after theirs gives what transforming the composed grammar would: left
+ * recursion elimination only substitutes non terminals placed earlier, and
+ * nothing of a module starts with a symbol of its importers. For the same
+ * reason its nullability and FIRST are final, only FOLLOW depends on where
+ * it is imported.
+ */
+struct GrammarModule {
+  std::string path;                        // resolved, see ResolveImport
+  std::vector<std::string> terminals;      // declared
+  std::vector<std::string> non_terminals;  // declared, then made by the transforms
+  Productions productions;                 // of non_terminals only
+  GeneratedSymbols generated;              // of non_terminals, made by the transforms
+  std::vector<std::shared_ptr<const GrammarModule>> imports;  // every module it uses, directly or not
+  std::unordered_map<std::string, bool> nullables;            // of its terminals and non terminals
+  utils::SymbolsMap firsts;                                   // of its non terminals
+};
+
+using GrammarModules = std::vector<std::shared_ptr<const GrammarModule>>;
+
+/**
+ * Path of the module named in a %import line of a grammar read from
+ * base_dir; absolute paths are kept, empty base_dir is the working
+ * directory.
+ */
+std::string ResolveImport(const std::string & /*base_dir*/, const std::string & /*path*/);
+
+/**
+ * Nullability and FIRST of the non terminals of productions, given those of
+ * the modules they use, computed over the productions alone. Rules of a
+ * single EPSILON count as empty.
+ */
+void CalcModuleSummary(const Productions & /*productions*/, const GrammarModules & /*imports*/,
+                       std::unordered_map<std::string, bool> & /*nullables*/, utils::SymbolsMap & /*firsts*/);
+
+class ModuleCache {
+  /**
+   * Compiled modules by resolved path, shared by every grammar::Parser in
+   * the process. A module is compiled again only when its file or one of
+   * the modules it imports changed; the file is read on every lookup to
+   * find out. Modules are compiled without holding the lock, so two threads
+   * importing the same new module may both compile it; either result is
+   * the same module.
+   */
+  struct Entry {
+    std::string text;  // the module was compiled from
+    std::shared_ptr<const GrammarModule> module;
+  };
+
+  std::mutex mutex_;  // guards everything below
+  std::unordered_map<std::string, Entry> modules_;
+  size_t compiles_{0};
+
+ public:
+  static ModuleCache &Shared();
+
+  /**
+   * @returns the module at the resolved path, compiled now unless an up to
+   * date one is cached; null with error set if it does not compile, or
+   * imports itself
+   */
+  std::shared_ptr<const GrammarModule> Load(const std::string & /*path*/, std::string & /*error*/);
+
+  /**
+   * Number of modules compiled so far.
+   */
+  size_t GetCompiles();
+
+  void Clear();
+};
+
+}  // namespace jucc::grammar
+
+#endif  // JUCC_GRAMMAR_GRAMMAR_MODULE_H
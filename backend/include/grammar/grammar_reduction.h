@@ -0,0 +1,90 @@
+#ifndef JUCC_GRAMMAR_GRAMMAR_REDUCTION_H
+#define JUCC_GRAMMAR_GRAMMAR_REDUCTION_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "grammar/grammar.h"
+#include "utils/left_recursion.h"
+
+namespace jucc::grammar {
+
+/**
+ * Reduction passes, as a bit set. They run in declaration order, each on
+ * the output of the one before.
+ */
+enum Reduction : unsigned {
+  REDUCE_NONE = 0,
+  REDUCE_USELESS = 1U << 0,     // unproductive, then unreachable non terminals
+  REDUCE_UNIT_RULES = 1U << 1,  // A : B replaced by the rules of B
+  REDUCE_DUPLICATES = 1U << 2,  // non terminals deriving the same rules merged
+  REDUCE_ALL = (1U << 3) - 1,
+};
+
+/**
+ * @returns the Reduction named name ("useless", "units", "duplicates" or
+ * "all"), REDUCE_NONE if there is none.
+ */
+unsigned ReductionFromName(const std::string & /*name*/);
+
+/**
+ * What the passes took out of a grammar, in the order they found it.
+ */
+struct ReductionReport {
+  std::vector<std::string> unproductive;                    // derive no string of terminals
+  std::vector<std::string> unreachable;                     // not derivable from the start symbol
+  std::vector<std::pair<std::string, std::string>> units;   // A : B rules inlined, as (A, B)
+  std::vector<std::pair<std::string, std::string>> merged;  // (removed, kept in its place)
+  utils::GrammarSize before;
+  utils::GrammarSize after;
+
+  [[nodiscard]] bool Empty() const {
+    return unproductive.empty() && unreachable.empty() && units.empty() && merged.empty();
+  }
+};
+
+/**
+ * Removes the non terminals that derive no string of terminals, with every
+ * rule using one, then those the start symbol no longer reaches. Symbols
+ * that are not the parent of a production count as terminals. The start
+ * symbol is always kept, even when it derives nothing.
+ */
+Productions RemoveUselessSymbols(const Productions & /*productions*/, const std::string & /*start_symbol*/,
+                                 ReductionReport * /*report*/ = nullptr);
+
+/**
+ * Replaces every unit rule A : B by the rules of B that are not unit rules
+ * themselves, following chains and cycles of unit rules, keeping the first
+ * copy of a rule reached twice. Unit rules to a left recursive non terminal
+ * stay: E : T with T : T * F would give E a rule starting with T next to
+ * the ones T starts with, a conflict left recursion elimination cannot
+ * undo. Non terminals only used through unit rules become unreachable,
+ * RemoveUselessSymbols drops them.
+ */
+Productions InlineUnitRules(const Productions & /*productions*/, ReductionReport * /*report*/ = nullptr);
+
+/**
+ * Merges non terminals whose rules are the same up to the merged names,
+ * including recursive ones, by refining one class of all non terminals
+ * until every class agrees on its rules. Each class keeps its first member,
+ * or the start symbol, and references to the others are renamed to it.
+ * Nullable non terminals are never merged: the merged one would predict
+ * its empty rule on the union of their FOLLOW sets, which can add LL(1)
+ * conflicts the grammar did not have.
+ */
+Productions MergeIdenticalNonTerminals(const Productions & /*productions*/, const std::string & /*start_symbol*/,
+                                       ReductionReport * /*report*/ = nullptr);
+
+/**
+ * Runs the passes selected in reductions. With REDUCE_USELESS, the non
+ * terminals inlining leaves unreachable are removed as well. The language
+ * derived from the start symbol stays the same; parse trees lose the
+ * inlined and merged non terminals.
+ */
+Productions ReduceGrammar(const Productions & /*productions*/, const std::string & /*start_symbol*/,
+                          unsigned /*reductions*/, ReductionReport * /*report*/ = nullptr);
+
+}  // namespace jucc::grammar
+
+#endif  // JUCC_GRAMMAR_GRAMMAR_REDUCTION_H
@@ -2,6 +2,7 @@
 #define JUCC_GRAMMAR_TRANSFORM_H
 
 #include "grammar.h"
+#include "../utils/thread_pool.h"
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -27,30 +28,40 @@ public:
     static Productions EliminateLeftRecursion(const Productions& productions);
 
     /**
-     * Applies left factoring to a set of productions
+     * Applies left factoring to a set of productions, factoring every
+     * shared prefix of every production in a single trie pass
      * @param productions The productions to transform
+     * @param pool If given, productions are factored in parallel on it; the
+     *        result does not depend on it
      * @return Left-factored set of productions
      */
-    static Productions ApplyLeftFactoring(const Productions& productions);
+    static Productions ApplyLeftFactoring(const Productions& productions, utils::ThreadPool* pool = nullptr);
+
+    /**
+     * Left factors a single production the way ApplyLeftFactoring does
+     * @param production The production to transform
+     * @param non_terminals Parents of the whole grammar, new non-terminals
+     *        are named past them
+     * @return The new non-terminals' productions, then the factored one
+     */
+    static Productions FactorProduction(const Production& production,
+                                        const std::unordered_set<std::string>& non_terminals);
 
 private:
     /**
-     * Generates a new unique non-terminal name
+     * Generates a new unique non-terminal name: base, base_1, base_2, ...
      * @param base The base name for the new non-terminal
      * @param existing_names Set of existing non-terminal names
+     * @param suffix The suffix to try first, 0 for none; left at the one
+     *        after the name returned, so the next call for the same base
+     *        does not hand out the same name
      * @return A unique non-terminal name
      */
     static std::string GenerateNewNonTerminal(
         const std::string& base,
-        const std::unordered_set<std::string>& existing_names
+        const std::unordered_set<std::string>& existing_names,
+        int& suffix
     );
-
-    /**
-     * Finds the longest common prefix among a set of rules
-     * @param rules The rules to analyze
-     * @return The longest common prefix as a vector of symbols
-     */
-    static std::vector<std::string> FindLongestCommonPrefix(const Rules& rules);
 };
 
 } // namespace grammar
@@ -0,0 +1,105 @@
+#ifndef JUCC_GRAMMAR_LEFT_RECURSION_ENGINE_H
+#define JUCC_GRAMMAR_LEFT_RECURSION_ENGINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "grammar/grammar.h"
+
+namespace jucc::grammar {
+
+struct LeftRecursionStats {
+  size_t substitutions{0};      // rules whose leading non terminal was replaced by its bodies
+  size_t new_non_terminals{0};  // _prime productions added
+  size_t reprocessed{0};        // groups processed again by Replace
+};
+
+class LeftRecursionEngine {
+  /**
+   * Paull's algorithm over an interned copy of the grammar: symbols are
+   * integers, bodies are vectors of them and every rewrite moves bodies
+   * instead of copying productions.
+   *
+   * Non terminals are placed in order, each new A_prime right after its
+   * parent, and may only start with non terminals placed after them once
+   * processed. Processing A therefore substitutes the earlier non terminals
+   * its bodies actually start with, in placement order, instead of trying
+   * every earlier non terminal against every body. New non terminals are
+   * appended to the symbol table and the output lists everything in
+   * placement order, which is the order the old insert based loop left
+   * its vector in, so both give the same productions.
+   *
+   * Productions with the same parent are merged into one and cycles A -> A
+   * are dropped, the old loop never terminated on them.
+   *
+   * Each input parent and the primes made for it form a group. Processing a
+   * group only reads its own rules and the finished bodies of the earlier
+   * groups it substitutes, which are recorded, so Replace can redo the
+   * edited group and then only the groups that read a group whose output
+   * changed, in placement order.
+   */
+  using Symbol = uint32_t;
+  using Body = std::vector<Symbol>;
+  using Position = uint64_t;  // group << 32 | place in the group
+
+  static constexpr Symbol kNoSymbol = std::numeric_limits<Symbol>::max();
+  static constexpr uint32_t kNoGroup = std::numeric_limits<uint32_t>::max();
+  static constexpr Position kUnplaced = std::numeric_limits<Position>::max();
+
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, Symbol> ids_;
+  std::vector<std::vector<Body>> bodies_;  // by symbol, empty for terminals
+  std::vector<Position> position_;         // placement of each non terminal, kUnplaced until processed
+  std::vector<uint32_t> group_;            // group an input parent heads, kNoGroup for other symbols
+  std::vector<Symbol> parents_;            // parents of the input, in input order, one group each
+  std::vector<std::vector<Body>> rules_;   // input bodies of every group
+  std::vector<std::vector<Symbol>> chains_;     // placed symbols of every group: the parent, then its primes
+  std::vector<std::vector<uint32_t>> reads_;    // earlier groups a group substituted
+  std::vector<std::vector<uint32_t>> readers_;  // later groups that substituted a group
+  LeftRecursionStats stats_;
+
+  Symbol Intern(const std::string & /*name*/);
+  Symbol AddSymbol(std::string /*name*/);
+  std::vector<Body> InternRules(const Rules & /*rules*/);
+  void Substitute(Symbol /*parent*/, std::vector<uint32_t> & /*reads*/);
+  Symbol EliminateImmediate(Symbol /*parent*/, Symbol /*prime*/);
+  void ProcessGroup(uint32_t /*group*/);
+
+ public:
+  explicit LeftRecursionEngine(const Productions & /*productions*/);
+
+  /**
+   * Removes direct and indirect left recursion.
+   * @returns the transformed productions, each new A_prime following A
+   */
+  Productions Run();
+
+  /**
+   * Replaces the rules of the input production of parent after Run, and
+   * redoes the elimination for every group the change reaches. The result
+   * is what Run on the edited input would give.
+   * @returns the groups whose productions changed, in placement order
+   * @throws std::invalid_argument if parent was not a parent of the input
+   */
+  std::vector<size_t> Replace(const std::string & /*parent*/, const Rules & /*rules*/);
+
+  /**
+   * Number of groups, one per distinct parent of the input, in input order.
+   */
+  [[nodiscard]] size_t NumGroups() const { return parents_.size(); }
+
+  /**
+   * The transformed productions of a group: its parent, then its A_prime.
+   */
+  [[nodiscard]] Productions GetGroup(size_t /*group*/) const;
+
+  [[nodiscard]] const LeftRecursionStats &GetStats() const { return stats_; }
+};
+
+}  // namespace jucc::grammar
+
+#endif  // JUCC_GRAMMAR_LEFT_RECURSION_ENGINE_H
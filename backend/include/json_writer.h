@@ -1,10 +1,13 @@
 #ifndef JUCC_JSON_WRITER_H
 #define JUCC_JSON_WRITER_H
 
+#include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
-#include <fstream>
-#include <sstream>
+
+#include "grammar/grammar.h"
+#include "utils/json_emitter.h"
 
 namespace jucc {
 
@@ -15,64 +18,76 @@ public:
         const std::vector<std::string>& non_terminals,
         const std::string& start_symbol,
         const std::vector<std::pair<std::string, std::vector<std::vector<std::string>>>>& productions,
-        const std::string& filepath
+        const grammar::GeneratedSymbols& generated,
+        const std::string& filepath,
+        bool compact = false
     ) {
-        std::ofstream out(filepath);
-        if (!out.is_open()) {
+        auto out = utils::OutputBuffer::Open(filepath);
+        if (out.Failed()) {
             throw std::runtime_error("Failed to open output file: " + filepath);
         }
 
-        out << "{\n";
-        
-        // Write terminals
-        out << "  \"terminals\": [\n";
-        for (size_t i = 0; i < terminals.size(); ++i) {
-            out << "    \"" << terminals[i] << "\"";
-            if (i < terminals.size() - 1) out << ",";
-            out << "\n";
+        utils::JsonEmitter json(out, compact);
+        json.BeginObject();
+
+        json.Key("terminals");
+        json.BeginArray();
+        for (const auto& terminal : terminals) {
+            json.String(terminal);
         }
-        out << "  ],\n";
+        json.EndArray();
 
-        // Write non-terminals
-        out << "  \"non_terminals\": [\n";
-        for (size_t i = 0; i < non_terminals.size(); ++i) {
-            out << "    \"" << non_terminals[i] << "\"";
-            if (i < non_terminals.size() - 1) out << ",";
-            out << "\n";
+        json.Key("non_terminals");
+        json.BeginArray();
+        for (const auto& non_terminal : non_terminals) {
+            json.String(non_terminal);
         }
-        out << "  ],\n";
+        json.EndArray();
 
-        // Write start symbol
-        out << "  \"start_symbol\": \"" << start_symbol << "\",\n";
+        json.Key("start_symbol");
+        json.String(start_symbol);
 
-        // Write productions
-        out << "  \"productions\": [\n";
-        for (size_t i = 0; i < productions.size(); ++i) {
-            out << "    {\n";
-            out << "      \"parent\": \"" << productions[i].first << "\",\n";
-            out << "      \"rules\": [\n";
-            
-            const auto& rules = productions[i].second;
-            for (size_t j = 0; j < rules.size(); ++j) {
-                out << "        [";
-                const auto& rule = rules[j];
-                for (size_t k = 0; k < rule.size(); ++k) {
-                    out << "\"" << rule[k] << "\"";
-                    if (k < rule.size() - 1) out << ", ";
+        // Each rule body stays on one line
+        json.Key("productions");
+        json.BeginArray();
+        for (const auto& production : productions) {
+            json.BeginObject();
+            json.Key("parent");
+            json.String(production.first);
+            json.Key("rules");
+            json.BeginArray();
+            for (const auto& rule : production.second) {
+                json.BeginArray(true);
+                for (const auto& symbol : rule) {
+                    json.String(symbol);
                 }
-                out << "]";
-                if (j < rules.size() - 1) out << ",";
-                out << "\n";
+                json.EndArray();
             }
-            
-            out << "      ]\n";
-            out << "    }";
-            if (i < productions.size() - 1) out << ",";
-            out << "\n";
+            json.EndArray();
+            json.EndObject();
+        }
+        json.EndArray();
+
+        // Non terminals made by the grammar transforms
+        json.Key("helpers");
+        json.BeginArray(true);
+        for (const auto& helper : generated.helpers) {
+            json.String(helper);
+        }
+        json.EndArray();
+        json.Key("loops");
+        json.BeginArray(true);
+        for (const auto& loop : generated.loops) {
+            json.String(loop);
+        }
+        json.EndArray();
+
+        json.EndObject();
+        json.Finish();
+        out.Flush();
+        if (out.Failed()) {
+            throw std::runtime_error("Failed to write output file: " + filepath);
         }
-        out << "  ]\n";
-        
-        out << "}\n";
     }
 };
 
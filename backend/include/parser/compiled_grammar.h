@@ -0,0 +1,130 @@
+#ifndef JUCC_PARSER_COMPILED_GRAMMAR_H
+#define JUCC_PARSER_COMPILED_GRAMMAR_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "grammar/grammar.h"
+#include "parser/parsing_table.h"
+
+namespace jucc::parser {
+
+/**
+ * Integer handle of an interned grammar symbol.
+ * Terminals (including the end marker) occupy [0, num_terminals) and
+ * non terminals occupy [num_terminals, num_symbols).
+ */
+using SymbolId = uint16_t;
+
+/**
+ * Global index of a rule after flattening all productions.
+ * Negative values are reserved for the special table entries below.
+ */
+using RuleId = int32_t;
+
+// Same sentinels ParsingTable uses for its (production, rule) pairs.
+constexpr RuleId kErrorEntry = -1;
+constexpr RuleId kSynchEntry = -2;
+
+// Input tokens that are not terminals of the grammar are mapped here.
+constexpr SymbolId kUnknownSymbol = 0;
+
+/**
+ * Read-only, pointer based view over the compiled tables.
+ * The driver only ever touches this struct so the same code can run over
+ * tables owned by a CompiledGrammar or tables living in a mapped file.
+ */
+struct GrammarView {
+  const SymbolId *rhs;         // all right hand sides, each stored reversed
+  const uint32_t *rhs_offset;  // rule r occupies rhs[rhs_offset[r], rhs_offset[r + 1])
+  const RuleId *table;         // dense [non_terminal - num_terminals][terminal]
+  uint32_t num_terminals;
+  uint32_t num_symbols;
+  SymbolId start_symbol;
+  SymbolId end_marker;
+
+  [[nodiscard]] bool IsTerminal(SymbolId symbol) const { return symbol < num_terminals; }
+  [[nodiscard]] RuleId Entry(SymbolId non_terminal, SymbolId terminal) const {
+    return table[static_cast<size_t>(non_terminal - num_terminals) * num_terminals + terminal];
+  }
+};
+
+class GrammarFile;
+
+class CompiledGrammar {
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, SymbolId> ids_;
+  uint32_t num_terminals_{0};
+  SymbolId start_symbol_{0};
+  SymbolId end_marker_{0};
+
+  std::vector<SymbolId> rhs_;
+  std::vector<uint32_t> rhs_offset_;
+  std::vector<SymbolId> rule_parent_;
+  std::vector<int> rule_key_;  // production_index * 100 + rule_index, as used by the json tables
+  std::vector<RuleId> table_;
+  std::vector<bool> helpers_;  // by symbol, non terminals made by the grammar transforms
+  std::vector<bool> loops_;    // by symbol, EBNF repetitions
+
+  // set when the tables live in a mapped grammar file instead of the vectors above
+  std::shared_ptr<const GrammarFile> file_;
+
+  SymbolId Intern(const std::string & /*name*/);
+
+ public:
+  CompiledGrammar() = default;
+
+  /**
+   * Interns every symbol of the grammar and flattens the productions and the
+   * parsing table into contiguous arrays.
+   * Rules consisting of a single EPSILON compile to an empty right hand side.
+   * @param productions grammar the table was built from (indices must agree)
+   * @param terminals terminals declared by the grammar, symbols found only in
+   * rule bodies are added as well
+   * @param start_symbol start symbol of the grammar
+   * @param table parsing table keyed by (non terminal, terminal)
+   * @param generated non terminals the transforms made, names that are not
+   * non terminals of productions are ignored
+   */
+  static CompiledGrammar Compile(const grammar::Productions & /*productions*/,
+                                 const std::vector<std::string> & /*terminals*/,
+                                 const std::string & /*start_symbol*/, const ParsingTable::Table & /*table*/,
+                                 const grammar::GeneratedSymbols & /*generated*/);
+
+  /**
+   * Uses the tables of a mapped grammar file in place. Only the symbol names
+   * are copied; the file stays mapped for as long as the result (or a copy
+   * of it) is alive.
+   */
+  static CompiledGrammar FromFile(std::shared_ptr<const GrammarFile> /*file*/);
+
+  /**
+   * @returns the symbol id for name or kUnknownSymbol if name is not a terminal
+   * or non terminal of this grammar.
+   */
+  [[nodiscard]] SymbolId Lookup(const std::string & /*name*/) const;
+
+  /**
+   * Maps a token stream to symbol ids, appending the end marker.
+   */
+  [[nodiscard]] std::vector<SymbolId> Encode(const std::vector<std::string> & /*tokens*/) const;
+
+  [[nodiscard]] GrammarView View() const;
+
+  [[nodiscard]] const std::string &GetName(SymbolId symbol) const { return names_[symbol]; }
+  [[nodiscard]] const std::vector<std::string> &GetNames() const { return names_; }
+  [[nodiscard]] const std::vector<bool> &GetHelperSymbols() const { return helpers_; }
+  [[nodiscard]] const std::vector<bool> &GetLoopSymbols() const { return loops_; }
+  [[nodiscard]] uint32_t GetNumTerminals() const { return num_terminals_; }
+  [[nodiscard]] uint32_t GetNumSymbols() const { return static_cast<uint32_t>(names_.size()); }
+  [[nodiscard]] size_t GetNumRules() const;
+  [[nodiscard]] SymbolId GetRuleParent(RuleId /*rule*/) const;
+  [[nodiscard]] int GetRuleKey(RuleId /*rule*/) const;
+};
+
+}  // namespace jucc::parser
+
+#endif  // JUCC_PARSER_COMPILED_GRAMMAR_H
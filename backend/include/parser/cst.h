@@ -0,0 +1,173 @@
+#ifndef JUCC_PARSER_CST_H
+#define JUCC_PARSER_CST_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../../third_party/json.hpp"
+#include "parser/compiled_grammar.h"
+#include "parser/ll_driver.h"
+
+namespace jucc::parser {
+
+using json = nlohmann::json;
+
+using NodeId = uint32_t;
+constexpr NodeId kNoNode = std::numeric_limits<NodeId>::max();
+
+// Leaf standing for the empty body of an epsilon rule.
+constexpr SymbolId kEpsilonSymbol = std::numeric_limits<SymbolId>::max();
+
+/**
+ * A node of the concrete syntax tree.
+ * Children of a node are reached through first_child and then next_sibling.
+ * token is the input position a matched terminal was read from.
+ */
+struct CstNode {
+  SymbolId symbol;
+  NodeId first_child;
+  NodeId next_sibling;
+  uint32_t token;
+};
+
+/**
+ * A node of a tree slice, see CollectSlice.
+ * depth is relative to the first node of the slice, has_children tells
+ * whether the node has children in the full tree, included or not.
+ */
+struct SliceNode {
+  NodeId id;
+  SymbolId symbol;
+  uint32_t token;
+  uint32_t depth;
+  bool has_children;
+};
+
+/**
+ * Collects node and its descendants down to max_depth levels below it, in
+ * pre-order. Source is anything with a CstNode Node(NodeId) accessor, so the
+ * same walk serves trees in memory and trees read from a file node by node.
+ * Only the nodes of the slice are visited.
+ */
+template <typename Source>
+std::vector<SliceNode> CollectSlice(Source &source, NodeId node, uint32_t max_depth) {
+  std::vector<SliceNode> slice;
+  std::vector<std::pair<NodeId, uint32_t>> pending{{node, 0}};
+  std::vector<NodeId> children;
+  while (!pending.empty()) {
+    auto [id, depth] = pending.back();
+    pending.pop_back();
+    CstNode current = source.Node(id);
+    slice.push_back({id, current.symbol, current.token, depth, current.first_child != kNoNode});
+    if (depth == max_depth) {
+      continue;
+    }
+
+    children.clear();
+    for (NodeId child = current.first_child; child != kNoNode; child = source.Node(child).next_sibling) {
+      children.push_back(child);
+    }
+    for (auto it = children.rbegin(); it != children.rend(); ++it) {
+      pending.emplace_back(*it, depth + 1);
+    }
+  }
+  return slice;
+}
+
+class ConcreteSyntaxTree {
+  /**
+   * All nodes of the tree, the root is nodes_[root_].
+   * Nodes are only ever appended, so node ids are stable.
+   */
+  std::vector<CstNode> nodes_;
+  NodeId root_{kNoNode};
+
+ public:
+  ConcreteSyntaxTree() = default;
+
+  void Clear() {
+    nodes_.clear();
+    root_ = kNoNode;
+  }
+  void Reserve(size_t count) { nodes_.reserve(count); }
+
+  /**
+   * Appends count nodes without links and returns the id of the first one.
+   */
+  NodeId AddNodes(size_t count) {
+    auto first = static_cast<NodeId>(nodes_.size());
+    nodes_.resize(nodes_.size() + count, CstNode{0, kNoNode, kNoNode, kNoNode});
+    return first;
+  }
+
+  [[nodiscard]] bool Empty() const { return root_ == kNoNode; }
+  [[nodiscard]] size_t Size() const { return nodes_.size(); }
+  [[nodiscard]] NodeId Root() const { return root_; }
+  void SetRoot(NodeId root) { root_ = root; }
+  [[nodiscard]] const CstNode &Node(NodeId id) const { return nodes_[id]; }
+  CstNode &Node(NodeId id) { return nodes_[id]; }
+  [[nodiscard]] const std::vector<CstNode> &GetNodes() const { return nodes_; }
+
+  /**
+   * node and its descendants down to max_depth levels below it, for serving
+   * huge trees a few levels at a time.
+   */
+  [[nodiscard]] std::vector<SliceNode> GetSlice(NodeId node, uint32_t max_depth) const {
+    return CollectSlice(*this, node, max_depth);
+  }
+
+  /**
+   * Display name of symbol, names is indexed by SymbolId.
+   */
+  static const std::string &SymbolName(const std::vector<std::string> & /*names*/, SymbolId /*symbol*/);
+
+  /**
+   * Exports the tree keyed by symbol name in the format of
+   * Parser::BuildParseTree, e.g. { "E": { "T": {...}, "+": null } }.
+   * Repeated symbols among siblings are renamed A, A_1, A_2, ...
+   */
+  [[nodiscard]] json ToJson(const std::vector<std::string> & /*names*/) const;
+
+  /**
+   * Exports the tree in Treant.js format,
+   * { "text": { "name": "E" }, "children": [ ... ] }, children in rule order.
+   */
+  [[nodiscard]] json ToTreantJson(const std::vector<std::string> & /*names*/) const;
+
+  /**
+   * LLDriver listener that grows the tree while the input is parsed.
+   * It keeps a node id for every entry of the parse stack; expanding a
+   * non terminal appends the rule body as one contiguous block of children.
+   *
+   * The symbols flagged in loops (see CompiledGrammar::GetLoopSymbols) are EBNF repetitions:
+   * a rule of theirs ending in themselves is one iteration, whose body is
+   * appended to the children of the node the loop started in instead of
+   * nesting a new node per iteration, and leaving the loop adds nothing
+   * once it has iterated. A list of n items is one node with n children.
+   */
+  struct Builder {
+    const GrammarView &grammar;
+    ConcreteSyntaxTree &tree;
+    const std::vector<bool> *loops;
+    std::vector<NodeId> nodes;                      // parallel to the parse stack
+    std::vector<std::pair<NodeId, NodeId>> tails;  // open loop nodes and their last child, innermost last
+
+    Builder(const GrammarView &grammar, ConcreteSyntaxTree &tree, const std::vector<bool> *loops = nullptr);
+
+    void OnMatch(const SymbolId * /*stack*/, size_t /*depth*/, size_t pos) {
+      tree.Node(nodes.back()).token = static_cast<uint32_t>(pos);
+      nodes.pop_back();
+    }
+    void OnExpand(const SymbolId * /*stack*/, size_t /*depth*/, size_t /*pos*/, RuleId rule);
+    void OnSynch(const SymbolId * /*stack*/, size_t /*depth*/, size_t /*pos*/) { nodes.pop_back(); }
+    void OnError(const SymbolId * /*stack*/, size_t /*depth*/, size_t /*pos*/, ParseError /*error*/) {}
+    void OnAccept(const SymbolId * /*stack*/, size_t /*depth*/, size_t /*pos*/) {}
+  };
+};
+
+}  // namespace jucc::parser
+
+#endif  // JUCC_PARSER_CST_H
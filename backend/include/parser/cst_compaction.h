@@ -0,0 +1,54 @@
+#ifndef JUCC_PARSER_CST_COMPACTION_H
+#define JUCC_PARSER_CST_COMPACTION_H
+
+#include <vector>
+
+#include "parser/cst.h"
+
+namespace jucc::parser {
+
+struct CompactionOptions {
+  /**
+   * Removes the EPSILON leaves of epsilon rules.
+   */
+  bool drop_epsilon{false};
+
+  /**
+   * Splices the children of non terminals made by the grammar transforms
+   * (EBNF helpers, left recursion and left factoring tails such as E_prime)
+   * into their parent, so that E -> T E_prime -> + T E_prime reads
+   * E -> T + T.
+   */
+  bool fold_helpers{false};
+
+  /**
+   * Replaces a non terminal with a single child by that child, so that a
+   * chain E -> T -> F -> id becomes id.
+   */
+  bool collapse_unary{false};
+
+  /**
+   * All passes enabled.
+   */
+  static CompactionOptions All() { return {true, true, true}; }
+
+  [[nodiscard]] bool Enabled() const { return drop_epsilon || fold_helpers || collapse_unary; }
+};
+
+class TreeCompactor {
+ public:
+  /**
+   * Returns a compacted copy of tree; the tree itself is left untouched so
+   * that every export can use its own options.
+   * Passes are applied bottom up in a single iterative walk, memory besides
+   * the result is O(tree depth). Matched terminals keep their token.
+   * @param helpers the symbols fold_helpers splices, indexed by SymbolId,
+   * see CompiledGrammar::GetHelperSymbols
+   */
+  static ConcreteSyntaxTree Compact(const ConcreteSyntaxTree & /*tree*/, const std::vector<bool> & /*helpers*/,
+                                    const CompactionOptions & /*options*/);
+};
+
+}  // namespace jucc::parser
+
+#endif  // JUCC_PARSER_CST_COMPACTION_H
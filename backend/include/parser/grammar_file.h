@@ -0,0 +1,162 @@
+#ifndef JUCC_PARSER_GRAMMAR_FILE_H
+#define JUCC_PARSER_GRAMMAR_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "grammar/grammar.h"
+#include "parser/compiled_grammar.h"
+#include "utils/first_follow.h"
+#include "utils/mapped_file.h"
+
+namespace jucc::parser {
+
+/**
+ * Compiled grammar file (.jgb).
+ *
+ * Everything a parser needs, already in the integer form of CompiledGrammar:
+ * the interned symbols with a hash index for lookups, the flattened rules,
+ * the dense parsing table and FIRST / FOLLOW as bitsets over terminal ids.
+ * Every section is 8 byte aligned, so once the file is mapped the arrays
+ * are used in place and nothing is parsed. A mapped file is read-only and
+ * shared by every process that maps it.
+ *
+ * Layout (little endian):
+ *   header   : "JCGB", version, file_size, checksum, num_symbols, num_terminals,
+ *              num_rules, num_rhs, start_symbol, end_marker, hash_capacity,
+ *              set_words, u64 section_offset[GRAMMAR_FILE_SECTIONS]
+ *   sections : name_offset u32[num_symbols + 1], name bytes,
+ *              name_hash u32[hash_capacity] (symbol + 1, 0 is empty),
+ *              rhs_offset u32[num_rules + 1], rhs u16[num_rhs],
+ *              rule_parent u16[num_rules], rule_key i32[num_rules],
+ *              rule_text_offset u32[num_rules + 1], rule text bytes,
+ *              table i32[num_non_terminals * num_terminals],
+ *              first u64[num_non_terminals * set_words], follow (same),
+ *              nullable u64[(num_non_terminals + 63) / 64],
+ *              symbol_flags u8[num_symbols]
+ * The checksum covers every byte after the header.
+ */
+constexpr char GRAMMAR_FILE_MAGIC[] = "JCGB";
+constexpr uint32_t GRAMMAR_FILE_VERSION = 2;
+constexpr size_t GRAMMAR_FILE_SECTIONS = 14;
+
+/**
+ * Bits of the symbol_flags section.
+ */
+constexpr uint8_t SYMBOL_HELPER = 1U << 0;  // non terminal made by the grammar transforms
+constexpr uint8_t SYMBOL_LOOP = 1U << 1;    // EBNF repetition, see ConcreteSyntaxTree::Builder
+
+/**
+ * Writes grammar to filepath.
+ * @param productions productions grammar was compiled from, their rule
+ * bodies are kept as display text
+ * @param firsts FIRST sets, EPSILON marks a nullable non terminal
+ * @param follows FOLLOW sets
+ * @returns false if the file could not be written
+ */
+bool WriteGrammarFile(const std::string & /*filepath*/, const CompiledGrammar & /*grammar*/,
+                      const grammar::Productions & /*productions*/, const utils::SymbolsMap & /*firsts*/,
+                      const utils::SymbolsMap & /*follows*/);
+
+class GrammarFile {
+  utils::MappedFile file_;
+  GrammarView view_{};
+  uint32_t num_rules_{0};
+  uint32_t hash_capacity_{0};
+  uint32_t set_words_{0};
+
+  const uint32_t *name_offset_{nullptr};
+  const char *names_{nullptr};
+  const uint32_t *name_hash_{nullptr};
+  const SymbolId *rule_parent_{nullptr};
+  const int32_t *rule_key_{nullptr};
+  const uint32_t *rule_text_offset_{nullptr};
+  const char *rule_text_{nullptr};
+  const uint64_t *first_{nullptr};
+  const uint64_t *follow_{nullptr};
+  const uint64_t *nullable_{nullptr};
+  const uint8_t *symbol_flags_{nullptr};
+  uint64_t name_bytes_{0};
+  uint64_t rule_text_bytes_{0};
+  uint32_t num_rhs_{0};
+  uint64_t checksum_{0};
+  std::string path_;
+  std::string error_;
+
+  bool Fail(const std::string & /*what*/);
+  bool Validate(uint64_t /*name_bytes*/, uint64_t /*rule_text_bytes*/, uint32_t /*num_rhs*/);
+
+  static bool TestBit(const uint64_t *bits, size_t bit) { return ((bits[bit / 64] >> (bit % 64)) & 1U) != 0; }
+
+ public:
+  GrammarFile() = default;
+
+  /**
+   * Maps filepath and checks its header and that every section lies within
+   * the file. Nothing is read past the header, so opening takes the same
+   * time whatever the size of the grammar.
+   * @returns false and sets error_ on a missing or malformed file
+   */
+  bool Open(const std::string & /*filepath*/);
+
+  /**
+   * Checks the checksum of an open file and that every symbol, rule and
+   * table entry in it is in range; the driver and the accessors trust them
+   * otherwise. Reads the whole file, meant for files of unknown origin.
+   * @returns false and sets error_ on a corrupt file
+   */
+  bool Verify();
+
+  /**
+   * Driver view of the tables, pointing into the mapping.
+   */
+  [[nodiscard]] GrammarView View() const { return view_; }
+
+  /**
+   * @returns the symbol id for name or kUnknownSymbol, without building
+   * any index in memory.
+   */
+  [[nodiscard]] SymbolId Lookup(std::string_view /*name*/) const;
+
+  [[nodiscard]] std::string_view GetName(SymbolId symbol) const {
+    return {names_ + name_offset_[symbol], name_offset_[symbol + 1] - name_offset_[symbol]};
+  }
+
+  /**
+   * Right hand side of rule as written in the grammar, e.g. "T E'" or "EPSILON".
+   */
+  [[nodiscard]] std::string_view GetRuleText(RuleId rule) const {
+    return {rule_text_ + rule_text_offset_[rule], rule_text_offset_[rule + 1] - rule_text_offset_[rule]};
+  }
+
+  /**
+   * SYMBOL_* bits of symbol.
+   */
+  [[nodiscard]] uint8_t GetSymbolFlags(SymbolId symbol) const { return symbol_flags_[symbol]; }
+
+  [[nodiscard]] SymbolId GetRuleParent(RuleId rule) const { return rule_parent_[rule]; }
+  [[nodiscard]] int GetRuleKey(RuleId rule) const { return rule_key_[rule]; }
+
+  /**
+   * Set membership for a non terminal and a terminal, both as symbol ids.
+   */
+  [[nodiscard]] bool InFirst(SymbolId non_terminal, SymbolId terminal) const {
+    return TestBit(first_ + static_cast<size_t>(non_terminal - view_.num_terminals) * set_words_, terminal);
+  }
+  [[nodiscard]] bool InFollow(SymbolId non_terminal, SymbolId terminal) const {
+    return TestBit(follow_ + static_cast<size_t>(non_terminal - view_.num_terminals) * set_words_, terminal);
+  }
+  [[nodiscard]] bool IsNullable(SymbolId non_terminal) const {
+    return TestBit(nullable_, non_terminal - view_.num_terminals);
+  }
+
+  [[nodiscard]] uint32_t GetNumSymbols() const { return view_.num_symbols; }
+  [[nodiscard]] uint32_t GetNumTerminals() const { return view_.num_terminals; }
+  [[nodiscard]] uint32_t GetNumRules() const { return num_rules_; }
+  [[nodiscard]] const std::string &GetError() const { return error_; }
+};
+
+}  // namespace jucc::parser
+
+#endif  // JUCC_PARSER_GRAMMAR_FILE_H
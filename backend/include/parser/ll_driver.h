@@ -0,0 +1,172 @@
+#ifndef JUCC_PARSER_LL_DRIVER_H
+#define JUCC_PARSER_LL_DRIVER_H
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+#include "parser/compiled_grammar.h"
+
+namespace jucc::parser {
+
+enum class ParseError { NONE, NO_RULE, TERMINAL_MISMATCH, INPUT_EXHAUSTED };
+
+/**
+ * Listener interface of LLDriver::Parse.
+ * Every callback receives the stack (bottom at index 0) exactly as it was
+ * before the action is applied, together with the current input position.
+ * The driver is a template over the listener so that empty callbacks cost
+ * nothing; NullListener is what production parses use.
+ */
+struct NullListener {
+  void OnMatch(const SymbolId * /*stack*/, size_t /*depth*/, size_t /*pos*/) {}
+  void OnExpand(const SymbolId * /*stack*/, size_t /*depth*/, size_t /*pos*/, RuleId /*rule*/) {}
+  void OnSynch(const SymbolId * /*stack*/, size_t /*depth*/, size_t /*pos*/) {}
+  void OnError(const SymbolId * /*stack*/, size_t /*depth*/, size_t /*pos*/, ParseError /*error*/) {}
+  void OnAccept(const SymbolId * /*stack*/, size_t /*depth*/, size_t /*pos*/) {}
+};
+
+/**
+ * Forwards every callback to two listeners, e.g. a trace recorder and a
+ * tree builder.
+ */
+template <typename First, typename Second>
+struct TeeListener {
+  First &first;
+  Second &second;
+
+  void OnMatch(const SymbolId *stack, size_t depth, size_t pos) {
+    first.OnMatch(stack, depth, pos);
+    second.OnMatch(stack, depth, pos);
+  }
+  void OnExpand(const SymbolId *stack, size_t depth, size_t pos, RuleId rule) {
+    first.OnExpand(stack, depth, pos, rule);
+    second.OnExpand(stack, depth, pos, rule);
+  }
+  void OnSynch(const SymbolId *stack, size_t depth, size_t pos) {
+    first.OnSynch(stack, depth, pos);
+    second.OnSynch(stack, depth, pos);
+  }
+  void OnError(const SymbolId *stack, size_t depth, size_t pos, ParseError error) {
+    first.OnError(stack, depth, pos, error);
+    second.OnError(stack, depth, pos, error);
+  }
+  void OnAccept(const SymbolId *stack, size_t depth, size_t pos) {
+    first.OnAccept(stack, depth, pos);
+    second.OnAccept(stack, depth, pos);
+  }
+};
+
+class LLDriver {
+  /**
+   * Parse stack of symbol ids, reused across calls to avoid reallocations.
+   */
+  std::vector<SymbolId> stack_;
+
+  /**
+   * Number of match / expand / synch steps performed by the last parse.
+   */
+  size_t steps_{0};
+
+  ParseError error_{ParseError::NONE};
+
+ public:
+  LLDriver() = default;
+
+  /**
+   * Runs the table driven LL(1) algorithm over input.
+   * @param grammar compiled tables
+   * @param input encoded tokens, must be terminated by grammar.end_marker
+   * @param length number of entries in input
+   * @returns true if the input is accepted
+   */
+  template <typename Listener>
+  bool Parse(const GrammarView &grammar, const SymbolId *input, size_t length, Listener &listener);
+
+  bool Parse(const GrammarView &grammar, const SymbolId *input, size_t length) {
+    NullListener listener;
+    return Parse(grammar, input, length, listener);
+  }
+
+  [[nodiscard]] size_t GetSteps() const { return steps_; }
+  [[nodiscard]] ParseError GetError() const { return error_; }
+};
+
+template <typename Listener>
+bool LLDriver::Parse(const GrammarView &grammar, const SymbolId *input, size_t length, Listener &listener) {
+  if (stack_.size() < 64) {
+    stack_.resize(64);
+  }
+  SymbolId *stack = stack_.data();
+  size_t capacity = stack_.size();
+  size_t depth = 0;
+  size_t pos = 0;
+  size_t steps = 0;
+
+  stack[depth++] = grammar.end_marker;
+  stack[depth++] = grammar.start_symbol;
+  error_ = ParseError::INPUT_EXHAUSTED;
+
+  while (pos < length) {
+    SymbolId top = stack[depth - 1];
+    SymbolId token = input[pos];
+
+    if (top == token) {
+      if (top == grammar.end_marker) {
+        listener.OnAccept(stack, depth, pos);
+        error_ = ParseError::NONE;
+        break;
+      }
+      listener.OnMatch(stack, depth, pos);
+      --depth;
+      ++pos;
+      ++steps;
+      continue;
+    }
+
+    if (grammar.IsTerminal(top)) {
+      listener.OnError(stack, depth, pos, ParseError::TERMINAL_MISMATCH);
+      error_ = ParseError::TERMINAL_MISMATCH;
+      break;
+    }
+
+    RuleId rule = grammar.Entry(top, token);
+    if (rule == kErrorEntry) {
+      listener.OnError(stack, depth, pos, ParseError::NO_RULE);
+      error_ = ParseError::NO_RULE;
+      break;
+    }
+    ++steps;
+    if (rule == kSynchEntry) {
+      listener.OnSynch(stack, depth, pos);
+      --depth;
+      continue;
+    }
+
+    listener.OnExpand(stack, depth, pos, rule);
+    uint32_t begin = grammar.rhs_offset[rule];
+    uint32_t count = grammar.rhs_offset[rule + 1] - begin;
+    if (count != 0 && grammar.rhs[begin] == top) {
+      // a rule ending in its own parent is one more iteration of a loop:
+      // the parent stays where it is and only the body above it is pushed
+      ++begin;
+      --count;
+    } else {
+      --depth;
+    }
+    if (depth + count > capacity) {
+      stack_.resize(2 * (depth + count));
+      stack = stack_.data();
+      capacity = stack_.size();
+    }
+    std::memcpy(stack + depth, grammar.rhs + begin, count * sizeof(SymbolId));
+    depth += count;
+  }
+
+  steps_ = steps;
+  return error_ == ParseError::NONE;
+}
+
+}  // namespace jucc::parser
+
+#endif  // JUCC_PARSER_LL_DRIVER_H
@@ -3,71 +3,105 @@
 
 #include <string>
 #include <vector>
-#include <stack>
 #include <unordered_map>
 #include <fstream>
 #include <algorithm>
+#include <memory>
+#include "parser/compiled_grammar.h"
+#include "parser/cst.h"
+#include "parser/cst_compaction.h"
+#include "parser/ll_driver.h"
+#include "parser/parse_trace.h"
 #include "parser/parsing_table.h"
 
 namespace jucc::parser {
 
+// Everything a parse reads from its grammar, never changed once built; parsers of the same
+// grammar share one (see LLParser::GetGrammar) and only keep the state of their own parse
+struct LLGrammar {
+    CompiledGrammar compiled;               // integer form of the grammar and table used by the driver
+    std::vector<std::string> rule_actions;  // trace action string for each compiled rule
+};
+
 class LLParser {
 public:
+    // One step of the parse as shown to the user
+    using TraceEntry = parser::TraceEntry;
+
     LLParser() = default;
 
+    // Parser over a grammar another parser was initialized with, nothing of it is copied
+    explicit LLParser(std::shared_ptr<const LLGrammar> grammar) : grammar_(std::move(grammar)) {}
+
     // Initialize the parser with grammar and parsing table
     bool Initialize(std::ifstream& grammar_file, std::ifstream& table_file);
 
+    // Initialize from a grammar and table already in memory, e.g. straight from ParsingTable;
+    // generated names the non terminals the grammar transforms made
+    bool Initialize(grammar::Productions productions, std::vector<std::string> terminals,
+                    std::vector<std::string> non_terminals, std::string start_symbol,
+                    ParsingTable::Table parsing_table, const grammar::GeneratedSymbols& generated);
+
+    // Initialize from a compiled grammar file (see grammar_file.h), the tables are used in place;
+    // verify checks the whole file first, see GrammarFile::Verify
+    bool LoadGrammarFile(const std::string& filepath, bool verify = false);
+
+    // Grammar set by the last Initialize or LoadGrammarFile, null before
+    const std::shared_ptr<const LLGrammar>& GetGrammar() const { return grammar_; }
+
     // Parse the input tokens
     bool Parse(const std::vector<std::string>& input_tokens);
 
-    // Write parsing trace to JSON file
-    void DumpTraceAsJson(std::ofstream& out_file) const;
+    // Write parsing trace to JSON file, compact drops all whitespace;
+    // this and every other Dump/Write/Get below fail or return nothing before initialization
+    bool DumpTraceAsJson(std::ofstream& out_file, bool compact = false) const;
+
+    // Trace recording, TraceLevel::OFF parses without any bookkeeping
+    void SetTraceLevel(TraceLevel level) { trace_.SetLevel(level); }
+    const ParseTrace& GetTrace() const { return trace_; }
+    size_t GetTraceSize() const { return trace_.Size(); }
+
+    // Rebuild a single step of the trace, including its full stack
+    TraceEntry GetTraceEntry(size_t step) const;
+
+    // Write the trace as a chunked file that supports random access (see trace_file.h)
+    bool DumpTraceFile(const std::string& filepath, uint32_t checkpoint_interval = 256) const;
     
-    // Generate and write parse tree to JSON file
-    void DumpTreeAsJson(std::ofstream& out_file) const;
+    // Write the parse tree to JSON file in Treant.js format
+    bool DumpTreeAsJson(std::ofstream& out_file) const;
+
+    // Stream the parse tree in Treant.js format to filepath, compact drops all whitespace
+    // and compaction optionally simplifies the tree for this export only
+    bool WriteParseTree(const std::string& filepath, bool compact = false,
+                        const CompactionOptions& compaction = CompactionOptions()) const;
+
+    // Write the parse tree as a node file that serves slices on demand (see tree_file.h)
+    bool DumpTreeFile(const std::string& filepath,
+                      const CompactionOptions& compaction = CompactionOptions()) const;
+
+    // Parse tree, built by the driver during Parse unless disabled
+    void SetBuildTree(bool build_tree) { build_tree_ = build_tree; }
+    const ConcreteSyntaxTree& GetTree() const { return tree_; }
+    const std::vector<std::string>& GetSymbolNames() const;
 
 private:
-    // Grammar components
-    using Rule = std::vector<std::string>;
-    using Rules = std::vector<Rule>;
-    using Productions = std::unordered_map<std::string, Rules>;
-    
-    Productions productions_;
-    std::string start_symbol_;
-    std::vector<std::string> terminals_;
-    std::vector<std::string> non_terminals_;
-
-    // Parsing table
-    using TableEntry = std::pair<int, int>;
-    std::unordered_map<std::string, std::unordered_map<std::string, TableEntry>> parsing_table_;
-
-    // Parsing trace for debugging/visualization
-    struct TraceEntry {
-        std::string stack_top;
-        std::vector<std::string> full_stack;
-        std::string current_input;
-        std::string action;  // "match", "expand", "error", or production rule
-    };
-    std::vector<TraceEntry> parse_trace_;
-    
-    // Parse tree structure
-    struct TreeNode {
-        std::string symbol;
-        std::vector<TreeNode> children;
-    };
-    TreeNode parse_tree_;
+    std::shared_ptr<const LLGrammar> grammar_;
+    LLDriver driver_;
+
+    // Parsing trace for debugging/visualization, stored as events
+    ParseTrace trace_;
+    std::vector<std::string> trace_input_;
     
+    // Parse tree
+    ConcreteSyntaxTree tree_;
+    bool build_tree_{true};
+
     // Helper functions
-    void AddTraceEntry(const std::string& stack_top, const std::vector<std::string>& full_stack,
-                     const std::string& current_input, const std::string& action);
-    std::vector<std::string> GetStackContents(std::stack<std::string> stack_copy) const;
+    TraceEntry MakeTraceEntry(const TraceEvent& event, const std::vector<SymbolId>& stack) const;
+    std::vector<std::string> GetStackContents(const std::vector<SymbolId>& stack) const;
     bool IsTerminal(const std::string& symbol) const;
     bool IsNonTerminal(const std::string& symbol) const;
-    std::string GetProductionString(const std::string& non_terminal, const std::vector<std::string>& rule) const;
-    
-    // Helper function to build the parse tree from the trace
-    void BuildParseTree();
+
 };
 
 } // namespace jucc::parser
@@ -0,0 +1,125 @@
+#ifndef JUCC_PARSER_PARSE_TRACE_H
+#define JUCC_PARSER_PARSE_TRACE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "parser/compiled_grammar.h"
+#include "parser/ll_driver.h"
+#include "utils/json_emitter.h"
+
+namespace jucc::parser {
+
+/**
+ * How much of a parse is recorded.
+ * OFF     - nothing, the driver runs with a NullListener.
+ * ACTIONS - one small event per step, stacks are rebuilt by replaying from
+ *           the start of the parse.
+ * FULL    - events plus a stack checkpoint every few steps so that the
+ *           stack of any step can be rebuilt by replaying at most that many
+ *           events.
+ */
+enum class TraceLevel { OFF, ACTIONS, FULL };
+
+enum class TraceAction : uint8_t { MATCH, EXPAND, SYNCH, ERROR_NO_RULE, ERROR_MISMATCH, ACCEPT };
+
+/**
+ * A single step of the parse. The stack is not stored, it is implied by the
+ * events before it.
+ */
+struct TraceEvent {
+  TraceAction action;
+  SymbolId stack_top;
+  uint32_t input_pos;
+  RuleId rule;  // only meaningful for EXPAND
+};
+
+/**
+ * A single step of the parse in the form shown to the user and written to
+ * parse_trace.json.
+ */
+struct TraceEntry {
+  std::string stack_top;
+  std::vector<std::string> full_stack;
+  std::string current_input;
+  std::string action;  // "match", "expand", "error", or production rule
+};
+
+/**
+ * @returns the trace action string for every action except EXPAND, whose
+ * string is the production that was applied.
+ */
+const char *TraceActionName(TraceAction /*action*/);
+
+/**
+ * Writes entry as one element of the parse_trace.json array.
+ */
+void WriteTraceEntryJson(utils::JsonEmitter & /*json*/, const TraceEntry & /*entry*/);
+
+class ParseTrace {
+  std::vector<TraceEvent> events_;
+
+  /**
+   * Stack snapshots taken before every checkpoint_interval_'th event.
+   * Snapshot i starts at checkpoint_stack_[checkpoint_offset_[i]].
+   */
+  std::vector<SymbolId> checkpoint_stack_;
+  std::vector<uint32_t> checkpoint_offset_;
+  uint32_t checkpoint_interval_{256};
+  TraceLevel level_{TraceLevel::FULL};
+
+  void Record(TraceAction action, const SymbolId *stack, size_t depth, size_t pos, RuleId rule);
+
+ public:
+  ParseTrace() = default;
+
+  void Clear();
+  void SetLevel(TraceLevel level) { level_ = level; }
+  void SetCheckpointInterval(uint32_t interval) { checkpoint_interval_ = interval == 0 ? 1 : interval; }
+  [[nodiscard]] TraceLevel GetLevel() const { return level_; }
+  [[nodiscard]] uint32_t GetCheckpointInterval() const { return checkpoint_interval_; }
+  [[nodiscard]] size_t Size() const { return events_.size(); }
+  [[nodiscard]] const TraceEvent &At(size_t step) const { return events_[step]; }
+  [[nodiscard]] const std::vector<TraceEvent> &GetEvents() const { return events_; }
+
+  /**
+   * Applies the effect of event on stack, e.g. pops the matched terminal or
+   * replaces the expanded non terminal by the rule body.
+   */
+  static void Apply(const GrammarView & /*grammar*/, const TraceEvent & /*event*/, std::vector<SymbolId> & /*stack*/);
+
+  /**
+   * Rebuilds the stack (bottom first) as it was before step was applied.
+   * Costs at most one checkpoint interval of replay at TraceLevel::FULL.
+   */
+  [[nodiscard]] std::vector<SymbolId> StackAt(const GrammarView & /*grammar*/, size_t /*step*/) const;
+
+  /**
+   * LLDriver listener appending to this trace.
+   */
+  struct Recorder {
+    ParseTrace &trace;
+
+    void OnMatch(const SymbolId *stack, size_t depth, size_t pos) {
+      trace.Record(TraceAction::MATCH, stack, depth, pos, kErrorEntry);
+    }
+    void OnExpand(const SymbolId *stack, size_t depth, size_t pos, RuleId rule) {
+      trace.Record(TraceAction::EXPAND, stack, depth, pos, rule);
+    }
+    void OnSynch(const SymbolId *stack, size_t depth, size_t pos) {
+      trace.Record(TraceAction::SYNCH, stack, depth, pos, kErrorEntry);
+    }
+    void OnError(const SymbolId *stack, size_t depth, size_t pos, ParseError error) {
+      trace.Record(error == ParseError::NO_RULE ? TraceAction::ERROR_NO_RULE : TraceAction::ERROR_MISMATCH, stack,
+                   depth, pos, kErrorEntry);
+    }
+    void OnAccept(const SymbolId *stack, size_t depth, size_t pos) {
+      trace.Record(TraceAction::ACCEPT, stack, depth, pos, kErrorEntry);
+    }
+  };
+};
+
+}  // namespace jucc::parser
+
+#endif  // JUCC_PARSER_PARSE_TRACE_H
@@ -27,15 +27,24 @@ public:
     // Get an entry from the table
     std::pair<int, int> GetEntry(const std::string& non_terminal, const std::string& terminal);
 
-    // Dump table to JSON file
-    void DumpAsJson(const std::string& filepath) const;
+    // Dump table to JSON file, compact drops all whitespace.
+    // Rows and columns follow the declaration order of non-terminals and terminals.
+    void DumpAsJson(const std::string& filepath, bool compact = false) const;
+
+    // Dump only the non-error cells, in the same order:
+    // { "format": "sparse", "terminals": [...],
+    //   "rows": { "E": { "cells": { "id": 301 }, "synch": ["$", ")"] }, ... } }
+    // Cells hold production * 100 + rule, missing cells are errors.
+    void DumpAsSparseJson(const std::string& filepath, bool compact = false) const;
 
     // Error handling
     std::string GenerateErrorMessage(const std::string& production, const std::string& symbol);
 
     // Getters and setters
     const Table& GetTable() const { return table_; }
+    const std::vector<std::string>& GetErrors() const { return errors_; }
     void SetTable(const Table& table) { table_ = table; }
+    void SetErrors(const std::vector<std::string>& errors) { errors_ = errors; }
     void SetProductions(const std::vector<grammar::Production>& productions) { productions_ = productions; }
     void SetFirsts(const std::unordered_map<std::string, std::vector<std::string>>& firsts) { firsts_ = firsts; }
     void SetFollows(const std::unordered_map<std::string, std::vector<std::string>>& follows) { follows_ = follows; }
@@ -43,6 +52,10 @@ public:
     void SetNonTerminals(const std::vector<std::string>& non_terminals) { non_terminals_ = non_terminals; }
 
 private:
+    // Declared non-terminals / terminals first, then any other row / column sorted by name
+    std::vector<std::string> RowOrder() const;
+    std::vector<std::string> ColumnOrder() const;
+
     Table table_;
     std::vector<std::string> terminals_;
     std::vector<std::string> non_terminals_;
@@ -0,0 +1,94 @@
+#ifndef JUCC_PARSER_TRACE_FILE_H
+#define JUCC_PARSER_TRACE_FILE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "parser/compiled_grammar.h"
+#include "parser/parse_trace.h"
+
+namespace jucc::parser {
+
+/**
+ * Chunked, random access trace file (.jtr).
+ *
+ * The trace is cut in chunks of `interval` steps. Every chunk starts with a
+ * snapshot of the stack before its first step, followed by the events of
+ * the chunk. An index of chunk offsets is written at the end, so any step
+ * is reached by one seek and at most `interval` replayed events.
+ * The grammar tables needed for replay and the strings needed for display
+ * (symbol names, rule actions, input tokens) are stored in the same file.
+ *
+ * Layout (little endian):
+ *   header  : "JTRC", version, interval, num_chunks, num_steps,
+ *             names_offset, rules_offset, tokens_offset, index_offset
+ *   chunk*  : u32 depth, u16 stack[depth], u32 count, event[count]
+ *   names   : u32 count, (u32 length, bytes)*
+ *   rules   : u32 count, u32 rhs_offset[count + 1], u16 rhs[], (u32 length, bytes)* actions
+ *   tokens  : u32 count, u32 offset[count + 1], bytes
+ *   index   : u64 chunk_offset[num_chunks]
+ */
+constexpr char TRACE_FILE_MAGIC[] = "JTRC";
+constexpr uint32_t TRACE_FILE_VERSION = 1;
+
+/**
+ * Writes trace to filepath in the chunked format.
+ * @param rule_actions display string of each compiled rule
+ * @param input input tokens the trace positions refer to
+ * @returns false if the file could not be written
+ */
+bool WriteTraceFile(const std::string & /*filepath*/, const ParseTrace & /*trace*/,
+                    const CompiledGrammar & /*grammar*/, const std::vector<std::string> & /*rule_actions*/,
+                    const std::vector<std::string> & /*input*/, uint32_t /*interval*/);
+
+class TraceFileReader {
+  std::ifstream file_;
+  uint32_t interval_{0};
+  uint64_t num_steps_{0};
+  uint64_t tokens_offset_{0};
+  uint64_t size_{0};  // of the file, every offset read from it is checked against it
+  uint32_t num_tokens_{0};
+
+  std::vector<std::string> names_;
+  std::vector<std::string> actions_;
+  std::vector<uint32_t> rhs_offset_;
+  std::vector<SymbolId> rhs_;
+  std::vector<uint64_t> chunk_offset_;
+  std::string error_;
+
+  std::string ReadToken(uint32_t /*pos*/);
+
+ public:
+  TraceFileReader() = default;
+
+  /**
+   * Reads the header, string tables and chunk index. Events are not loaded.
+   * @returns false and sets error_ on a missing, truncated or malformed
+   * file; nothing is allocated for a count the file is too small to hold
+   */
+  bool Open(const std::string & /*filepath*/);
+
+  /**
+   * Rebuilds steps [from, to), clamped to the number of steps.
+   * Costs one seek plus at most one chunk of replay before the first step.
+   */
+  std::vector<TraceEntry> Read(uint64_t /*from*/, uint64_t /*to*/);
+
+  /**
+   * Rebuilds the single step n.
+   */
+  TraceEntry Seek(uint64_t step) {
+    auto entries = Read(step, step + 1);
+    return entries.empty() ? TraceEntry() : entries[0];
+  }
+
+  [[nodiscard]] uint64_t GetNumSteps() const { return num_steps_; }
+  [[nodiscard]] uint32_t GetInterval() const { return interval_; }
+  [[nodiscard]] const std::string &GetError() const { return error_; }
+};
+
+}  // namespace jucc::parser
+
+#endif  // JUCC_PARSER_TRACE_FILE_H
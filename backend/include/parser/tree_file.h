@@ -0,0 +1,80 @@
+#ifndef JUCC_PARSER_TREE_FILE_H
+#define JUCC_PARSER_TREE_FILE_H
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "parser/cst.h"
+#include "utils/output_buffer.h"
+
+namespace jucc::parser {
+
+/**
+ * Random access parse tree file (.jst).
+ *
+ * Nodes are stored as fixed size records indexed by node id, so a node is
+ * one seek away and a slice of the tree is served without loading the rest.
+ * Writing is a straight copy of the node array, no JSON is produced.
+ *
+ * Layout (little endian):
+ *   header : "JCST", version, num_nodes, root, names_offset
+ *   nodes  : (u16 symbol, u16 reserved, u32 first_child, u32 next_sibling, u32 token)[num_nodes]
+ *   names  : u32 count, (u32 length, bytes)*
+ */
+constexpr char TREE_FILE_MAGIC[] = "JCST";
+constexpr uint32_t TREE_FILE_VERSION = 1;
+
+/**
+ * Writes tree to filepath, names is indexed by SymbolId.
+ * @returns false if the file could not be written
+ */
+bool WriteTreeFile(const std::string & /*filepath*/, const ConcreteSyntaxTree & /*tree*/,
+                   const std::vector<std::string> & /*names*/);
+
+/**
+ * Writes the same bytes to out, e.g. to hand the tree over in memory.
+ * Flushes out; check out.Failed() for the result.
+ */
+void WriteTreeFile(utils::OutputBuffer & /*out*/, const ConcreteSyntaxTree & /*tree*/,
+                   const std::vector<std::string> & /*names*/);
+
+class TreeFileReader {
+  std::ifstream file_;
+  uint32_t num_nodes_{0};
+  NodeId root_{kNoNode};
+  std::vector<std::string> names_;
+  std::string error_;
+
+ public:
+  TreeFileReader() = default;
+
+  /**
+   * Reads the header and the symbol names, and checks every node once:
+   * symbols must be named or kEpsilonSymbol, links must be nodes or kNoNode
+   * and form a forest. Nodes are not kept.
+   * @returns false and sets error_ on a missing, truncated or malformed
+   * file; nothing is allocated for a count the file is too small to hold
+   */
+  bool Open(const std::string & /*filepath*/);
+
+  /**
+   * Reads a single node. Ids out of range read as a childless node.
+   */
+  CstNode Node(NodeId /*id*/);
+
+  /**
+   * node and its descendants down to max_depth levels below it.
+   */
+  std::vector<SliceNode> GetSlice(NodeId node, uint32_t max_depth) { return CollectSlice(*this, node, max_depth); }
+
+  [[nodiscard]] uint32_t GetNumNodes() const { return num_nodes_; }
+  [[nodiscard]] NodeId GetRoot() const { return root_; }
+  [[nodiscard]] const std::vector<std::string> &GetNames() const { return names_; }
+  [[nodiscard]] const std::string &GetError() const { return error_; }
+};
+
+}  // namespace jucc::parser
+
+#endif  // JUCC_PARSER_TREE_FILE_H
@@ -0,0 +1,51 @@
+#ifndef JUCC_PARSER_TREE_WRITER_H
+#define JUCC_PARSER_TREE_WRITER_H
+
+#include <string>
+#include <vector>
+
+#include "parser/cst.h"
+#include "utils/output_buffer.h"
+
+namespace jucc::parser {
+
+struct TreeWriterOptions {
+  /**
+   * No whitespace at all when true, otherwise pretty printed with
+   * indentation spaces per level (json::dump style).
+   */
+  bool compact{false};
+  int indentation{4};
+};
+
+class TreantWriter {
+ public:
+  /**
+   * Streams tree in Treant.js format,
+   * { "text": { "name": "E" }, "children": [ ... ] }, straight into out.
+   * The walk is iterative and keeps one entry per open tree level, so memory
+   * is O(tree depth) regardless of the size of the output.
+   */
+  static void Write(const ConcreteSyntaxTree & /*tree*/, const std::vector<std::string> & /*names*/,
+                    utils::OutputBuffer & /*out*/, const TreeWriterOptions & /*options*/ = TreeWriterOptions());
+
+  /**
+   * Streams a slice collected by CollectSlice in the same format, nested
+   * by depth. Every node carries its "id" so that a client can ask for the
+   * slice below it later. Nodes with children, shown in the slice or not,
+   * have "has_children": true and matched terminals their input "token".
+   */
+  static void WriteSlice(const std::vector<SliceNode> & /*slice*/, const std::vector<std::string> & /*names*/,
+                         utils::OutputBuffer & /*out*/, const TreeWriterOptions & /*options*/ = TreeWriterOptions());
+
+  /**
+   * Writes tree to filepath.
+   * @returns true on success
+   */
+  static bool WriteFile(const ConcreteSyntaxTree & /*tree*/, const std::vector<std::string> & /*names*/,
+                        const std::string & /*filepath*/, const TreeWriterOptions & /*options*/ = TreeWriterOptions());
+};
+
+}  // namespace jucc::parser
+
+#endif  // JUCC_PARSER_TREE_WRITER_H
@@ -0,0 +1,83 @@
+#ifndef JUCC_PIPELINE_COMPILE_CACHE_H
+#define JUCC_PIPELINE_COMPILE_CACHE_H
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "grammar/grammar.h"
+#include "grammar/grammar_reduction.h"
+#include "parser/parsing_table.h"
+#include "utils/first_follow.h"
+#include "utils/left_recursion.h"
+
+namespace jucc::pipeline {
+
+/**
+ * Everything the pipeline derives from a grammar before it sees any input:
+ * the transformed grammar, FIRST / FOLLOW, the parsing table and its
+ * conflicts. terminals are the declared ones, without the end marker.
+ * reduction is what the grammar reductions took out before the transforms,
+ * left_recursion what RemoveAllPossibleAmbiguity did if it ran.
+ */
+struct CompiledArtifacts {
+  std::vector<std::string> terminals;
+  std::vector<std::string> non_terminals;
+  std::string start_symbol;
+  grammar::Productions productions;
+  grammar::GeneratedSymbols generated;
+  grammar::ReductionReport reduction;
+  utils::LeftRecursionReport left_recursion;
+  utils::SymbolsMap firsts;
+  utils::SymbolsMap follows;
+  parser::ParsingTable::Table table;
+  std::vector<std::string> conflicts;
+};
+
+/**
+ * Rewrites .g grammar text so that texts grammar::Parser reads the same way
+ * compare equal: comment and blank lines are dropped and the symbols of
+ * every other line are joined by single spaces.
+ */
+std::string NormalizeGrammarText(std::string_view /*text*/);
+
+class CompileCache {
+  /**
+   * Content addressed store of CompiledArtifacts, one file per grammar.
+   *
+   * An entry is named after a hash of the normalized grammar text and holds
+   * that text, so a hash collision reads as a miss rather than as the wrong
+   * grammar. Entries are written to a temporary file and renamed into place:
+   * readers see a complete entry or none, and concurrent writers of the same
+   * grammar write the same bytes, whichever rename lands last wins.
+   */
+  std::string dir_;
+
+ public:
+  static constexpr int VERSION = 7;
+
+  explicit CompileCache(std::string dir) : dir_(std::move(dir)) {}
+
+  /**
+   * Path of the entry for normalized grammar text.
+   */
+  [[nodiscard]] std::string EntryPath(std::string_view /*normalized*/) const;
+
+  /**
+   * Reads the entry for normalized grammar text into artifacts.
+   * @returns false on a miss or an unreadable entry
+   */
+  bool Load(std::string_view /*normalized*/, CompiledArtifacts & /*artifacts*/) const;
+
+  /**
+   * Stores artifacts under normalized grammar text, creating the cache
+   * directory if needed.
+   * @returns false if the entry could not be written
+   */
+  bool Store(std::string_view /*normalized*/, const CompiledArtifacts & /*artifacts*/) const;
+};
+
+}  // namespace jucc::pipeline
+
+#endif  // JUCC_PIPELINE_COMPILE_CACHE_H
@@ -0,0 +1,189 @@
+#ifndef JUCC_PIPELINE_INCREMENTAL_COMPILER_H
+#define JUCC_PIPELINE_INCREMENTAL_COMPILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "grammar/grammar.h"
+#include "grammar/left_recursion_engine.h"
+#include "parser/parsing_table.h"
+#include "utils/first_follow.h"
+
+namespace jucc::pipeline {
+
+/**
+ * What the last IncrementalCompiler::ReplaceRules recomputed.
+ */
+struct EditStats {
+  size_t groups{0};       // left recursion groups whose productions changed
+  size_t productions{0};  // parents whose transformed rules changed, appeared or went away
+  size_t nullable{0};     // non terminals whose nullability was recomputed
+  size_t first{0};        // FIRST sets recomputed
+  size_t follow{0};       // FOLLOW sets recomputed
+  size_t rows{0};         // parsing table rows rebuilt
+  size_t renumbered{0};   // rows whose entries only moved to new production indices
+};
+
+class IncrementalCompiler {
+  /**
+   * Keeps everything Pipeline::LoadGrammar and BuildTable derive from a
+   * grammar, together with what each part was derived from, so that
+   * replacing the rules of one production only redoes what they reach:
+   *
+   *   - left recursion elimination redoes the groups that substituted a
+   *     group whose output changed (grammar::LeftRecursionEngine::Replace),
+   *     and left factoring the productions those groups produce;
+   *   - nullability, FIRST and FOLLOW are each a least fixpoint over a
+   *     dependency graph between non terminals: A's FIRST is read from the
+   *     FIRST of the non terminals in the nullable prefix of its rules, B's
+   *     FOLLOW from the FOLLOW of the parents whose rules end in B plus a
+   *     nullable suffix. Only the strongly connected components reachable
+   *     from the changed non terminals are visited, in dependency order,
+   *     and a component is recomputed only when one of its members changed
+   *     or depends on a set that did;
+   *   - a table row is rebuilt when its parent's rules, FOLLOW or the FIRST
+   *     of a symbol in a nullable prefix of its rules changed. When the
+   *     edit changed how many productions a group has, the entries of the
+   *     rows after it are only renumbered.
+   *
+   * The results are those of a full rebuild: the same productions, non
+   * terminals, table and conflicts, with FIRST and FOLLOW holding the same
+   * symbols, ordered by when the compiler first saw them rather than by
+   * discovery, and the conflicts of one rule in that order as well.
+   * Productions sharing a parent are not expected after the transforms; as
+   * in CalcFirsts only the first one is read for FIRST and FOLLOW.
+   */
+  using Symbol = uint32_t;
+  using Body = std::vector<Symbol>;
+  using Set = std::vector<Symbol>;  // terminals, sorted by symbol
+
+  static constexpr Symbol kNoSymbol = UINT32_MAX;
+
+  struct Place {
+    uint32_t group;
+    uint32_t index;  // in the group's block
+  };
+
+  std::unique_ptr<grammar::LeftRecursionEngine> engine_;
+  std::vector<std::string> declared_non_terminals_;
+  grammar::GeneratedSymbols parsed_;  // EBNF helpers and loops grammar::Parser made
+  std::unordered_set<std::string> declared_;  // symbols the grammar text declares, and EPSILON
+  std::vector<std::string> terminals_;  // declared, then the end marker
+  std::vector<std::string> non_terminals_;
+  std::string start_symbol_;
+  grammar::Productions productions_;
+  std::vector<Symbol> parents_;                        // parent of every production
+  std::vector<size_t> offsets_;                        // first production of every group, then the total
+  std::vector<std::vector<Symbol>> chains_;            // left recursion output parents of every group
+  std::unordered_set<std::string> unfactored_;         // every group's chain, new names are made past them
+  std::vector<std::vector<std::string>> rule_errors_;  // conflicts of every production
+
+  // by symbol
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, Symbol> ids_;
+  std::vector<std::vector<Place>> places_;  // productions with the symbol as parent, empty for terminals
+  std::vector<std::vector<Body>> bodies_;   // rules of the first of them
+  std::vector<std::vector<Symbol>> users_;  // parents with a rule using the symbol
+  std::vector<char> nullable_;
+  std::vector<Set> first_;
+  std::vector<Set> follow_;
+  std::vector<char> declared_terminal_;  // has a column
+  std::vector<char> listed_;             // in non_terminals_, has a row
+  std::vector<std::vector<std::string>> synch_errors_;
+  std::vector<std::vector<parser::ParsingTable::TableEntry *>> cells_;  // cells of table_ holding a production
+  Symbol epsilon_{kNoSymbol};
+  Symbol start_{kNoSymbol};
+
+  parser::ParsingTable::Table table_;
+  EditStats last_edit_;
+  std::string error_;
+
+  Symbol Intern(const std::string & /*name*/);
+  [[nodiscard]] bool IsNonTerminal(Symbol symbol) const { return !places_[symbol].empty(); }
+  [[nodiscard]] size_t ProductionIndex(Place place) const { return offsets_[place.group] + place.index; }
+  void SetBodies(Symbol /*parent*/, const grammar::Rules * /*rules*/);
+  void Apply(const std::vector<size_t> & /*groups*/);
+  void ListNonTerminals();
+
+  // one least fixpoint solved again from seeds, see the class comment
+  std::vector<Symbol> Resolve(const std::vector<Symbol> & /*seeds*/,
+                              const std::function<void(Symbol, std::vector<Symbol> &)> & /*dependents*/,
+                              const std::function<void(Symbol)> & /*reset*/,
+                              const std::function<bool(Symbol)> & /*grow*/,
+                              const std::function<bool(Symbol)> & /*changed*/, size_t & /*recomputed*/);
+  bool InPrefix(Symbol /*parent*/, Symbol /*symbol*/) const;
+  void NullableUsers(Symbol /*symbol*/, std::vector<Symbol> & /*users*/) const;
+  void PrefixUsers(Symbol /*symbol*/, std::vector<Symbol> & /*users*/) const;
+  void TailSymbols(Symbol /*parent*/, std::vector<Symbol> & /*tails*/) const;
+  bool GrowNullable(Symbol /*parent*/);
+  bool GrowFirst(Symbol /*parent*/);
+  bool GrowFollow(Symbol /*symbol*/);
+  void BuildRow(Symbol /*parent*/);
+
+ public:
+  /**
+   * Transforms and compiles a parsed grammar from scratch.
+   * @param parser a grammar::Parser after Parse, before any transform
+   */
+  void Load(grammar::Parser & /*parser*/);
+
+  /**
+   * Parses grammar text and compiles it from scratch. Imported modules are
+   * precompiled by the full pipeline and not transformed again, so grammars
+   * with %import are not compiled here.
+   * @returns false and sets the error if the grammar does not parse or
+   * imports a module
+   */
+  bool Load(std::istream & /*grammar*/);
+
+  /**
+   * Replaces the rules of one production of the grammar as written, before
+   * any transform, and recompiles what depends on it. The rules are plain
+   * BNF, EBNF operators in them are read as symbols.
+   * @returns false and sets the error if parent has no production or a
+   * rule uses a symbol the grammar does not declare, as grammar::Parser does
+   */
+  bool ReplaceRules(const std::string & /*parent*/, const grammar::Rules & /*rules*/);
+
+  [[nodiscard]] const std::vector<std::string> &GetTerminals() const { return terminals_; }
+  [[nodiscard]] const std::vector<std::string> &GetNonTerminals() const { return non_terminals_; }
+  [[nodiscard]] const std::string &GetStartSymbol() const { return start_symbol_; }
+  [[nodiscard]] const grammar::Productions &GetProductions() const { return productions_; }
+  [[nodiscard]] const parser::ParsingTable::Table &GetTable() const { return table_; }
+  [[nodiscard]] const EditStats &GetLastEdit() const { return last_edit_; }
+  [[nodiscard]] const std::string &GetError() const { return error_; }
+
+  /**
+   * FIRST of every non terminal, EPSILON last for nullable ones; built on
+   * every call.
+   */
+  [[nodiscard]] utils::SymbolsMap GetFirsts() const;
+
+  /**
+   * FOLLOW of every non terminal; built on every call.
+   */
+  [[nodiscard]] utils::SymbolsMap GetFollows() const;
+
+  /**
+   * The parsing table conflicts, in the order BuildTable reports them;
+   * built on every call.
+   */
+  [[nodiscard]] std::vector<std::string> GetConflicts() const;
+
+  /**
+   * The non terminals the EBNF expansion and the transforms made, as
+   * grammar::Parser::GetGenerated lists them; built on every call.
+   */
+  [[nodiscard]] grammar::GeneratedSymbols GetGenerated() const;
+};
+
+}  // namespace jucc::pipeline
+
+#endif  // JUCC_PIPELINE_INCREMENTAL_COMPILER_H
@@ -0,0 +1,197 @@
+#ifndef JUCC_PIPELINE_PIPELINE_H
+#define JUCC_PIPELINE_PIPELINE_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../../lexer/lexer.h"
+#include "grammar/grammar.h"
+#include "grammar/grammar_module.h"
+#include "grammar/grammar_reduction.h"
+#include "parser/cst_compaction.h"
+#include "parser/ll_parser.h"
+#include "parser/parsing_table.h"
+#include "utils/first_follow.h"
+#include "utils/left_recursion.h"
+
+namespace jucc::pipeline {
+
+/**
+ * Artifacts the pipeline can write, as a bit set. Each is written under
+ * PipelineOptions::output_dir with the file name the single stage
+ * executables use.
+ */
+enum Output : unsigned {
+  OUTPUT_NONE = 0,
+  OUTPUT_GRAMMAR = 1U << 0,       // grammar.json
+  OUTPUT_FIRST_FOLLOW = 1U << 1,  // first_follow.json
+  OUTPUT_TABLE = 1U << 2,         // parsing_table.json, sparse
+  OUTPUT_GRAMMAR_FILE = 1U << 3,  // grammar.jgb
+  OUTPUT_TOKENS = 1U << 4,        // tokens.json
+  OUTPUT_TRACE = 1U << 5,         // parse_trace.json
+  OUTPUT_TREE = 1U << 6,          // parse_tree.json
+  OUTPUT_TREE_FILE = 1U << 7,     // parse_tree.jst
+  OUTPUT_TRACE_FILE = 1U << 8,    // parse_trace.jtr
+  OUTPUT_ALL = (1U << 9) - 1,
+};
+
+/**
+ * @returns the Output named name ("grammar", "first-follow", "table", "jgb",
+ * "tokens", "trace", "tree", "tree-file", "trace-file" or "all"), OUTPUT_NONE
+ * if there is none.
+ */
+unsigned OutputFromName(const std::string & /*name*/);
+
+/**
+ * Maps lexer tokens to grammar terminals the same way the server does for
+ * the parser: the first word of the token type, with "identifier" read as "id".
+ */
+std::vector<std::string> TokenTerminals(const std::vector<lexer::TokenInfo> & /*tokens*/);
+
+/**
+ * @returns the normalized text of every module grammar_text imports,
+ * directly or not, with %import paths resolved against base_dir. This is
+ * what the Pipeline cache key holds besides the grammar's own text, so
+ * anything deduplicating compiles by grammar text must key on it too.
+ */
+std::string ImportedModulesText(const std::string & /*grammar_text*/, const std::string & /*base_dir*/);
+
+struct PipelineOptions {
+  std::string output_dir{"."};
+  unsigned outputs{OUTPUT_NONE};
+  bool compact_json{false};
+  parser::CompactionOptions compaction;  // applied to the exported trees only
+  std::string cache_dir;                 // CompileCache directory, no caching if empty
+  utils::ThreadPool *pool{nullptr};      // left factors productions in parallel if set, not owned
+  unsigned reductions{grammar::REDUCE_NONE};  // grammar::Reduction passes run right after parsing
+  std::ostream *log{nullptr};                 // grammar::Parser reports what it reads here if set, not owned
+  bool remove_ambiguity{false};  // grammar::Parser::RemoveAllPossibleAmbiguity in place of the two transforms
+};
+
+class Pipeline {
+  /**
+   * Runs the stages of the compiler front end in one process:
+   * grammar::Parser::Parse -> EliminateLeftRecursion -> ApplyLeftFactoring
+   * -> FIRST / FOLLOW -> ParsingTable::BuildTable -> lex -> parse, with
+   * the grammar::Reduction passes in PipelineOptions::reductions run
+   * between Parse and EliminateLeftRecursion. With
+   * PipelineOptions::remove_ambiguity, RemoveAllPossibleAmbiguity takes the
+   * place of EliminateLeftRecursion and ApplyLeftFactoring.
+   * Every stage hands its result to the next in memory; files are only
+   * written for the outputs selected in PipelineOptions.
+   *
+   * With a cache_dir, LoadGrammar looks the normalized grammar text up in a
+   * CompileCache first. On a hit every stage up to the parsing table is
+   * skipped and the outputs are written from the cached artifacts; on a miss
+   * BuildTable stores what it computed.
+   *
+   * Modules named by %import come from grammar::ModuleCache already
+   * transformed, with their nullability and FIRST: only the grammar's own
+   * productions go through the transforms and the FIRST fixpoint, FOLLOW
+   * and the table are computed for the whole grammar.
+   */
+  PipelineOptions options_;
+
+  std::vector<std::string> terminals_;
+  std::vector<std::string> non_terminals_;
+  std::string start_symbol_;
+  grammar::Productions productions_;
+  grammar::GeneratedSymbols generated_;
+  utils::SymbolsMap firsts_;
+  utils::SymbolsMap follows_;
+  parser::ParsingTable table_;
+  std::vector<std::string> tokens_;
+  parser::LLParser parser_;
+  std::string error_;
+
+  std::string source_;   // normalized grammar text
+  std::string modules_;  // normalized text of every module it imports, for the cache key
+  grammar::GrammarModules imports_;
+  size_t own_productions_{0};  // productions_ before those of imports_
+  grammar::ReductionReport reduction_;
+  utils::LeftRecursionReport left_recursion_;
+  bool cached_{false};  // LoadGrammar found source_ in the cache
+  parser::ParsingTable::Table cached_table_;
+  std::vector<std::string> cached_conflicts_;
+
+  std::string OutputPath(const char * /*name*/) const;
+  bool Wants(Output output) const { return (options_.outputs & output) != 0; }
+  bool Fail(const std::string & /*what*/);
+  void WriteGrammarOutput();
+  grammar::Productions EmptiedProductions() const;
+  std::string CacheKey() const;
+
+ public:
+  explicit Pipeline(PipelineOptions options = PipelineOptions()) : options_(std::move(options)) {}
+
+  /**
+   * Reads and transforms the grammar at grammar_path.
+   * @returns false and sets error_ if the grammar can not be read
+   */
+  bool LoadGrammar(const std::string & /*grammar_path*/);
+
+  /**
+   * LoadGrammar for grammar text that is already in memory.
+   * @param base_dir directory %import paths are relative to, the working
+   * directory if empty
+   */
+  bool LoadGrammar(std::istream & /*grammar*/, const std::string & /*base_dir*/ = "");
+
+  /**
+   * Computes FIRST / FOLLOW and builds the parsing table for the loaded
+   * grammar. Conflicts are collected in GetConflicts(), they do not fail.
+   * @returns false and sets error_ if an output could not be written
+   */
+  bool BuildTable();
+
+  /**
+   * Tokenizes a source program, token types are mapped with TokenTerminals.
+   * @returns false and sets error_ if an output could not be written
+   */
+  bool Lex(std::istream & /*source*/);
+
+  /**
+   * Parses the tokens from Lex() with the table from BuildTable().
+   * @returns false if the input is rejected or an output could not be
+   * written, error_ tells which
+   */
+  bool Parse();
+
+  /**
+   * LoadGrammar and BuildTable, then Lex and Parse if source is not null.
+   */
+  bool Run(const std::string & /*grammar_path*/, std::istream * /*source*/);
+
+  [[nodiscard]] const grammar::Productions &GetProductions() const { return productions_; }
+  [[nodiscard]] const std::vector<std::string> &GetTerminals() const { return terminals_; }
+  [[nodiscard]] const std::vector<std::string> &GetNonTerminals() const { return non_terminals_; }
+  [[nodiscard]] const std::string &GetStartSymbol() const { return start_symbol_; }
+  [[nodiscard]] const grammar::GeneratedSymbols &GetGenerated() const { return generated_; }
+  [[nodiscard]] const utils::SymbolsMap &GetFirsts() const { return firsts_; }
+  [[nodiscard]] const utils::SymbolsMap &GetFollows() const { return follows_; }
+  [[nodiscard]] const parser::ParsingTable &GetTable() const { return table_; }
+  [[nodiscard]] const std::vector<std::string> &GetConflicts() const { return table_.GetErrors(); }
+  [[nodiscard]] const std::vector<std::string> &GetTokens() const { return tokens_; }
+  [[nodiscard]] const parser::LLParser &GetParser() const { return parser_; }
+  [[nodiscard]] const std::string &GetError() const { return error_; }
+  [[nodiscard]] bool FromCache() const { return cached_; }
+
+  /**
+   * What PipelineOptions::reductions removed from the grammar, also when
+   * the grammar came from the cache.
+   */
+  [[nodiscard]] const grammar::ReductionReport &GetReductionReport() const { return reduction_; }
+
+  /**
+   * What left recursion removal did with PipelineOptions::remove_ambiguity,
+   * also when the grammar came from the cache. All zero without it.
+   */
+  [[nodiscard]] const utils::LeftRecursionReport &GetLeftRecursionReport() const { return left_recursion_; }
+};
+
+}  // namespace jucc::pipeline
+
+#endif  // JUCC_PIPELINE_PIPELINE_H
@@ -0,0 +1,67 @@
+#ifndef JUCC_UTILS_ARTIFACT_LOADER_H
+#define JUCC_UTILS_ARTIFACT_LOADER_H
+
+#include <istream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "grammar/grammar.h"
+#include "utils/first_follow.h"
+
+namespace jucc::utils {
+
+/**
+ * Contents of grammar.json as written by grammar::Parser::DumpGrammarAsJson.
+ */
+struct GrammarArtifact {
+  std::vector<std::string> terminals;
+  std::vector<std::string> non_terminals;
+  std::string start_symbol;
+  grammar::Productions productions;
+  grammar::GeneratedSymbols generated;  // empty for files written before it was recorded
+};
+
+/**
+ * Cells of parsing_table.json keyed by non terminal and terminal, decoded to
+ * (production, rule) pairs; error cells are (-1, -1) and synch cells (-2, -2).
+ * Same shape as parser::ParsingTable::Table.
+ */
+using TableCells = std::unordered_map<std::string, std::unordered_map<std::string, std::pair<int, int>>>;
+
+/**
+ * Loaders for the JSON artifacts passed between the pipeline stages.
+ * Each reads its stream once, front to back, with utils::JsonReader; keys
+ * may come in any order and unknown keys are skipped.
+ * Malformed input throws std::runtime_error.
+ */
+class ArtifactLoader {
+ public:
+  /**
+   * Loads grammar.json.
+   * @param epsilon_as_empty store ["EPSILON"] rule bodies as empty rules
+   */
+  static GrammarArtifact LoadGrammar(std::istream & /*in*/, bool epsilon_as_empty = false);
+
+  /**
+   * Loads first_follow.json into firsts and follows.
+   */
+  static void LoadFirstFollow(std::istream & /*in*/, SymbolsMap & /*firsts*/, SymbolsMap & /*follows*/);
+
+  /**
+   * Loads parsing_table.json, either dense (every cell as a string) or in the
+   * sparse format of ParsingTable::DumpAsSparseJson, which must start with
+   * "format": "sparse". Cells a sparse file leaves out are loaded as errors.
+   */
+  static TableCells LoadParsingTable(std::istream & /*in*/);
+
+  /**
+   * Decodes a table cell, "error", "synch" or production * 100 + rule.
+   */
+  static std::pair<int, int> DecodeTableValue(const std::string & /*value*/);
+};
+
+}  // namespace jucc::utils
+
+#endif  // JUCC_UTILS_ARTIFACT_LOADER_H
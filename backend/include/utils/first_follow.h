@@ -16,19 +16,25 @@ const char STRING_ENDMARKER[] = "$";
 /**
  * For each terminal and non terminal in the grammar compute if symbol is / derives to nullable
  * Terminals except EPSILON are defaulted to non nullable
+ * @param known nullability of symbols that are not parents of the productions, e.g. the non
+ * terminals of an imported module, taken as is
  * @returns an unordered_map keyed by each symbol in the grammar of booleans
  * true if symbol is nullable, false otherwise.
  */
-std::unordered_map<std::string, bool> CalcNullables(const grammar::Productions & /*augmented_grammar*/);
+std::unordered_map<std::string, bool> CalcNullables(const grammar::Productions & /*augmented_grammar*/,
+                                                    const std::unordered_map<std::string, bool> * /*known*/ = nullptr);
 
 using SymbolsMap = std::unordered_map<std::string, std::vector<std::string>>;
 
 /**
  * For each non terminal in given set of productions computes Firsts.
+ * @param known FIRST of symbols that are not parents of the productions, taken as is and
+ * left out of the result
  * @returns an unordered_map keyed by non terminals in the grammar of a vector of terminals.
  */
 SymbolsMap CalcFirsts(const grammar::Productions & /*augmented_grammar*/,
-                      const std::unordered_map<std::string, bool> & /*nullables*/);
+                      const std::unordered_map<std::string, bool> & /*nullables*/,
+                      const SymbolsMap * /*known*/ = nullptr);
 
 /**
  * For each non terminal in given set of productions computes Follows
@@ -38,6 +44,15 @@ SymbolsMap CalcFollows(const grammar::Productions & /*augmented_grammar*/, const
                        const std::unordered_map<std::string, bool> & /*nullables*/,
                        const std::string & /*start_symbol*/);
 
+/**
+ * Writes first_follow.json, { "first": { nt: [...] }, "follow": { nt: [...] } }
+ * with non terminals in the order of productions.
+ * @param compact drop all whitespace
+ * @returns false if the file could not be written
+ */
+bool DumpFirstFollowAsJson(const std::string & /*filepath*/, const grammar::Productions & /*productions*/,
+                           const SymbolsMap & /*firsts*/, const SymbolsMap & /*follows*/, bool compact = false);
+
 }  // namespace jucc::utils
 
 #endif  // JUCC_FIRST_FOLLOW_H
@@ -0,0 +1,71 @@
+#ifndef JUCC_UTILS_JSON_EMITTER_H
+#define JUCC_UTILS_JSON_EMITTER_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "utils/output_buffer.h"
+
+namespace jucc::utils {
+
+/**
+ * Streaming JSON writer on top of an OutputBuffer.
+ * Pretty output follows the layout of nlohmann::json::dump(indentation):
+ * one member per line, nested containers indented. Containers opened with
+ * single_line = true keep their elements on one line, ["a", "b"], which is
+ * how rule bodies and stacks are written. Compact output has no whitespace.
+ * Strings are escaped on the way out.
+ */
+class JsonEmitter {
+  struct Scope {
+    bool single_line;
+    bool empty;
+  };
+
+  OutputBuffer &out_;
+  bool compact_;
+  int indentation_;
+  std::vector<Scope> scopes_;
+  bool after_key_{false};
+
+  void BeforeValue();
+  void Newline(size_t /*level*/);
+  void Open(char /*bracket*/, bool /*single_line*/);
+  void Close(char /*bracket*/);
+
+ public:
+  explicit JsonEmitter(OutputBuffer &out, bool compact = false, int indentation = 2);
+
+  void BeginObject(bool single_line = false) { Open('{', single_line); }
+  void EndObject() { Close('}'); }
+  void BeginArray(bool single_line = false) { Open('[', single_line); }
+  void EndArray() { Close(']'); }
+
+  void Key(std::string_view /*key*/);
+  void String(std::string_view /*value*/);
+  void Int(int64_t /*value*/);
+  void Bool(bool /*value*/);
+  void Null();
+
+  /**
+   * Writes value, an already serialized JSON value, as is.
+   */
+  void Raw(std::string_view /*value*/);
+
+  /**
+   * Ends the document with a newline.
+   */
+  void Finish() { out_.Put('\n'); }
+
+  /**
+   * Writes value as a quoted JSON string. Runs of characters that need no
+   * escaping, the common case, are found 16 bytes at a time and copied as
+   * a whole.
+   */
+  static void WriteString(OutputBuffer & /*out*/, std::string_view /*value*/);
+};
+
+}  // namespace jucc::utils
+
+#endif  // JUCC_UTILS_JSON_EMITTER_H
@@ -0,0 +1,91 @@
+#ifndef JUCC_UTILS_JSON_READER_H
+#define JUCC_UTILS_JSON_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace jucc::utils {
+
+/**
+ * Pull style JSON reader over a stream.
+ * The input is consumed in fixed size blocks in a single forward pass; the
+ * caller walks the document with BeginObject/NextKey and BeginArray/NextElement
+ * and reads scalars into caller owned strings, so no part of the document is
+ * copied besides the values that are kept.
+ * Malformed input throws std::runtime_error naming the byte offset.
+ */
+class JsonReader {
+  std::istream &in_;
+  std::vector<char> buffer_;
+  size_t pos_{0};
+  size_t end_{0};
+  size_t consumed_{0};  // bytes of the stream before buffer_[0]
+
+  // one entry per open object or array, true until its first member is read
+  std::vector<bool> first_;
+  std::string scratch_;
+
+  bool Fill();
+  int Peek();
+  int Get();
+  void Expect(char /*c*/);
+  bool NextMember(char /*close*/);
+  void AppendEscape(std::string & /*out*/);
+  [[noreturn]] void Fail(const std::string & /*what*/) const;
+
+ public:
+  enum class Type { OBJECT, ARRAY, STRING, NUMBER, LITERAL, END };
+
+  static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+
+  explicit JsonReader(std::istream &in, size_t capacity = DEFAULT_CAPACITY);
+
+  /**
+   * Type of the next value, skipping whitespace.
+   */
+  Type PeekType();
+
+  void BeginObject();
+
+  /**
+   * Reads the next key of the innermost object into key, consuming the
+   * separators around it.
+   * @returns false once the object is closed
+   */
+  bool NextKey(std::string & /*key*/);
+
+  void BeginArray();
+
+  /**
+   * Moves to the next element of the innermost array.
+   * @returns false once the array is closed
+   */
+  bool NextElement();
+
+  /**
+   * Reads a string value into out, reusing its capacity.
+   */
+  void ReadString(std::string & /*out*/);
+
+  /**
+   * Reads an integer value.
+   */
+  int64_t ReadInt();
+
+  /**
+   * Skips the next value, including nested objects and arrays.
+   */
+  void Skip();
+
+  /**
+   * Fails unless only whitespace is left.
+   */
+  void ExpectEnd();
+};
+
+}  // namespace jucc::utils
+
+#endif  // JUCC_UTILS_JSON_READER_H
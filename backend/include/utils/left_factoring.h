@@ -1,5 +1,8 @@
 #ifndef JUCC_LEFT_FACTORING_H
 #define JUCC_LEFT_FACTORING_H
+#include <functional>
+#include <string>
+
 #include "grammar/grammar.h"
 namespace grammar = jucc::grammar;
 
@@ -10,6 +13,22 @@ namespace jucc::utils {
  */
 grammar::Productions RemoveLeftFactors(const grammar::Production & /*prod*/);
 
+/**
+ * Left factors every group of rules sharing a prefix, at every depth, in
+ * one pass: the rules are inserted into a single trie and each branching
+ * node becomes a new non terminal during one traversal, so the cost is
+ * linear in the total length of the rules. Identical rules are merged.
+ * Example: for production
+ * S -> a b c | a b d | a e | f
+ * @param new_name called for every new non terminal, in output order.
+ * @return the factored production first, then the new ones in pre-order.
+ * S    -> a S' | f
+ * S'   -> b S'' | e
+ * S''  -> c | d
+ */
+grammar::Productions FactorPrefixes(const grammar::Production & /*prod*/,
+                                    const std::function<std::string()> & /*new_name*/);
+
 /**
  * Finds longest prefix which is most common to the rules of the productions.
  * @return a grammar Rule which can be used as a core of grammar::Rule.
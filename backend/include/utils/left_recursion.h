@@ -26,14 +26,53 @@ grammar::Productions RemoveDirectLeftRecursion(const grammar::Production & /*pro
 bool IsRecursive(const grammar::Production & /*prod*/);
 
 /**
- * TODO!! (If required)
+ * Size of a grammar: productions, rules and symbols over all rule bodies.
+ */
+struct GrammarSize {
+  size_t productions{0};
+  size_t rules{0};
+  size_t symbols{0};
+};
+
+/**
+ * @returns the size of the given set of productions.
+ */
+GrammarSize MeasureGrammar(const grammar::Productions & /*prods*/);
+
+/**
+ * Strongly connected components of the left corner graph that are left
+ * recursive, i.e. have more than one member or a member whose rule starts
+ * with itself. Members are production indices, in input order.
+ */
+std::vector<std::vector<size_t>> LeftRecursiveComponents(const grammar::Productions & /*prods*/);
+
+struct LeftRecursionReport {
+  GrammarSize before;
+  GrammarSize after;
+  size_t recursive_components{0};  // left recursive SCCs of the left corner graph
+  size_t substitutions{0};         // rules whose left corner was replaced by its rules
+};
+
+/**
  * Removes Indirect Left Recursion.
  * A -> B
  * B -> C
  * C -> A | B | EPSILON
+ *
+ * Only the strongly connected components of the left corner graph (A -> B
+ * when a rule of A starts with B) are rewritten, everything else is left
+ * as it is. Inside a component Paull's substitution only replaces left
+ * corners from the same component, and the component is tried in a few
+ * orders, keeping the one with the smallest output. Rewritten productions
+ * stay where their parent was, each preceded by its A'@ as with
+ * RemoveDirectLeftRecursion.
+ * @param report if given, receives the grammar size before and after.
+ * @param pool if given, components are rewritten in parallel on it.
  * @return a set of Productions.
  */
-grammar::Productions RemoveIndirectLeftRecursions(const grammar::Productions & /*prod*/);
+grammar::Productions RemoveIndirectLeftRecursions(const grammar::Productions & /*prod*/,
+                                                  LeftRecursionReport * /*report*/ = nullptr,
+                                                  ThreadPool * /*pool*/ = nullptr);
 
 }  // namespace jucc::utils
 #endif  // JUCC_LEFT_RECURSION_H
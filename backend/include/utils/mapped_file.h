@@ -0,0 +1,45 @@
+#ifndef JUCC_UTILS_MAPPED_FILE_H
+#define JUCC_UTILS_MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace jucc::utils {
+
+class MappedFile {
+  /**
+   * Read-only, shared mapping of a whole file. Pages are backed by the page
+   * cache, so every process mapping the same file shares one copy.
+   */
+  const char *data_{nullptr};
+  size_t size_{0};
+#ifdef _WIN32
+  void *file_{nullptr};
+  void *mapping_{nullptr};
+#endif
+  std::string error_;
+
+  void Close();
+
+ public:
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile && /*other*/) noexcept;
+  MappedFile &operator=(MappedFile && /*other*/) noexcept;
+  ~MappedFile() { Close(); }
+
+  /**
+   * Maps filepath, replacing any previous mapping.
+   * @returns false and sets error_ if the file can not be opened or mapped
+   */
+  bool Open(const std::string & /*filepath*/);
+
+  [[nodiscard]] const char *Data() const { return data_; }
+  [[nodiscard]] size_t Size() const { return size_; }
+  [[nodiscard]] const std::string &GetError() const { return error_; }
+};
+
+}  // namespace jucc::utils
+
+#endif  // JUCC_UTILS_MAPPED_FILE_H
@@ -0,0 +1,82 @@
+#ifndef JUCC_UTILS_OUTPUT_BUFFER_H
+#define JUCC_UTILS_OUTPUT_BUFFER_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace jucc::utils {
+
+class OutputBuffer {
+  /**
+   * Bytes are collected in buffer_ and handed to the file descriptor (or
+   * stream) in large writes once the buffer is full or on Flush().
+   */
+  std::vector<char> buffer_;
+  size_t used_{0};
+  int fd_{-1};
+  bool owns_fd_{false};
+  std::ostream *stream_{nullptr};
+  bool failed_{false};
+
+  void WriteAll(const char * /*data*/, size_t /*size*/);
+  void Drain(const char * /*data*/, size_t /*size*/);
+
+ public:
+  static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+
+  /**
+   * Writes to an already open file descriptor, which is not closed.
+   */
+  explicit OutputBuffer(int fd, size_t capacity = DEFAULT_CAPACITY);
+
+  /**
+   * Writes to a stream, e.g. std::cout or an std::ofstream.
+   */
+  explicit OutputBuffer(std::ostream &stream, size_t capacity = DEFAULT_CAPACITY);
+
+  OutputBuffer(const OutputBuffer &) = delete;
+  OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+  /**
+   * Flushes and closes the file descriptor if it was opened by Open().
+   */
+  ~OutputBuffer();
+
+  /**
+   * Creates or truncates filepath and returns a buffer writing to it.
+   * Check Failed() on the result.
+   */
+  static OutputBuffer Open(const std::string & /*filepath*/, size_t capacity = DEFAULT_CAPACITY);
+
+  OutputBuffer(OutputBuffer && /*other*/) noexcept;
+
+  void Write(const char *data, size_t size) {
+    if (size > buffer_.size() - used_) {
+      Drain(data, size);
+      return;
+    }
+    std::char_traits<char>::copy(buffer_.data() + used_, data, size);
+    used_ += size;
+  }
+  void Write(std::string_view data) { Write(data.data(), data.size()); }
+  void Put(char c) {
+    if (used_ == buffer_.size()) {
+      Flush();
+    }
+    buffer_[used_++] = c;
+  }
+
+  /**
+   * Hands everything buffered so far to the underlying file.
+   */
+  void Flush();
+
+  [[nodiscard]] bool Failed() const { return failed_; }
+};
+
+}  // namespace jucc::utils
+
+#endif  // JUCC_UTILS_OUTPUT_BUFFER_H
@@ -0,0 +1,68 @@
+#ifndef JUCC_UTILS_THREAD_POOL_H
+#define JUCC_UTILS_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jucc::utils {
+
+class ThreadPool {
+  /**
+   * Fixed set of worker threads taking tasks from a shared FIFO queue.
+   */
+  std::vector<std::thread> workers_;
+  std::deque<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable task_ready_;
+  std::condition_variable idle_;
+  size_t running_{0};
+  bool stopping_{false};
+
+  void WorkerLoop();
+
+ public:
+  /**
+   * Starts num_threads workers, one per hardware thread if 0.
+   */
+  explicit ThreadPool(size_t num_threads = 0);
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * Runs the tasks still queued, then joins the workers.
+   */
+  ~ThreadPool();
+
+  /**
+   * Queues task to run on one of the workers. Tasks must not throw.
+   */
+  void Submit(std::function<void()> /*task*/);
+
+  /**
+   * Blocks until the queue is empty and no task is running.
+   */
+  void Wait();
+
+  /**
+   * Calls body(i) for every i in [0, count) on the workers and the calling
+   * thread, returning once all calls are done. Unlike Wait it only waits
+   * for its own calls, so a task running on this pool may use it too: the
+   * caller keeps taking indices itself when every worker is busy.
+   * If body throws, the indices not started yet are skipped and the first
+   * exception is rethrown here once the calls already running are done.
+   */
+  void ParallelFor(size_t /*count*/, const std::function<void(size_t)> & /*body*/);
+
+  [[nodiscard]] size_t Size() const { return workers_.size(); }
+};
+
+}  // namespace jucc::utils
+
+#endif  // JUCC_UTILS_THREAD_POOL_H
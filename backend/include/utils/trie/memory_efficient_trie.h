@@ -1,6 +1,7 @@
 #ifndef JUCC_UTILS_MEMORY_EFFICIENT_TRIE_H
 #define JUCC_UTILS_MEMORY_EFFICIENT_TRIE_H
-#include <sstream>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -12,67 +13,103 @@ namespace utils {
 
 class Trie {
   /**
-   * Class Trie to store a production efficiently for any required
-   * operations, mainly for prefix matching.
+   * A node of the Trie kept in a TrieManager's arena. Nodes refer to each
+   * other by index: the entity on the edge from the parent is an interned
+   * symbol, and the prefix upto the node is rebuilt by walking parent_.
+   * Children form a list in insertion order, first_child_ then
+   * next_sibling_ of each child.
    */
  public:
-  // Creates a trie for set of Rules where each entity is used as a key.
-  std::unordered_map<std::string, Trie *> nodes_;
-
-  std::vector<std::string> keys_list_;  // Stores the prefix list of entities upto the current entity.
+  uint32_t parent_;        // Index of the parent node.
+  uint32_t symbol_;        // Interned entity on the edge from the parent.
+  uint32_t first_child_;   // First child inserted, or TrieManager::NO_NODE.
+  uint32_t last_child_;    // Last child inserted, or TrieManager::NO_NODE.
+  uint32_t next_sibling_;  // Next child of the parent, or TrieManager::NO_NODE.
   int count_;  // Number of occurrences of the current entity after insertion of a set of Rules.
+  int ends_;   // Number of inserted Rules ending at the current entity.
 
-  Trie();
+  Trie(uint32_t /*parent*/, uint32_t /*symbol*/);
+};
+
+struct TrieStats {
+  size_t nodes{0};             // including the root
+  size_t symbols{0};           // distinct entities
+  size_t inserted_symbols{0};  // entities of all inserted Rules
+  size_t bytes{0};             // arena, edge table and symbol table
+
+  [[nodiscard]] double BytesPerInsertedSymbol() const {
+    return inserted_symbols == 0 ? 0.0 : static_cast<double>(bytes) / static_cast<double>(inserted_symbols);
+  }
 };
 
 class TrieManager {
   /**
    * A higher order abstration to manager a complete Trie.
-   * Takes care of unwanted memory leaking through a custom garbage collector.
+   * Every node lives in one arena vector, so there is nothing to free node
+   * by node. Edges are found through one open addressing table keyed by
+   * (parent, symbol) instead of a map per node.
    */
-  Trie *master_;  // Current head of the trie.
+  std::vector<Trie> nodes_;  // The arena, nodes_[ROOT] is the head of the trie.
+
+  std::vector<std::string> symbols_;
+  std::unordered_map<std::string, uint32_t> symbol_ids_;
 
-  std::vector<Trie *> gc_;  // The garbage collector which stores any newly created trie node.
+  std::vector<uint64_t> edge_keys_;   // (parent << 32 | symbol) + 1, 0 marks a free slot
+  std::vector<uint32_t> edge_nodes_;  // child reached through the edge in the same slot
+  size_t edge_count_{0};
+  size_t inserted_symbols_{0};
+
+  uint32_t Intern(const std::string & /*entity*/);
+  size_t EdgeSlot(uint64_t /*key*/) const;
+  void GrowEdges();
 
  public:
+  static constexpr uint32_t ROOT = 0;
+  static constexpr uint32_t NO_NODE = UINT32_MAX;
+
   /**
    * Constructor.
    */
   TrieManager();
 
   /**
-   * Customised no-param constructor.
+   * Getter: Returns the node at index, ROOT being the Head of the trie.
+   */
+  [[nodiscard]] const Trie &GetNode(uint32_t index) const { return nodes_[index]; }
+
+  /**
+   * Getter: Returns the entity on the edge into the node at index.
    */
-  Trie *NewTrieNode();
+  [[nodiscard]] const std::string &GetEntity(uint32_t index) const { return symbols_[nodes_[index].symbol_]; }
 
   /**
-   * Getter: Returns master_ node, i.e. the Head of the trie.
+   * Rebuilds the prefix list of entities upto the node at index.
    */
-  [[nodiscard]] Trie *GetMaster() const;
+  [[nodiscard]] std::vector<std::string> GetPrefix(uint32_t /*index*/) const;
 
   /**
-   * Insert a particular grammar Rule into the master_.
+   * Insert a particular grammar Rule into the trie.
    * @param grammar::Rule &
    */
   void Insert(const grammar::Rule & /*rule*/);
 
   /**
-   * Insert a whole production into the trie node master_.
+   * Insert a whole production into the trie.
    */
   void InsertAll(const grammar::Production & /*prod*/);
 
   /**
-   * Makes a preorder traversal efficiently of the master_ node of the Trie and
+   * Makes a preorder traversal efficiently of the head node of the Trie and
    * returns the most common prefix of the Production Rules formed by individual
    * Rule entities.
    */
   // NOLINTNEXTLINE
-  static void GreedyPreorder(Trie * /*head*/, int & /*len*/, grammar::Rule & /*max_str*/, bool /*is_prime_head*/);
+  void GreedyPreorder(uint32_t /*head*/, int & /*len*/, grammar::Rule & /*max_str*/, bool /*is_prime_head*/) const;
 
   /**
-   * Virtual Destructor performs garbage collection where created memory gets released.
+   * Node count and memory held, to compare against the inserted entities.
    */
-  virtual ~TrieManager();
+  [[nodiscard]] TrieStats GetStats() const;
 };
 
 }  // namespace utils
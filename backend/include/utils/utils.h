@@ -8,15 +8,21 @@
 #include "first_follow.h"
 #include "left_factoring.h"
 #include "left_recursion.h"
+#include "thread_pool.h"
 #include "trie/memory_efficient_trie.h"
 
 namespace jucc {
 namespace utils {
 /**
  * Makes the grammar non ambiguous.
+ * @param pool if given, left recursive components and productions are
+ * transformed in parallel on it; the result is the same without.
+ * @param report if given, receives what RemoveIndirectLeftRecursions did.
  * @return A set of production free from left recursions and left factors.
  */
-grammar::Productions RemoveAllPossibleAmbiguity(const grammar::Productions & /*prods*/);
+grammar::Productions RemoveAllPossibleAmbiguity(const grammar::Productions & /*prods*/,
+                                                ThreadPool * /*pool*/ = nullptr,
+                                                LeftRecursionReport * /*report*/ = nullptr);
 
 /**
  * @returns a list of parents from the given set of productions.
@@ -1,5 +1,6 @@
 #include "lexer.h"
 #include <iostream>
+#include "../include/utils/json_emitter.h"
 
 namespace jucc::lexer {
 
@@ -8,38 +9,37 @@ void Lexer::AddToken(int token, const std::string &value, bool error) {
 }
 
 int Lexer::GetToken(std::istream &is) {
-  static char last_char = ' ';
 
-  while (!is.eof() && (isspace(last_char) != 0)) {
-    if (last_char == '\n') current_line_++;
-    is.get(last_char);
+  while (!is.eof() && (isspace(last_char_) != 0)) {
+    if (last_char_ == '\n') current_line_++;
+    is.get(last_char_);
   }
 
   if (is.eof()) return TOK_EOF;
 
   // Handle comments
-  if (last_char == '/') {
-    is.get(last_char);
-    if (last_char == '/') {  // Single-line comment
-      while (!is.eof() && last_char != '\n') {
-        is.get(last_char);
+  if (last_char_ == '/') {
+    is.get(last_char_);
+    if (last_char_ == '/') {  // Single-line comment
+      while (!is.eof() && last_char_ != '\n') {
+        is.get(last_char_);
       }
-      if (last_char == '\n') current_line_++;
-      is.get(last_char);
+      if (last_char_ == '\n') current_line_++;
+      is.get(last_char_);
       return GetToken(is);  // Get next token
-    } else if (last_char == '*') {  // Multi-line comment
+    } else if (last_char_ == '*') {  // Multi-line comment
       bool comment_ended = false;
       while (!is.eof() && !comment_ended) {
-        is.get(last_char);
-        if (last_char == '\n') current_line_++;
-        if (last_char == '*') {
-          is.get(last_char);
-          if (last_char == '/') {
+        is.get(last_char_);
+        if (last_char_ == '\n') current_line_++;
+        if (last_char_ == '*') {
+          is.get(last_char_);
+          if (last_char_ == '/') {
             comment_ended = true;
           }
         }
       }
-      is.get(last_char);
+      is.get(last_char_);
       return GetToken(is);  // Get next token
     } else {
       // It's a division operator
@@ -48,11 +48,11 @@ int Lexer::GetToken(std::istream &is) {
     }
   }
 
-  if (isalpha(last_char) || last_char == '_') {
-    identifier_string_ = last_char;
+  if (isalpha(last_char_) || last_char_ == '_') {
+    identifier_string_ = last_char_;
     int ret_token = TOK_IDENTIFIER;
-    while (is.get(last_char) && (isalnum(last_char) || last_char == '_')) {
-      identifier_string_ += last_char;
+    while (is.get(last_char_) && (isalnum(last_char_) || last_char_ == '_')) {
+      identifier_string_ += last_char_;
     }
 
     if (identifier_string_ == "int") {
@@ -103,26 +103,26 @@ int Lexer::GetToken(std::istream &is) {
     return ret_token;
   }
 
-  if (isdigit(last_char) || last_char == '.') {
+  if (isdigit(last_char_) || last_char_ == '.') {
     std::string num_string;
     direct_before_datatype_ = false;
-    bool has_dot = (last_char == '.');
+    bool has_dot = (last_char_ == '.');
     if (has_dot) {
       num_string = "0.";
-      is.get(last_char);
+      is.get(last_char_);
     } else {
-      num_string = last_char;
+      num_string = last_char_;
     }
     
-    while (is.get(last_char) && (isdigit(last_char) || (!has_dot && last_char == '.'))) {
-      if (last_char == '.') has_dot = true;
-      num_string += last_char;
+    while (is.get(last_char_) && (isdigit(last_char_) || (!has_dot && last_char_ == '.'))) {
+      if (last_char_ == '.') has_dot = true;
+      num_string += last_char_;
     }
 
-    if (isalpha(last_char) || last_char == '_') {
-      while (!is.eof() && (isalnum(last_char) || last_char == '_')) {
-        num_string += last_char;
-        is.get(last_char);
+    if (isalpha(last_char_) || last_char_ == '_') {
+      while (!is.eof() && (isalnum(last_char_) || last_char_ == '_')) {
+        num_string += last_char_;
+        is.get(last_char_);
       }
       error_string_ = "Invalid number format: " + num_string;
       AddToken(TOK_ERROR, num_string, true);
@@ -141,36 +141,36 @@ int Lexer::GetToken(std::istream &is) {
     return ret_token;
   }
 
-  if (last_char == '"') {
+  if (last_char_ == '"') {
     literal_string_ = "";
-    while (is.get(last_char) && last_char != '"') {
-      if (last_char == '\\') {
-        is.get(last_char);
-        switch (last_char) {
+    while (is.get(last_char_) && last_char_ != '"') {
+      if (last_char_ == '\\') {
+        is.get(last_char_);
+        switch (last_char_) {
           case 'n': literal_string_ += '\n'; break;
           case 't': literal_string_ += '\t'; break;
           case 'r': literal_string_ += '\r'; break;
           case '"': literal_string_ += '"'; break;
           case '\\': literal_string_ += '\\'; break;
-          default: literal_string_ += last_char;
+          default: literal_string_ += last_char_;
         }
       } else {
-        literal_string_ += last_char;
+        literal_string_ += last_char_;
       }
     }
-    if (last_char != '"') {
+    if (last_char_ != '"') {
       error_string_ = "Unterminated string literal";
       AddToken(TOK_ERROR, literal_string_, true);
       return TOK_ERROR;
     }
-    is.get(last_char);
+    is.get(last_char_);
     AddToken(TOK_LITERAL, literal_string_);
     return TOK_LITERAL;
   }
 
-  if (ispunct(last_char)) {
+  if (ispunct(last_char_)) {
     int ret_token = TOK_ERROR;
-    char ch = last_char;
+    char ch = last_char_;
     std::string val(1, ch);
 
     switch (ch) {
@@ -184,11 +184,11 @@ int Lexer::GetToken(std::istream &is) {
       case '{': ret_token = TOK_CURLY_OPEN; current_nesting_level_++; break;
       case '}': ret_token = TOK_CURLY_CLOSE; symbol_table_.RemoveNodesOnScopeEnd(current_nesting_level_); current_nesting_level_--; break;
       case '<':
-        is.get(last_char);
-        if (last_char == '=') {
+        is.get(last_char_);
+        if (last_char_ == '=') {
           ret_token = TOK_LESS_THAN_OR_EQUALS;
           val = "<=";
-        } else if (last_char == '<') {
+        } else if (last_char_ == '<') {
           ret_token = TOK_LEFT_SHIFT;
           val = "<<";
         } else {
@@ -197,11 +197,11 @@ int Lexer::GetToken(std::istream &is) {
         }
         break;
       case '>':
-        is.get(last_char);
-        if (last_char == '=') {
+        is.get(last_char_);
+        if (last_char_ == '=') {
           ret_token = TOK_GREATER_THAN_OR_EQUALS;
           val = ">=";
-        } else if (last_char == '>') {
+        } else if (last_char_ == '>') {
           ret_token = TOK_RIGHT_SHIFT;
           val = ">>";
         } else {
@@ -210,8 +210,8 @@ int Lexer::GetToken(std::istream &is) {
         }
         break;
       case '=':
-        is.get(last_char);
-        if (last_char == '=') {
+        is.get(last_char_);
+        if (last_char_ == '=') {
           ret_token = TOK_EQUAL_TO;
           val = "==";
         } else {
@@ -220,8 +220,8 @@ int Lexer::GetToken(std::istream &is) {
         }
         break;
       case '!':
-        is.get(last_char);
-        if (last_char == '=') {
+        is.get(last_char_);
+        if (last_char_ == '=') {
           ret_token = TOK_NOT_EQUAL_TO;
           val = "!=";
         } else {
@@ -232,17 +232,17 @@ int Lexer::GetToken(std::istream &is) {
     }
 
     if (ret_token != TOK_ERROR) {
-      is.get(last_char);
+      is.get(last_char_);
       AddToken(ret_token, val);
       return ret_token;
     }
   }
 
   // Unknown character
-  std::string unknown(1, last_char);
+  std::string unknown(1, last_char_);
   error_string_ = "Unknown character: " + unknown;
   AddToken(TOK_ERROR, unknown, true);
-  is.get(last_char);
+  is.get(last_char_);
   return TOK_ERROR;
 }
 
@@ -285,18 +285,28 @@ std::string Lexer::GetTokenType(int token) {
   }
 }
 
-void Lexer::DumpTokensAsJson() const {
-    std::cout << "[\n";
-    for (size_t i = 0; i < tokens_.size(); ++i) {
-        const auto& token = tokens_[i];
-        std::cout << "  {\n";
-        std::cout << "    \"type\": \"" << token.type << "\",\n";
-        std::cout << "    \"value\": \"" << token.value << "\",\n";
-        std::cout << "    \"line\": " << token.line << ",\n";
-        std::cout << "    \"error\": " << (token.error ? "true" : "false") << "\n";
-        std::cout << "  }" << (i < tokens_.size() - 1 ? "," : "") << "\n";
+void Lexer::DumpTokensAsJson(bool compact) const {
+    utils::OutputBuffer out(std::cout);
+    DumpTokensAsJson(out, compact);
+}
+
+void Lexer::DumpTokensAsJson(utils::OutputBuffer &out, bool compact) const {
+    utils::JsonEmitter json(out, compact);
+    json.BeginArray();
+    for (const auto& token : tokens_) {
+        json.BeginObject();
+        json.Key("type");
+        json.String(token.type);
+        json.Key("value");
+        json.String(token.value);
+        json.Key("line");
+        json.Int(token.line);
+        json.Key("error");
+        json.Bool(token.error);
+        json.EndObject();
     }
-    std::cout << "]\n";
+    json.EndArray();
+    json.Finish();
 }
 
 std::string Lexer::GetCurrentDatatype() { return current_datatype_; }
@@ -9,6 +9,10 @@
 #include "../symbol_table/symbol_table.h"
 
 namespace jucc {
+namespace utils {
+class OutputBuffer;
+}  // namespace utils
+
 namespace lexer {
 
 // Token types that can be extended at runtime
@@ -87,6 +91,7 @@ private:
   symbol_table::SymbolTable symbol_table_;
   bool direct_before_datatype_{false};
   int current_line_{1};
+  char last_char_{' '};  // lookahead carried between GetToken calls
 
   std::vector<TokenInfo> tokens_;  // for JSON output
 
@@ -101,7 +106,10 @@ private:
   std::vector<std::string> GetDuplicateSymbolErrors();
   const bool &GetDirectBeforeDatatypeFlag() const { return direct_before_datatype_; }
 
-  void DumpTokensAsJson() const;
+  const std::vector<TokenInfo> &GetTokens() const { return tokens_; }
+
+  void DumpTokensAsJson(bool compact = false) const;
+  void DumpTokensAsJson(utils::OutputBuffer &out, bool compact = false) const;
   void AddToken(int token, const std::string &value, bool error = false);
 };
 
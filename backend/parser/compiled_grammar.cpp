@@ -0,0 +1,192 @@
+#include "parser/compiled_grammar.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#include "parser/grammar_file.h"
+#include "utils/first_follow.h"
+
+namespace jucc::parser {
+
+SymbolId CompiledGrammar::Intern(const std::string &name) {
+  auto it = ids_.find(name);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+  if (names_.size() >= std::numeric_limits<SymbolId>::max()) {
+    throw std::length_error("compiled grammar error: too many symbols");
+  }
+  auto id = static_cast<SymbolId>(names_.size());
+  names_.push_back(name);
+  ids_.emplace(name, id);
+  return id;
+}
+
+CompiledGrammar CompiledGrammar::Compile(const grammar::Productions &productions,
+                                         const std::vector<std::string> &terminals, const std::string &start_symbol,
+                                         const ParsingTable::Table &table,
+                                         const grammar::GeneratedSymbols &generated) {
+  CompiledGrammar cg;
+  // id 0 is reserved for tokens the grammar does not know about
+  cg.names_.emplace_back("<unknown>");
+
+  std::unordered_map<std::string, bool> is_parent;
+  for (const auto &prod : productions) {
+    is_parent[prod.GetParent()] = true;
+  }
+
+  // terminals first so that IsTerminal() is a single comparison
+  for (const auto &term : terminals) {
+    if (is_parent.count(term) == 0U && term != std::string(grammar::EPSILON)) {
+      cg.Intern(term);
+    }
+  }
+  for (const auto &prod : productions) {
+    for (const auto &rule : prod.GetRules()) {
+      for (const auto &entity : rule.GetEntities()) {
+        if (is_parent.count(entity) == 0U && entity != std::string(grammar::EPSILON)) {
+          cg.Intern(entity);
+        }
+      }
+    }
+  }
+  cg.end_marker_ = cg.Intern(std::string(utils::STRING_ENDMARKER));
+  cg.num_terminals_ = static_cast<uint32_t>(cg.names_.size());
+
+  for (const auto &prod : productions) {
+    cg.Intern(prod.GetParent());
+  }
+  cg.start_symbol_ = cg.Lookup(start_symbol);
+  if (cg.start_symbol_ < cg.num_terminals_) {
+    throw std::invalid_argument("compiled grammar error: start symbol is not a non terminal: " + start_symbol);
+  }
+
+  auto mark = [&cg](const std::vector<std::string> &names, std::vector<bool> &marks) {
+    marks.assign(cg.names_.size(), false);
+    for (const auto &name : names) {
+      SymbolId id = cg.Lookup(name);
+      if (id >= cg.num_terminals_) {
+        marks[id] = true;
+      }
+    }
+  };
+  mark(generated.helpers, cg.helpers_);
+  mark(generated.loops, cg.loops_);
+
+  // flatten rules, storing each right hand side reversed so an expansion is one bulk copy
+  std::vector<RuleId> production_base;
+  cg.rhs_offset_.push_back(0);
+  for (size_t prod_no = 0; prod_no < productions.size(); prod_no++) {
+    production_base.push_back(static_cast<RuleId>(cg.rule_parent_.size()));
+    const auto &rules = productions[prod_no].GetRules();
+    for (size_t rule_no = 0; rule_no < rules.size(); rule_no++) {
+      const auto &entities = rules[rule_no].GetEntities();
+      for (auto it = entities.rbegin(); it != entities.rend(); ++it) {
+        if (*it != std::string(grammar::EPSILON)) {
+          cg.rhs_.push_back(cg.ids_.at(*it));
+        }
+      }
+      cg.rhs_offset_.push_back(static_cast<uint32_t>(cg.rhs_.size()));
+      cg.rule_parent_.push_back(cg.ids_.at(productions[prod_no].GetParent()));
+      cg.rule_key_.push_back(static_cast<int>(prod_no * 100 + rule_no));
+    }
+  }
+
+  size_t num_non_terminals = cg.names_.size() - cg.num_terminals_;
+  cg.table_.assign(num_non_terminals * cg.num_terminals_, kErrorEntry);
+  for (const auto &row : table) {
+    auto nt = cg.ids_.find(row.first);
+    if (nt == cg.ids_.end() || nt->second < cg.num_terminals_) {
+      continue;
+    }
+    size_t base = static_cast<size_t>(nt->second - cg.num_terminals_) * cg.num_terminals_;
+    for (const auto &cell : row.second) {
+      auto term = cg.ids_.find(cell.first);
+      if (term == cg.ids_.end() || term->second >= cg.num_terminals_) {
+        continue;
+      }
+      RuleId entry = kErrorEntry;
+      if (cell.second.first == kSynchEntry) {
+        entry = kSynchEntry;
+      } else if (cell.second.first >= 0) {
+        auto prod_no = static_cast<size_t>(cell.second.first);
+        if (prod_no >= productions.size() ||
+            static_cast<size_t>(cell.second.second) >= productions[prod_no].GetRules().size()) {
+          throw std::out_of_range("compiled grammar error: table entry out of range for " + row.first + ", " +
+                                  cell.first);
+        }
+        entry = production_base[prod_no] + cell.second.second;
+      }
+      cg.table_[base + term->second] = entry;
+    }
+  }
+
+  return cg;
+}
+
+CompiledGrammar CompiledGrammar::FromFile(std::shared_ptr<const GrammarFile> file) {
+  CompiledGrammar cg;
+  cg.names_.reserve(file->GetNumSymbols());
+  cg.helpers_.reserve(file->GetNumSymbols());
+  cg.loops_.reserve(file->GetNumSymbols());
+  for (uint32_t symbol = 0; symbol < file->GetNumSymbols(); symbol++) {
+    cg.names_.emplace_back(file->GetName(static_cast<SymbolId>(symbol)));
+    uint8_t flags = file->GetSymbolFlags(static_cast<SymbolId>(symbol));
+    cg.helpers_.push_back((flags & SYMBOL_HELPER) != 0);
+    cg.loops_.push_back((flags & SYMBOL_LOOP) != 0);
+  }
+  GrammarView view = file->View();
+  cg.num_terminals_ = view.num_terminals;
+  cg.start_symbol_ = view.start_symbol;
+  cg.end_marker_ = view.end_marker;
+  cg.file_ = std::move(file);
+  return cg;
+}
+
+SymbolId CompiledGrammar::Lookup(const std::string &name) const {
+  if (file_) {
+    return file_->Lookup(name);
+  }
+  auto it = ids_.find(name);
+  return it == ids_.end() ? kUnknownSymbol : it->second;
+}
+
+std::vector<SymbolId> CompiledGrammar::Encode(const std::vector<std::string> &tokens) const {
+  std::vector<SymbolId> encoded;
+  encoded.reserve(tokens.size() + 1);
+  for (const auto &token : tokens) {
+    SymbolId id = Lookup(token);
+    encoded.push_back(id < num_terminals_ ? id : kUnknownSymbol);
+  }
+  if (encoded.empty() || encoded.back() != end_marker_) {
+    encoded.push_back(end_marker_);
+  }
+  return encoded;
+}
+
+size_t CompiledGrammar::GetNumRules() const { return file_ ? file_->GetNumRules() : rule_parent_.size(); }
+
+SymbolId CompiledGrammar::GetRuleParent(RuleId rule) const {
+  return file_ ? file_->GetRuleParent(rule) : rule_parent_[rule];
+}
+
+int CompiledGrammar::GetRuleKey(RuleId rule) const { return file_ ? file_->GetRuleKey(rule) : rule_key_[rule]; }
+
+GrammarView CompiledGrammar::View() const {
+  if (file_) {
+    return file_->View();
+  }
+  GrammarView view{};
+  view.rhs = rhs_.data();
+  view.rhs_offset = rhs_offset_.data();
+  view.table = table_.data();
+  view.num_terminals = num_terminals_;
+  view.num_symbols = static_cast<uint32_t>(names_.size());
+  view.start_symbol = start_symbol_;
+  view.end_marker = end_marker_;
+  return view;
+}
+
+}  // namespace jucc::parser
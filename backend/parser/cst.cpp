@@ -0,0 +1,169 @@
+#include "parser/cst.h"
+
+#include <utility>
+
+#include "grammar/grammar.h"
+
+namespace jucc::parser {
+
+const std::string &ConcreteSyntaxTree::SymbolName(const std::vector<std::string> &names, SymbolId symbol) {
+  static const std::string epsilon(grammar::EPSILON);
+  return symbol == kEpsilonSymbol ? epsilon : names[symbol];
+}
+
+ConcreteSyntaxTree::Builder::Builder(const GrammarView &grammar, ConcreteSyntaxTree &tree,
+                                     const std::vector<bool> *loops)
+    : grammar(grammar), tree(tree), loops(loops) {
+  tree.Clear();
+  NodeId root = tree.AddNodes(1);
+  tree.Node(root).symbol = grammar.start_symbol;
+  tree.SetRoot(root);
+  // the end marker at the bottom of the parse stack has no node
+  nodes = {kNoNode, root};
+}
+
+void ConcreteSyntaxTree::Builder::OnExpand(const SymbolId * /*stack*/, size_t /*depth*/, size_t /*pos*/,
+                                           RuleId rule) {
+  NodeId parent = nodes.back();
+  nodes.pop_back();
+
+  uint32_t begin = grammar.rhs_offset[rule];
+  uint32_t count = grammar.rhs_offset[rule + 1] - begin;
+  SymbolId symbol = tree.Node(parent).symbol;
+  bool loop = loops != nullptr && symbol < loops->size() && (*loops)[symbol];
+
+  // a loop node that has children is on its next iteration or leaving;
+  // loops left by synch recovery are still open above it
+  NodeId last = kNoNode;
+  if (loop && tree.Node(parent).first_child != kNoNode) {
+    while (!tails.empty() && tails.back().first != parent) {
+      tails.pop_back();
+    }
+    if (tails.empty()) {
+      for (last = tree.Node(parent).first_child; tree.Node(last).next_sibling != kNoNode;
+           last = tree.Node(last).next_sibling) {
+      }
+    } else {
+      last = tails.back().second;
+      tails.pop_back();
+    }
+  }
+  // bodies are stored reversed, rhs[begin] is the last symbol
+  bool again = loop && count != 0 && grammar.rhs[begin] == symbol;
+  if (again) {
+    begin++;
+    count--;
+  }
+
+  if (count == 0) {
+    if (last == kNoNode && !again) {
+      NodeId epsilon = tree.AddNodes(1);
+      tree.Node(epsilon).symbol = kEpsilonSymbol;
+      tree.Node(parent).first_child = epsilon;
+    }
+    return;
+  }
+
+  // child i is rhs[begin + count - 1 - i]
+  NodeId first = tree.AddNodes(count);
+  for (uint32_t i = 0; i < count; i++) {
+    CstNode &child = tree.Node(first + i);
+    child.symbol = grammar.rhs[begin + count - 1 - i];
+    child.next_sibling = i + 1 < count ? first + i + 1 : kNoNode;
+  }
+  if (last == kNoNode) {
+    tree.Node(parent).first_child = first;
+  } else {
+    tree.Node(last).next_sibling = first;
+  }
+  if (again) {
+    // the loop symbol stays on the parse stack, standing for the same node
+    nodes.push_back(parent);
+    tails.emplace_back(parent, first + count - 1);
+  }
+  for (uint32_t i = count; i > 0; i--) {
+    nodes.push_back(first + i - 1);
+  }
+}
+
+json ConcreteSyntaxTree::ToJson(const std::vector<std::string> &names) const {
+  json tree = json::object({});
+  if (root_ == kNoNode) {
+    return tree;
+  }
+
+  std::vector<std::pair<NodeId, json *>> pending;
+  const std::string &root_name = SymbolName(names, nodes_[root_].symbol);
+  tree[root_name] = json::object({});
+  pending.emplace_back(root_, &tree[root_name]);
+
+  std::vector<std::pair<SymbolId, int>> seen;
+  while (!pending.empty()) {
+    auto [id, target] = pending.back();
+    pending.pop_back();
+
+    seen.clear();
+    for (NodeId child = nodes_[id].first_child; child != kNoNode; child = nodes_[child].next_sibling) {
+      const CstNode &node = nodes_[child];
+      // rename repeated siblings A, A_1, A_2 ... so that keys stay unique
+      int count = 0;
+      for (auto &entry : seen) {
+        if (entry.first == node.symbol) {
+          count = ++entry.second;
+          break;
+        }
+      }
+      if (count == 0) {
+        seen.emplace_back(node.symbol, 0);
+      }
+      std::string key = SymbolName(names, node.symbol);
+      if (count != 0) {
+        key += "_" + std::to_string(count);
+      }
+
+      if (node.first_child == kNoNode && node.token != kNoNode) {
+        (*target)[key] = json();
+      } else {
+        (*target)[key] = json::object({});
+        pending.emplace_back(child, &(*target)[key]);
+      }
+    }
+  }
+  return tree;
+}
+
+json ConcreteSyntaxTree::ToTreantJson(const std::vector<std::string> &names) const {
+  json tree = json::object({});
+  if (root_ == kNoNode) {
+    return tree;
+  }
+
+  std::vector<std::pair<NodeId, json *>> pending{{root_, &tree}};
+  while (!pending.empty()) {
+    auto [id, target] = pending.back();
+    pending.pop_back();
+
+    (*target)["text"]["name"] = SymbolName(names, nodes_[id].symbol);
+    size_t count = 0;
+    for (NodeId child = nodes_[id].first_child; child != kNoNode; child = nodes_[child].next_sibling) {
+      count++;
+    }
+    if (count == 0) {
+      continue;
+    }
+
+    // size the array up front so that element pointers stay valid
+    json &children = (*target)["children"];
+    children = json::array();
+    for (size_t i = 0; i < count; i++) {
+      children.push_back(json::object());
+    }
+    size_t i = 0;
+    for (NodeId child = nodes_[id].first_child; child != kNoNode; child = nodes_[child].next_sibling) {
+      pending.emplace_back(child, &children[i++]);
+    }
+  }
+  return tree;
+}
+
+}  // namespace jucc::parser
@@ -0,0 +1,101 @@
+#include "parser/cst_compaction.h"
+
+namespace jucc::parser {
+
+namespace {
+
+/**
+ * Sibling list of compacted nodes, linked through next_sibling.
+ */
+struct NodeList {
+  NodeId head{kNoNode};
+  NodeId tail{kNoNode};
+  size_t count{0};
+};
+
+void Append(ConcreteSyntaxTree &tree, NodeList &list, const NodeList &other) {
+  if (other.count == 0) {
+    return;
+  }
+  if (list.count == 0) {
+    list = other;
+    return;
+  }
+  tree.Node(list.tail).next_sibling = other.head;
+  list.tail = other.tail;
+  list.count += other.count;
+}
+
+NodeList Single(NodeId id) { return {id, id, 1}; }
+
+}  // namespace
+
+ConcreteSyntaxTree TreeCompactor::Compact(const ConcreteSyntaxTree &tree, const std::vector<bool> &helpers,
+                                          const CompactionOptions &options) {
+  ConcreteSyntaxTree out;
+  if (tree.Empty()) {
+    return out;
+  }
+  out.Reserve(tree.Size());
+
+  auto is_helper = [&](SymbolId symbol) {
+    return options.fold_helpers && symbol < helpers.size() && helpers[symbol];
+  };
+
+  // one frame per interior node whose children are being compacted
+  struct Frame {
+    NodeId id;
+    NodeId next;
+    NodeList children;
+  };
+  std::vector<Frame> frames{{tree.Root(), tree.Node(tree.Root()).first_child, {}}};
+  NodeList result;
+
+  while (!frames.empty()) {
+    NodeId next = frames.back().next;
+    if (next != kNoNode) {
+      const CstNode &node = tree.Node(next);
+      frames.back().next = node.next_sibling;
+      if (node.first_child != kNoNode) {
+        frames.push_back({next, node.first_child, {}});
+        continue;
+      }
+
+      // leaf: a matched terminal, an epsilon or a non terminal left unexpanded after an error
+      if ((options.drop_epsilon && node.symbol == kEpsilonSymbol) || is_helper(node.symbol)) {
+        continue;
+      }
+      NodeId copy = out.AddNodes(1);
+      out.Node(copy).symbol = node.symbol;
+      out.Node(copy).token = node.token;
+      Append(out, frames.back().children, Single(copy));
+      continue;
+    }
+
+    Frame done = frames.back();
+    frames.pop_back();
+    bool is_root = frames.empty();
+    SymbolId symbol = tree.Node(done.id).symbol;
+
+    NodeList list;
+    if ((!is_root && is_helper(symbol)) || (options.collapse_unary && done.children.count == 1)) {
+      list = done.children;
+    } else {
+      NodeId copy = out.AddNodes(1);
+      out.Node(copy).symbol = symbol;
+      out.Node(copy).first_child = done.children.head;
+      list = Single(copy);
+    }
+
+    if (is_root) {
+      result = list;
+    } else {
+      Append(out, frames.back().children, list);
+    }
+  }
+
+  out.SetRoot(result.head);
+  return out;
+}
+
+}  // namespace jucc::parser
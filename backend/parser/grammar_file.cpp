@@ -0,0 +1,390 @@
+#include "parser/grammar_file.h"
+
+#include <cstring>
+#include <limits>
+
+#include "utils/output_buffer.h"
+
+namespace jucc::parser {
+
+namespace {
+
+struct Header {
+  char magic[4];
+  uint32_t version;
+  uint64_t file_size;
+  uint64_t checksum;
+  uint32_t num_symbols;
+  uint32_t num_terminals;
+  uint32_t num_rules;
+  uint32_t num_rhs;
+  uint32_t start_symbol;
+  uint32_t end_marker;
+  uint32_t hash_capacity;
+  uint32_t set_words;
+  uint64_t section_offset[GRAMMAR_FILE_SECTIONS];
+};
+
+enum Section {
+  NAME_OFFSET,
+  NAME_BYTES,
+  NAME_HASH,
+  RHS_OFFSET,
+  RHS,
+  RULE_PARENT,
+  RULE_KEY,
+  RULE_TEXT_OFFSET,
+  RULE_TEXT,
+  TABLE,
+  FIRST,
+  FOLLOW,
+  NULLABLE,
+  SYMBOL_FLAGS,
+};
+
+uint32_t HashName(std::string_view name) {
+  // FNV-1a
+  uint32_t hash = 2166136261U;
+  for (char c : name) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 16777619U;
+  }
+  return hash;
+}
+
+/**
+ * FNV-1a style hash over 8 byte words, size is a multiple of 8.
+ */
+uint64_t Checksum(const char *data, size_t size) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i + 8 <= size; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * 1099511628211ULL;
+    hash ^= hash >> 29;
+  }
+  return hash;
+}
+
+class Image {
+  std::vector<char> bytes_;
+
+ public:
+  /**
+   * Appends values as a new section, padded to 8 bytes.
+   * @returns the offset of the section in the file
+   */
+  template <typename T>
+  uint64_t Add(const T *values, size_t count) {
+    uint64_t offset = sizeof(Header) + bytes_.size();
+    const char *data = reinterpret_cast<const char *>(values);
+    bytes_.insert(bytes_.end(), data, data + count * sizeof(T));
+    bytes_.resize((bytes_.size() + 7) & ~static_cast<size_t>(7), '\0');
+    return offset;
+  }
+  template <typename T>
+  uint64_t Add(const std::vector<T> &values) {
+    return Add(values.data(), values.size());
+  }
+  [[nodiscard]] const std::vector<char> &Bytes() const { return bytes_; }
+};
+
+/**
+ * Appends value to a string list stored as end offsets into one byte run.
+ */
+void AddString(std::string_view value, std::vector<uint32_t> &offsets, std::string &bytes) {
+  bytes.append(value);
+  offsets.push_back(static_cast<uint32_t>(bytes.size()));
+}
+
+/**
+ * offsets[0, count] starts at 0 and never decreases.
+ */
+bool Monotonic(const uint32_t *offsets, uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    if (offsets[i] > offsets[i + 1]) {
+      return false;
+    }
+  }
+  return offsets[0] == 0;
+}
+
+}  // namespace
+
+bool WriteGrammarFile(const std::string &filepath, const CompiledGrammar &compiled,
+                      const grammar::Productions &productions, const utils::SymbolsMap &firsts,
+                      const utils::SymbolsMap &follows) {
+  GrammarView view = compiled.View();
+  uint32_t num_symbols = compiled.GetNumSymbols();
+  uint32_t num_terminals = compiled.GetNumTerminals();
+  uint32_t num_non_terminals = num_symbols - num_terminals;
+  auto num_rules = static_cast<uint32_t>(compiled.GetNumRules());
+
+  Header header{};
+  std::memcpy(header.magic, GRAMMAR_FILE_MAGIC, sizeof(header.magic));
+  header.version = GRAMMAR_FILE_VERSION;
+  header.num_symbols = num_symbols;
+  header.num_terminals = num_terminals;
+  header.num_rules = num_rules;
+  header.num_rhs = view.rhs_offset[num_rules];
+  header.start_symbol = view.start_symbol;
+  header.end_marker = view.end_marker;
+  header.set_words = (num_terminals + 63) / 64;
+  header.hash_capacity = 1;
+  while (header.hash_capacity < 2 * num_symbols) {
+    header.hash_capacity *= 2;
+  }
+
+  Image image;
+  std::vector<uint32_t> name_offset{0};
+  std::string names;
+  for (const auto &name : compiled.GetNames()) {
+    AddString(name, name_offset, names);
+  }
+  header.section_offset[NAME_OFFSET] = image.Add(name_offset);
+  header.section_offset[NAME_BYTES] = image.Add(names.data(), names.size());
+
+  // open addressing with linear probing, symbol 0 (unknown) is not indexed
+  std::vector<uint32_t> name_hash(header.hash_capacity, 0);
+  for (uint32_t symbol = 1; symbol < num_symbols; symbol++) {
+    uint32_t slot = HashName(compiled.GetName(static_cast<SymbolId>(symbol))) & (header.hash_capacity - 1);
+    while (name_hash[slot] != 0) {
+      slot = (slot + 1) & (header.hash_capacity - 1);
+    }
+    name_hash[slot] = symbol + 1;
+  }
+  header.section_offset[NAME_HASH] = image.Add(name_hash);
+
+  header.section_offset[RHS_OFFSET] = image.Add(view.rhs_offset, num_rules + 1);
+  header.section_offset[RHS] = image.Add(view.rhs, header.num_rhs);
+
+  std::vector<SymbolId> rule_parent;
+  std::vector<int32_t> rule_key;
+  for (RuleId rule = 0; rule < static_cast<RuleId>(num_rules); rule++) {
+    rule_parent.push_back(compiled.GetRuleParent(rule));
+    rule_key.push_back(compiled.GetRuleKey(rule));
+  }
+  header.section_offset[RULE_PARENT] = image.Add(rule_parent);
+  header.section_offset[RULE_KEY] = image.Add(rule_key);
+
+  std::vector<uint32_t> rule_text_offset{0};
+  std::string rule_text;
+  for (const auto &prod : productions) {
+    for (const auto &rule : prod.GetRules()) {
+      std::string text;
+      for (const auto &entity : rule.GetEntities()) {
+        text += text.empty() ? entity : " " + entity;
+      }
+      AddString(text, rule_text_offset, rule_text);
+    }
+  }
+  if (rule_text_offset.size() != num_rules + 1) {
+    return false;
+  }
+  header.section_offset[RULE_TEXT_OFFSET] = image.Add(rule_text_offset);
+  header.section_offset[RULE_TEXT] = image.Add(rule_text.data(), rule_text.size());
+
+  header.section_offset[TABLE] = image.Add(view.table, static_cast<size_t>(num_non_terminals) * num_terminals);
+
+  std::vector<uint64_t> nullable((num_non_terminals + 63) / 64, 0);
+  for (const auto *sets : {&firsts, &follows}) {
+    std::vector<uint64_t> bits(static_cast<size_t>(num_non_terminals) * header.set_words, 0);
+    for (const auto &entry : *sets) {
+      SymbolId nt = compiled.Lookup(entry.first);
+      if (nt < num_terminals) {
+        continue;
+      }
+      uint32_t row = nt - num_terminals;
+      for (const auto &term : entry.second) {
+        if (term == std::string(grammar::EPSILON)) {
+          nullable[row / 64] |= 1ULL << (row % 64);
+          continue;
+        }
+        SymbolId id = compiled.Lookup(term);
+        if (id != kUnknownSymbol && id < num_terminals) {
+          bits[static_cast<size_t>(row) * header.set_words + id / 64] |= 1ULL << (id % 64);
+        }
+      }
+    }
+    header.section_offset[sets == &firsts ? FIRST : FOLLOW] = image.Add(bits);
+  }
+  header.section_offset[NULLABLE] = image.Add(nullable);
+
+  std::vector<uint8_t> symbol_flags(num_symbols, 0);
+  for (uint32_t symbol = 0; symbol < num_symbols; symbol++) {
+    if (compiled.GetHelperSymbols()[symbol]) {
+      symbol_flags[symbol] |= SYMBOL_HELPER;
+    }
+    if (compiled.GetLoopSymbols()[symbol]) {
+      symbol_flags[symbol] |= SYMBOL_LOOP;
+    }
+  }
+  header.section_offset[SYMBOL_FLAGS] = image.Add(symbol_flags);
+
+  const auto &bytes = image.Bytes();
+  header.file_size = sizeof(Header) + bytes.size();
+  header.checksum = Checksum(bytes.data(), bytes.size());
+
+  auto out = utils::OutputBuffer::Open(filepath);
+  if (out.Failed()) {
+    return false;
+  }
+  out.Write(reinterpret_cast<const char *>(&header), sizeof(header));
+  out.Write(bytes.data(), bytes.size());
+  out.Flush();
+  return !out.Failed();
+}
+
+bool GrammarFile::Fail(const std::string &what) {
+  error_ = "grammar file error: " + what;
+  return false;
+}
+
+bool GrammarFile::Open(const std::string &filepath) {
+  if (!file_.Open(filepath)) {
+    error_ = file_.GetError();
+    return false;
+  }
+
+  Header header{};
+  if (file_.Size() < sizeof(Header)) {
+    return Fail("not a grammar file: " + filepath);
+  }
+  std::memcpy(&header, file_.Data(), sizeof(header));
+  if (std::memcmp(header.magic, GRAMMAR_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != GRAMMAR_FILE_VERSION) {
+    return Fail("not a grammar file or unsupported version: " + filepath);
+  }
+  if (header.file_size != file_.Size()) {
+    return Fail("truncated file: " + filepath);
+  }
+  if (header.num_terminals == 0 || header.num_terminals > header.num_symbols ||
+      header.num_symbols > std::numeric_limits<SymbolId>::max() || header.hash_capacity == 0 ||
+      (header.hash_capacity & (header.hash_capacity - 1)) != 0 ||
+      header.set_words != (header.num_terminals + 63) / 64) {
+    return Fail("bad header: " + filepath);
+  }
+
+  uint64_t num_non_terminals = header.num_symbols - header.num_terminals;
+  uint64_t section_size[GRAMMAR_FILE_SECTIONS] = {
+      (header.num_symbols + 1ULL) * sizeof(uint32_t),
+      0,  // checked against name_offset below
+      header.hash_capacity * sizeof(uint32_t),
+      (header.num_rules + 1ULL) * sizeof(uint32_t),
+      header.num_rhs * sizeof(SymbolId),
+      header.num_rules * sizeof(SymbolId),
+      header.num_rules * sizeof(int32_t),
+      (header.num_rules + 1ULL) * sizeof(uint32_t),
+      0,  // checked against rule_text_offset below
+      num_non_terminals * header.num_terminals * sizeof(RuleId),
+      num_non_terminals * header.set_words * sizeof(uint64_t),
+      num_non_terminals * header.set_words * sizeof(uint64_t),
+      (num_non_terminals + 63) / 64 * sizeof(uint64_t),
+      header.num_symbols * sizeof(uint8_t),
+  };
+  for (size_t i = 0; i < GRAMMAR_FILE_SECTIONS; i++) {
+    uint64_t offset = header.section_offset[i];
+    if (offset % 8 != 0 || offset < sizeof(Header) || offset > header.file_size ||
+        section_size[i] > header.file_size - offset) {
+      return Fail("section out of bounds: " + filepath);
+    }
+  }
+
+  const char *base = file_.Data();
+  auto section = [&](Section s) { return base + header.section_offset[s]; };
+  name_offset_ = reinterpret_cast<const uint32_t *>(section(NAME_OFFSET));
+  names_ = section(NAME_BYTES);
+  name_hash_ = reinterpret_cast<const uint32_t *>(section(NAME_HASH));
+  view_.rhs_offset = reinterpret_cast<const uint32_t *>(section(RHS_OFFSET));
+  view_.rhs = reinterpret_cast<const SymbolId *>(section(RHS));
+  rule_parent_ = reinterpret_cast<const SymbolId *>(section(RULE_PARENT));
+  rule_key_ = reinterpret_cast<const int32_t *>(section(RULE_KEY));
+  rule_text_offset_ = reinterpret_cast<const uint32_t *>(section(RULE_TEXT_OFFSET));
+  rule_text_ = section(RULE_TEXT);
+  view_.table = reinterpret_cast<const RuleId *>(section(TABLE));
+  first_ = reinterpret_cast<const uint64_t *>(section(FIRST));
+  follow_ = reinterpret_cast<const uint64_t *>(section(FOLLOW));
+  nullable_ = reinterpret_cast<const uint64_t *>(section(NULLABLE));
+  symbol_flags_ = reinterpret_cast<const uint8_t *>(section(SYMBOL_FLAGS));
+
+  view_.num_terminals = header.num_terminals;
+  view_.num_symbols = header.num_symbols;
+  view_.start_symbol = static_cast<SymbolId>(header.start_symbol);
+  view_.end_marker = static_cast<SymbolId>(header.end_marker);
+  num_rules_ = header.num_rules;
+  hash_capacity_ = header.hash_capacity;
+  set_words_ = header.set_words;
+
+  if (header.start_symbol < header.num_terminals || header.start_symbol >= header.num_symbols ||
+      header.end_marker >= header.num_terminals) {
+    return Fail("bad start symbol or end marker: " + filepath);
+  }
+  // string sections run up to the next section
+  if (header.section_offset[NAME_HASH] < header.section_offset[NAME_BYTES] ||
+      header.section_offset[TABLE] < header.section_offset[RULE_TEXT]) {
+    return Fail("section out of bounds: " + filepath);
+  }
+  name_bytes_ = header.section_offset[NAME_HASH] - header.section_offset[NAME_BYTES];
+  rule_text_bytes_ = header.section_offset[TABLE] - header.section_offset[RULE_TEXT];
+  num_rhs_ = header.num_rhs;
+  checksum_ = header.checksum;
+  path_ = filepath;
+  return true;
+}
+
+bool GrammarFile::Verify() {
+  if (Checksum(file_.Data() + sizeof(Header), file_.Size() - sizeof(Header)) != checksum_) {
+    return Fail("checksum mismatch: " + path_);
+  }
+  if (!Validate(name_bytes_, rule_text_bytes_, num_rhs_)) {
+    return Fail("inconsistent tables: " + path_);
+  }
+  return true;
+}
+
+bool GrammarFile::Validate(uint64_t name_bytes, uint64_t rule_text_bytes, uint32_t num_rhs) {
+  // the driver and the accessors index with these values unchecked
+  if (!Monotonic(name_offset_, view_.num_symbols) || name_offset_[view_.num_symbols] > name_bytes ||
+      !Monotonic(rule_text_offset_, num_rules_) || rule_text_offset_[num_rules_] > rule_text_bytes ||
+      !Monotonic(view_.rhs_offset, num_rules_) || view_.rhs_offset[num_rules_] != num_rhs) {
+    return false;
+  }
+  for (uint32_t i = 0; i < num_rhs; i++) {
+    if (view_.rhs[i] >= view_.num_symbols) {
+      return false;
+    }
+  }
+  for (uint32_t rule = 0; rule < num_rules_; rule++) {
+    if (rule_parent_[rule] < view_.num_terminals || rule_parent_[rule] >= view_.num_symbols) {
+      return false;
+    }
+  }
+  size_t cells = static_cast<size_t>(view_.num_symbols - view_.num_terminals) * view_.num_terminals;
+  for (size_t i = 0; i < cells; i++) {
+    if (view_.table[i] < kSynchEntry || view_.table[i] >= static_cast<RuleId>(num_rules_)) {
+      return false;
+    }
+  }
+  for (uint32_t slot = 0; slot < hash_capacity_; slot++) {
+    if (name_hash_[slot] > view_.num_symbols) {
+      return false;
+    }
+  }
+  return true;
+}
+
+SymbolId GrammarFile::Lookup(std::string_view name) const {
+  uint32_t slot = HashName(name) & (hash_capacity_ - 1);
+  for (uint32_t probes = 0; probes < hash_capacity_; probes++) {
+    uint32_t entry = name_hash_[slot];
+    if (entry == 0) {
+      break;
+    }
+    if (GetName(static_cast<SymbolId>(entry - 1)) == name) {
+      return static_cast<SymbolId>(entry - 1);
+    }
+    slot = (slot + 1) & (hash_capacity_ - 1);
+  }
+  return kUnknownSymbol;
+}
+
+}  // namespace jucc::parser
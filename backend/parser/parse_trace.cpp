@@ -0,0 +1,94 @@
+#include "parser/parse_trace.h"
+
+#include <algorithm>
+
+namespace jucc::parser {
+
+const char *TraceActionName(TraceAction action) {
+  switch (action) {
+    case TraceAction::MATCH:
+      return "match";
+    case TraceAction::SYNCH:
+      return "sync: skipping non-terminal";
+    case TraceAction::ERROR_NO_RULE:
+      return "error: no production rule";
+    case TraceAction::ERROR_MISMATCH:
+      return "error: terminal mismatch";
+    case TraceAction::ACCEPT:
+      return "accept";
+    case TraceAction::EXPAND:
+      break;
+  }
+  return "";
+}
+
+void WriteTraceEntryJson(utils::JsonEmitter &json, const TraceEntry &entry) {
+  json.BeginObject();
+  json.Key("stack_top");
+  json.String(entry.stack_top);
+  json.Key("full_stack");
+  json.BeginArray(true);
+  for (const auto &symbol : entry.full_stack) {
+    json.String(symbol);
+  }
+  json.EndArray();
+  json.Key("input");
+  json.String(entry.current_input);
+  json.Key("action");
+  json.String(entry.action);
+  json.EndObject();
+}
+
+void ParseTrace::Clear() {
+  events_.clear();
+  checkpoint_stack_.clear();
+  checkpoint_offset_.clear();
+}
+
+void ParseTrace::Record(TraceAction action, const SymbolId *stack, size_t depth, size_t pos, RuleId rule) {
+  if (level_ == TraceLevel::FULL && events_.size() % checkpoint_interval_ == 0) {
+    checkpoint_offset_.push_back(static_cast<uint32_t>(checkpoint_stack_.size()));
+    checkpoint_stack_.insert(checkpoint_stack_.end(), stack, stack + depth);
+  }
+  events_.push_back({action, stack[depth - 1], static_cast<uint32_t>(pos), rule});
+}
+
+void ParseTrace::Apply(const GrammarView &grammar, const TraceEvent &event, std::vector<SymbolId> &stack) {
+  switch (event.action) {
+    case TraceAction::MATCH:
+    case TraceAction::SYNCH:
+      stack.pop_back();
+      break;
+    case TraceAction::EXPAND:
+      stack.pop_back();
+      stack.insert(stack.end(), grammar.rhs + grammar.rhs_offset[event.rule],
+                   grammar.rhs + grammar.rhs_offset[event.rule + 1]);
+      break;
+    case TraceAction::ACCEPT:
+    case TraceAction::ERROR_NO_RULE:
+    case TraceAction::ERROR_MISMATCH:
+      break;
+  }
+}
+
+std::vector<SymbolId> ParseTrace::StackAt(const GrammarView &grammar, size_t step) const {
+  std::vector<SymbolId> stack;
+  size_t replay_from = 0;
+  if (!checkpoint_offset_.empty()) {
+    size_t checkpoint = std::min(step / checkpoint_interval_, checkpoint_offset_.size() - 1);
+    size_t begin = checkpoint_offset_[checkpoint];
+    size_t end = checkpoint + 1 < checkpoint_offset_.size() ? checkpoint_offset_[checkpoint + 1]
+                                                            : checkpoint_stack_.size();
+    stack.assign(checkpoint_stack_.begin() + static_cast<ptrdiff_t>(begin),
+                 checkpoint_stack_.begin() + static_cast<ptrdiff_t>(end));
+    replay_from = checkpoint * checkpoint_interval_;
+  } else {
+    stack = {grammar.end_marker, grammar.start_symbol};
+  }
+  for (size_t i = replay_from; i < step && i < events_.size(); i++) {
+    Apply(grammar, events_[i], stack);
+  }
+  return stack;
+}
+
+}  // namespace jucc::parser
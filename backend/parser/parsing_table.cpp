@@ -1,8 +1,9 @@
 #include "../include/parser/parsing_table.h"
 #include <algorithm>
 #include <sstream>
-#include <fstream>
 #include <iostream>
+#include <unordered_set>
+#include "../include/utils/json_emitter.h"
 
 namespace jucc::parser {
 
@@ -45,41 +46,51 @@ void ParsingTable::BuildTable() {
     const auto& rules = productions_[prod_no].GetRules();
     for (size_t rule_no = 0; rule_no < rules.size(); rule_no++) {
       const auto& entities = rules[rule_no].GetEntities();
-      
-      if (entities.empty()) {
-        // epsilon production
-        if (follows_.count(productions_[prod_no].GetParent()) != 0U) {
-          for (const auto &symbol : follows_[productions_[prod_no].GetParent()]) {
-            auto& entry = table_[productions_[prod_no].GetParent()][symbol];
-            if (entry.first != -1 && entry.first != -2) {
-              errors_.push_back(GenerateErrorMessage(productions_[prod_no].GetParent(), symbol));
-            }
-            entry = std::make_pair(prod_no, rule_no);
-          }
-        }
-        continue;
-      }
-
-      std::string first_entity = entities[0];
-      // check if first_entity is terminal
-      if (std::find(terminals_.begin(), terminals_.end(), first_entity) != terminals_.end()) {
-        auto& entry = table_[productions_[prod_no].GetParent()][first_entity];
+      const std::string& parent = productions_[prod_no].GetParent();
+      auto add_entry = [&](const std::string& symbol) {
+        auto& entry = table_[parent][symbol];
         if (entry.first != -1 && entry.first != -2) {
-          errors_.push_back(GenerateErrorMessage(productions_[prod_no].GetParent(), first_entity));
+          errors_.push_back(GenerateErrorMessage(parent, symbol));
         }
         entry = std::make_pair(prod_no, rule_no);
-      }
-      // first entity is a non-terminal
-      else if (firsts_.count(first_entity) != 0U) {
-        for (const auto &symbol : firsts_[first_entity]) {
-          if (symbol != "EPSILON") {
-            auto& entry = table_[productions_[prod_no].GetParent()][symbol];
-            if (entry.first != -1 && entry.first != -2) {
-              errors_.push_back(GenerateErrorMessage(productions_[prod_no].GetParent(), symbol));
-            }
-            entry = std::make_pair(prod_no, rule_no);
+      };
+
+      // FIRST of the rule body, walking past nullable non terminals;
+      // EPSILON entities (["EPSILON"] bodies) derive nothing
+      bool nullable = true;
+      for (const auto& entity : entities) {
+        if (entity == std::string(grammar::EPSILON)) {
+          continue;
+        }
+        if (std::find(terminals_.begin(), terminals_.end(), entity) != terminals_.end()) {
+          add_entry(entity);
+          nullable = false;
+          break;
+        }
+        if (firsts_.count(entity) == 0U) {
+          // undefined symbol, nothing can be derived past it
+          nullable = false;
+          break;
+        }
+        bool entity_nullable = false;
+        for (const auto& symbol : firsts_[entity]) {
+          if (symbol == std::string(grammar::EPSILON)) {
+            entity_nullable = true;
+          } else {
+            add_entry(symbol);
           }
         }
+        if (!entity_nullable) {
+          nullable = false;
+          break;
+        }
+      }
+
+      // epsilon production
+      if (nullable && follows_.count(parent) != 0U) {
+        for (const auto& symbol : follows_[parent]) {
+          add_entry(symbol);
+        }
       }
     }
   }
@@ -89,42 +100,134 @@ std::pair<int, int> ParsingTable::GetEntry(const std::string &non_terminal, cons
   return table_[non_terminal][terminal];
 }
 
-void ParsingTable::DumpAsJson(const std::string &filepath) const {
-  std::ofstream out(filepath);
-  if (!out.is_open()) {
+std::vector<std::string> ParsingTable::RowOrder() const {
+  std::vector<std::string> rows;
+  std::unordered_set<std::string> seen;
+  for (const auto &nt : non_terminals_) {
+    if (table_.count(nt) != 0U && seen.insert(nt).second) {
+      rows.push_back(nt);
+    }
+  }
+  std::vector<std::string> others;
+  for (const auto &row : table_) {
+    if (seen.count(row.first) == 0U) {
+      others.push_back(row.first);
+    }
+  }
+  std::sort(others.begin(), others.end());
+  rows.insert(rows.end(), others.begin(), others.end());
+  return rows;
+}
+
+std::vector<std::string> ParsingTable::ColumnOrder() const {
+  std::vector<std::string> columns;
+  std::unordered_set<std::string> seen;
+  for (const auto &t : terminals_) {
+    if (seen.insert(t).second) {
+      columns.push_back(t);
+    }
+  }
+  std::vector<std::string> others;
+  for (const auto &row : table_) {
+    for (const auto &cell : row.second) {
+      if (seen.insert(cell.first).second) {
+        others.push_back(cell.first);
+      }
+    }
+  }
+  std::sort(others.begin(), others.end());
+  columns.insert(columns.end(), others.begin(), others.end());
+  return columns;
+}
+
+void ParsingTable::DumpAsJson(const std::string &filepath, bool compact) const {
+  auto out = utils::OutputBuffer::Open(filepath);
+  if (out.Failed()) {
     std::cerr << "Failed to open output file: " << filepath << std::endl;
     return;
   }
 
-  out << "{\n";
-  bool first_nt = true;
-  for (const auto &nt_pair : table_) {
-    if (!first_nt) out << ",\n";
-    first_nt = false;
-    out << "  \"" << nt_pair.first << "\": {";
-    
-    bool first_t = true;
-    for (const auto &t_pair : nt_pair.second) {
-      if (!first_t) out << ",";
-      first_t = false;
-      
+  std::vector<std::string> columns = ColumnOrder();
+  utils::JsonEmitter json(out, compact);
+  json.BeginObject();
+  for (const auto &nt : RowOrder()) {
+    const auto &row = table_.at(nt);
+    json.Key(nt);
+    json.BeginObject();
+    for (const auto &t : columns) {
+      auto cell = row.find(t);
+      if (cell == row.end()) {
+        continue;
+      }
+      json.Key(t);
       // Convert the pair to a string representation
-      std::string value;
-      if (t_pair.second.first == -1) {
-        value = "error";
-      } else if (t_pair.second.first == -2) {
-        value = "synch";
+      if (cell->second.first == -1) {
+        json.String(ERROR_TOKEN);
+      } else if (cell->second.first == -2) {
+        json.String(SYNCH_TOKEN);
       } else {
-        value = std::to_string(t_pair.second.first * 100 + t_pair.second.second);
+        json.String(std::to_string(cell->second.first * 100 + cell->second.second));
       }
-      
-      out << "\n    \"" << t_pair.first << "\": \"" << value << "\"";
     }
-    out << "\n  }";
+    json.EndObject();
   }
-  out << "\n}\n";
+  json.EndObject();
+  json.Finish();
+}
 
-  out.close();
+void ParsingTable::DumpAsSparseJson(const std::string &filepath, bool compact) const {
+  auto out = utils::OutputBuffer::Open(filepath);
+  if (out.Failed()) {
+    std::cerr << "Failed to open output file: " << filepath << std::endl;
+    return;
+  }
+
+  std::vector<std::string> columns = ColumnOrder();
+  utils::JsonEmitter json(out, compact);
+  json.BeginObject();
+  json.Key("format");
+  json.String("sparse");
+  json.Key("terminals");
+  json.BeginArray(true);
+  for (const auto &t : columns) {
+    json.String(t);
+  }
+  json.EndArray();
+
+  json.Key("rows");
+  json.BeginObject();
+  std::vector<const std::string *> synch;
+  for (const auto &nt : RowOrder()) {
+    const auto &row = table_.at(nt);
+    json.Key(nt);
+    json.BeginObject();
+    json.Key("cells");
+    json.BeginObject(true);
+    synch.clear();
+    for (const auto &t : columns) {
+      auto cell = row.find(t);
+      if (cell == row.end() || cell->second.first == -1) {
+        continue;
+      }
+      if (cell->second.first == -2) {
+        synch.push_back(&t);
+        continue;
+      }
+      json.Key(t);
+      json.Int(cell->second.first * 100 + cell->second.second);
+    }
+    json.EndObject();
+    json.Key("synch");
+    json.BeginArray(true);
+    for (const auto *t : synch) {
+      json.String(*t);
+    }
+    json.EndArray();
+    json.EndObject();
+  }
+  json.EndObject();
+  json.EndObject();
+  json.Finish();
 }
 
 }  // namespace jucc::parser
@@ -0,0 +1,333 @@
+#include "parser/trace_file.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace jucc::parser {
+
+namespace {
+
+template <typename T>
+void WritePod(std::ofstream &out, const T &value) {
+  out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadPod(std::ifstream &in, T &value) {
+  return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+void WriteString(std::ofstream &out, const std::string &value) {
+  WritePod(out, static_cast<uint32_t>(value.size()));
+  out.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+/**
+ * Reads a length prefixed string, failing if it would run past size, the
+ * size of the file.
+ */
+bool ReadString(std::ifstream &in, uint64_t size, std::string &value) {
+  uint32_t length = 0;
+  if (!ReadPod(in, length)) {
+    return false;
+  }
+  auto pos = static_cast<uint64_t>(in.tellg());
+  if (pos > size || length > size - pos) {
+    return false;
+  }
+  value.resize(length);
+  return static_cast<bool>(in.read(value.data(), length));
+}
+
+/**
+ * count elements of element_size bytes starting at offset fit in a file of
+ * size bytes.
+ */
+bool Fits(uint64_t offset, uint64_t count, uint64_t element_size, uint64_t size) {
+  return offset <= size && count <= (size - offset) / element_size;
+}
+
+// events are packed field by field, 11 bytes each
+constexpr size_t EVENT_SIZE = sizeof(uint8_t) + sizeof(SymbolId) + sizeof(uint32_t) + sizeof(RuleId);
+
+struct Header {
+  char magic[4];
+  uint32_t version;
+  uint32_t interval;
+  uint32_t num_chunks;
+  uint64_t num_steps;
+  uint64_t names_offset;
+  uint64_t rules_offset;
+  uint64_t tokens_offset;
+  uint64_t index_offset;
+};
+
+}  // namespace
+
+bool WriteTraceFile(const std::string &filepath, const ParseTrace &trace, const CompiledGrammar &grammar,
+                    const std::vector<std::string> &rule_actions, const std::vector<std::string> &input,
+                    uint32_t interval) {
+  std::ofstream out(filepath, std::ios::binary);
+  if (!out.is_open()) {
+    return false;
+  }
+  if (interval == 0) {
+    interval = 1;
+  }
+
+  GrammarView view = grammar.View();
+  Header header{};
+  std::memcpy(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic));
+  header.version = TRACE_FILE_VERSION;
+  header.interval = interval;
+  header.num_steps = trace.Size();
+  header.num_chunks = static_cast<uint32_t>((trace.Size() + interval - 1) / interval);
+  WritePod(out, header);
+
+  // chunks, the stack is replayed here so checkpoints do not depend on the trace level
+  std::vector<uint64_t> chunk_offset;
+  std::vector<SymbolId> stack{view.end_marker, view.start_symbol};
+  const auto &events = trace.GetEvents();
+  for (size_t begin = 0; begin < events.size(); begin += interval) {
+    size_t end = std::min(events.size(), begin + interval);
+    chunk_offset.push_back(static_cast<uint64_t>(out.tellp()));
+    WritePod(out, static_cast<uint32_t>(stack.size()));
+    out.write(reinterpret_cast<const char *>(stack.data()),
+              static_cast<std::streamsize>(stack.size() * sizeof(SymbolId)));
+    WritePod(out, static_cast<uint32_t>(end - begin));
+    for (size_t i = begin; i < end; i++) {
+      WritePod(out, static_cast<uint8_t>(events[i].action));
+      WritePod(out, events[i].stack_top);
+      WritePod(out, events[i].input_pos);
+      WritePod(out, events[i].rule);
+      ParseTrace::Apply(view, events[i], stack);
+    }
+  }
+
+  header.names_offset = static_cast<uint64_t>(out.tellp());
+  WritePod(out, grammar.GetNumSymbols());
+  for (const auto &name : grammar.GetNames()) {
+    WriteString(out, name);
+  }
+
+  header.rules_offset = static_cast<uint64_t>(out.tellp());
+  auto num_rules = static_cast<uint32_t>(grammar.GetNumRules());
+  WritePod(out, num_rules);
+  out.write(reinterpret_cast<const char *>(view.rhs_offset),
+            static_cast<std::streamsize>((num_rules + 1) * sizeof(uint32_t)));
+  out.write(reinterpret_cast<const char *>(view.rhs),
+            static_cast<std::streamsize>(view.rhs_offset[num_rules] * sizeof(SymbolId)));
+  for (uint32_t rule = 0; rule < num_rules; rule++) {
+    WriteString(out, rule < rule_actions.size() ? rule_actions[rule] : std::string());
+  }
+
+  header.tokens_offset = static_cast<uint64_t>(out.tellp());
+  WritePod(out, static_cast<uint32_t>(input.size()));
+  uint32_t offset = 0;
+  WritePod(out, offset);
+  for (const auto &token : input) {
+    offset += static_cast<uint32_t>(token.size());
+    WritePod(out, offset);
+  }
+  for (const auto &token : input) {
+    out.write(token.data(), static_cast<std::streamsize>(token.size()));
+  }
+
+  header.index_offset = static_cast<uint64_t>(out.tellp());
+  out.write(reinterpret_cast<const char *>(chunk_offset.data()),
+            static_cast<std::streamsize>(chunk_offset.size() * sizeof(uint64_t)));
+
+  out.seekp(0);
+  WritePod(out, header);
+  return static_cast<bool>(out);
+}
+
+bool TraceFileReader::Open(const std::string &filepath) {
+  file_ = std::ifstream(filepath, std::ios::binary);
+  if (!file_.is_open()) {
+    error_ = "trace file error: file not found: " + filepath;
+    return false;
+  }
+  file_.seekg(0, std::ios::end);
+  auto size = static_cast<uint64_t>(file_.tellg());
+  file_.seekg(0);
+
+  Header header{};
+  if (!ReadPod(file_, header) || std::memcmp(header.magic, TRACE_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != TRACE_FILE_VERSION || header.interval == 0) {
+    error_ = "trace file error: not a trace file or unsupported version";
+    return false;
+  }
+  interval_ = header.interval;
+  num_steps_ = header.num_steps;
+  tokens_offset_ = header.tokens_offset;
+
+  // every count and offset is checked against the file size before anything is allocated for it
+  error_ = "trace file error: truncated or corrupt file";
+  uint32_t num_names = 0;
+  if (!Fits(header.names_offset, 1, sizeof(uint32_t), size) ||
+      !file_.seekg(static_cast<std::streamoff>(header.names_offset)) || !ReadPod(file_, num_names) ||
+      !Fits(header.names_offset + sizeof(uint32_t), num_names, sizeof(uint32_t), size)) {
+    return false;
+  }
+  names_.resize(num_names);
+  for (auto &name : names_) {
+    if (!ReadString(file_, size, name)) {
+      return false;
+    }
+  }
+
+  uint32_t num_rules = 0;
+  uint64_t rhs_offsets = header.rules_offset + sizeof(uint32_t);
+  if (!Fits(header.rules_offset, 1, sizeof(uint32_t), size) ||
+      !file_.seekg(static_cast<std::streamoff>(header.rules_offset)) || !ReadPod(file_, num_rules) ||
+      !Fits(rhs_offsets, static_cast<uint64_t>(num_rules) + 1, sizeof(uint32_t), size)) {
+    return false;
+  }
+  rhs_offset_.resize(static_cast<size_t>(num_rules) + 1);
+  if (!file_.read(reinterpret_cast<char *>(rhs_offset_.data()),
+                  static_cast<std::streamsize>(rhs_offset_.size() * sizeof(uint32_t))) ||
+      rhs_offset_[0] != 0 || !std::is_sorted(rhs_offset_.begin(), rhs_offset_.end()) ||
+      !Fits(rhs_offsets + rhs_offset_.size() * sizeof(uint32_t), rhs_offset_.back(), sizeof(SymbolId), size)) {
+    return false;
+  }
+  rhs_.resize(rhs_offset_.back());
+  if (!file_.read(reinterpret_cast<char *>(rhs_.data()), static_cast<std::streamsize>(rhs_.size() * sizeof(SymbolId))) ||
+      std::any_of(rhs_.begin(), rhs_.end(), [&](SymbolId symbol) { return symbol >= names_.size(); })) {
+    return false;
+  }
+  actions_.resize(num_rules);
+  for (auto &action : actions_) {
+    if (!ReadString(file_, size, action)) {
+      return false;
+    }
+  }
+
+  // token offsets are read one pair at a time, the run of them has to be there
+  if (!Fits(tokens_offset_, 1, sizeof(uint32_t), size) || !file_.seekg(static_cast<std::streamoff>(tokens_offset_)) ||
+      !ReadPod(file_, num_tokens_) ||
+      !Fits(tokens_offset_ + sizeof(uint32_t), static_cast<uint64_t>(num_tokens_) + 1, sizeof(uint32_t), size)) {
+    return false;
+  }
+
+  if (!Fits(header.index_offset, header.num_chunks, sizeof(uint64_t), size) ||
+      !file_.seekg(static_cast<std::streamoff>(header.index_offset))) {
+    return false;
+  }
+  chunk_offset_.resize(header.num_chunks);
+  if (!file_.read(reinterpret_cast<char *>(chunk_offset_.data()),
+                  static_cast<std::streamsize>(chunk_offset_.size() * sizeof(uint64_t))) ||
+      std::any_of(chunk_offset_.begin(), chunk_offset_.end(), [&](uint64_t offset) { return offset >= size; })) {
+    return false;
+  }
+  size_ = size;
+  error_.clear();
+  return true;
+}
+
+std::string TraceFileReader::ReadToken(uint32_t pos) {
+  if (pos >= num_tokens_) {
+    return "";
+  }
+  uint64_t offsets = tokens_offset_ + sizeof(uint32_t);
+  uint32_t begin = 0;
+  uint32_t end = 0;
+  file_.seekg(static_cast<std::streamoff>(offsets + pos * sizeof(uint32_t)));
+  uint64_t bytes = offsets + (static_cast<uint64_t>(num_tokens_) + 1) * sizeof(uint32_t);
+  if (!ReadPod(file_, begin) || !ReadPod(file_, end) || begin > end || !Fits(bytes + begin, end - begin, 1, size_)) {
+    file_.clear();
+    return "";
+  }
+  std::string token(end - begin, '\0');
+  file_.seekg(static_cast<std::streamoff>(bytes + begin));
+  file_.read(token.data(), static_cast<std::streamsize>(token.size()));
+  return token;
+}
+
+std::vector<TraceEntry> TraceFileReader::Read(uint64_t from, uint64_t to) {
+  std::vector<TraceEntry> entries;
+  to = std::min(to, num_steps_);
+  if (from >= to) {
+    return entries;
+  }
+
+  GrammarView view{};
+  view.rhs = rhs_.data();
+  view.rhs_offset = rhs_offset_.data();
+
+  std::vector<SymbolId> stack;
+  std::vector<TraceEvent> events;
+  std::vector<char> buffer;
+  for (uint64_t chunk = from / interval_; chunk < chunk_offset_.size() && chunk * interval_ < to; chunk++) {
+    file_.clear();
+    file_.seekg(static_cast<std::streamoff>(chunk_offset_[chunk]));
+    uint32_t depth = 0;
+    uint32_t count = 0;
+    if (!ReadPod(file_, depth) || !Fits(chunk_offset_[chunk] + sizeof(uint32_t), depth, sizeof(SymbolId), size_)) {
+      error_ = "trace file error: truncated chunk";
+      break;
+    }
+    stack.resize(depth);
+    file_.read(reinterpret_cast<char *>(stack.data()), static_cast<std::streamsize>(depth * sizeof(SymbolId)));
+    uint64_t events_offset = chunk_offset_[chunk] + sizeof(uint32_t) + depth * sizeof(SymbolId) + sizeof(uint32_t);
+    if (!ReadPod(file_, count) || !Fits(events_offset, count, EVENT_SIZE, size_)) {
+      error_ = "trace file error: truncated chunk";
+      break;
+    }
+    buffer.resize(count * EVENT_SIZE);
+    file_.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (!file_) {
+      error_ = "trace file error: truncated chunk";
+      break;
+    }
+
+    events.resize(count);
+    const char *cursor = buffer.data();
+    for (auto &event : events) {
+      uint8_t action = 0;
+      std::memcpy(&action, cursor, sizeof(action));
+      cursor += sizeof(action);
+      std::memcpy(&event.stack_top, cursor, sizeof(event.stack_top));
+      cursor += sizeof(event.stack_top);
+      std::memcpy(&event.input_pos, cursor, sizeof(event.input_pos));
+      cursor += sizeof(event.input_pos);
+      std::memcpy(&event.rule, cursor, sizeof(event.rule));
+      cursor += sizeof(event.rule);
+      event.action = static_cast<TraceAction>(action);
+    }
+
+    auto bad_symbol = [&](SymbolId symbol) { return symbol >= names_.size(); };
+    if (std::any_of(stack.begin(), stack.end(), bad_symbol)) {
+      error_ = "trace file error: corrupt chunk";
+      break;
+    }
+    uint64_t step = chunk * interval_;
+    for (const auto &event : events) {
+      if (step >= to) {
+        break;
+      }
+      bool pops = event.action == TraceAction::MATCH || event.action == TraceAction::SYNCH ||
+                  event.action == TraceAction::EXPAND;
+      if (event.action > TraceAction::ACCEPT || bad_symbol(event.stack_top) || (pops && stack.empty()) ||
+          (event.action == TraceAction::EXPAND && (event.rule < 0 || static_cast<size_t>(event.rule) >= actions_.size()))) {
+        error_ = "trace file error: corrupt chunk";
+        return entries;
+      }
+      if (step >= from) {
+        TraceEntry entry;
+        entry.stack_top = names_[event.stack_top];
+        for (SymbolId symbol : stack) {
+          entry.full_stack.push_back(names_[symbol]);
+        }
+        entry.current_input = ReadToken(event.input_pos);
+        entry.action = event.action == TraceAction::EXPAND ? actions_[event.rule] : TraceActionName(event.action);
+        entries.push_back(std::move(entry));
+      }
+      ParseTrace::Apply(view, event, stack);
+      step++;
+    }
+  }
+  return entries;
+}
+
+}  // namespace jucc::parser
@@ -0,0 +1,216 @@
+#include "parser/tree_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "utils/output_buffer.h"
+
+namespace jucc::parser {
+
+namespace {
+
+template <typename T>
+void WritePod(utils::OutputBuffer &out, const T &value) {
+  out.Write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadPod(std::ifstream &in, T &value) {
+  return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+/**
+ * count elements of element_size bytes starting at offset fit in a file of
+ * size bytes.
+ */
+bool Fits(uint64_t offset, uint64_t count, uint64_t element_size, uint64_t size) {
+  return offset <= size && count <= (size - offset) / element_size;
+}
+
+struct Header {
+  char magic[4];
+  uint32_t version;
+  uint32_t num_nodes;
+  uint32_t root;
+  uint64_t names_offset;
+};
+
+constexpr size_t NODE_SIZE = sizeof(SymbolId) + sizeof(uint16_t) + 3 * sizeof(uint32_t);
+
+// nodes are checked this many records at a time
+constexpr size_t NODES_PER_READ = 4096;
+
+CstNode DecodeNode(const char *record) {
+  CstNode node{0, kNoNode, kNoNode, kNoNode};
+  std::memcpy(&node.symbol, record, sizeof(node.symbol));
+  std::memcpy(&node.first_child, record + 4, sizeof(node.first_child));
+  std::memcpy(&node.next_sibling, record + 8, sizeof(node.next_sibling));
+  std::memcpy(&node.token, record + 12, sizeof(node.token));
+  return node;
+}
+
+}  // namespace
+
+bool WriteTreeFile(const std::string &filepath, const ConcreteSyntaxTree &tree,
+                   const std::vector<std::string> &names) {
+  auto out = utils::OutputBuffer::Open(filepath);
+  if (out.Failed()) {
+    return false;
+  }
+  WriteTreeFile(out, tree, names);
+  return !out.Failed();
+}
+
+void WriteTreeFile(utils::OutputBuffer &out, const ConcreteSyntaxTree &tree, const std::vector<std::string> &names) {
+  const auto &nodes = tree.GetNodes();
+  Header header{};
+  std::memcpy(header.magic, TREE_FILE_MAGIC, sizeof(header.magic));
+  header.version = TREE_FILE_VERSION;
+  header.num_nodes = static_cast<uint32_t>(nodes.size());
+  header.root = tree.Root();
+  header.names_offset = sizeof(Header) + nodes.size() * NODE_SIZE;
+  WritePod(out, header);
+
+  for (const auto &node : nodes) {
+    WritePod(out, node.symbol);
+    WritePod(out, static_cast<uint16_t>(0));
+    WritePod(out, node.first_child);
+    WritePod(out, node.next_sibling);
+    WritePod(out, node.token);
+  }
+
+  WritePod(out, static_cast<uint32_t>(names.size()));
+  for (const auto &name : names) {
+    WritePod(out, static_cast<uint32_t>(name.size()));
+    out.Write(name);
+  }
+  out.Flush();
+}
+
+bool TreeFileReader::Open(const std::string &filepath) {
+  file_ = std::ifstream(filepath, std::ios::binary);
+  if (!file_.is_open()) {
+    error_ = "tree file error: file not found: " + filepath;
+    return false;
+  }
+  file_.seekg(0, std::ios::end);
+  auto size = static_cast<uint64_t>(file_.tellg());
+  file_.seekg(0);
+
+  Header header{};
+  if (!ReadPod(file_, header) || std::memcmp(header.magic, TREE_FILE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != TREE_FILE_VERSION) {
+    error_ = "tree file error: not a tree file or unsupported version";
+    return false;
+  }
+
+  // every count and offset is checked against the file size before anything is allocated for it
+  error_ = "tree file error: truncated or corrupt file";
+  uint32_t num_names = 0;
+  if (!Fits(sizeof(Header), header.num_nodes, NODE_SIZE, size) ||
+      header.names_offset < sizeof(Header) + static_cast<uint64_t>(header.num_nodes) * NODE_SIZE ||
+      !Fits(header.names_offset, 1, sizeof(uint32_t), size) ||
+      !file_.seekg(static_cast<std::streamoff>(header.names_offset)) || !ReadPod(file_, num_names) ||
+      !Fits(header.names_offset + sizeof(uint32_t), num_names, sizeof(uint32_t), size)) {
+    return false;
+  }
+  std::vector<std::string> names(num_names);
+  for (auto &name : names) {
+    uint32_t length = 0;
+    if (!ReadPod(file_, length)) {
+      return false;
+    }
+    auto pos = static_cast<uint64_t>(file_.tellg());
+    if (pos > size || length > size - pos) {
+      return false;
+    }
+    name.resize(length);
+    if (!file_.read(name.data(), length)) {
+      return false;
+    }
+  }
+
+  // Node and CollectSlice trust what they read: every symbol has a name,
+  // every link is a node, and the links form a forest, so no walk loops
+  uint32_t num_nodes = header.num_nodes;
+  if (header.root != kNoNode && header.root >= num_nodes) {
+    return false;
+  }
+  std::vector<std::pair<NodeId, NodeId>> links(num_nodes);
+  std::vector<char> linked(num_nodes, 0);
+  auto link = [&](NodeId to) {
+    if (to == kNoNode) {
+      return true;
+    }
+    if (to >= num_nodes || linked[to] != 0) {
+      return false;
+    }
+    linked[to] = 1;
+    return true;
+  };
+  std::vector<char> records(NODES_PER_READ * NODE_SIZE);
+  file_.seekg(sizeof(Header));
+  for (uint32_t first = 0; first < num_nodes; first += NODES_PER_READ) {
+    uint32_t count = std::min<uint32_t>(NODES_PER_READ, num_nodes - first);
+    if (!file_.read(records.data(), static_cast<std::streamsize>(count * NODE_SIZE))) {
+      return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+      CstNode node = DecodeNode(records.data() + i * NODE_SIZE);
+      if ((node.symbol >= names.size() && node.symbol != kEpsilonSymbol) || !link(node.first_child) ||
+          !link(node.next_sibling)) {
+        return false;
+      }
+      links[first + i] = {node.first_child, node.next_sibling};
+    }
+  }
+  if (header.root != kNoNode && linked[header.root] != 0) {
+    return false;
+  }
+  // with one link into every node at most, a cycle is whatever no unlinked node reaches
+  std::vector<NodeId> pending;
+  for (NodeId id = 0; id < num_nodes; id++) {
+    if (linked[id] == 0) {
+      pending.push_back(id);
+    }
+  }
+  uint32_t reached = 0;
+  while (!pending.empty()) {
+    NodeId id = pending.back();
+    pending.pop_back();
+    reached++;
+    for (NodeId next : {links[id].first, links[id].second}) {
+      if (next != kNoNode) {
+        pending.push_back(next);
+      }
+    }
+  }
+  if (reached != num_nodes) {
+    return false;
+  }
+
+  num_nodes_ = num_nodes;
+  root_ = header.root;
+  names_ = std::move(names);
+  error_.clear();
+  return true;
+}
+
+CstNode TreeFileReader::Node(NodeId id) {
+  CstNode node{0, kNoNode, kNoNode, kNoNode};
+  if (id >= num_nodes_) {
+    return node;
+  }
+
+  char record[NODE_SIZE];
+  file_.clear();
+  file_.seekg(static_cast<std::streamoff>(sizeof(Header) + static_cast<uint64_t>(id) * NODE_SIZE));
+  if (!file_.read(record, sizeof(record))) {
+    error_ = "tree file error: truncated node";
+    return node;
+  }
+  return DecodeNode(record);
+}
+
+}  // namespace jucc::parser
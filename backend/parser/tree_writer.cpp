@@ -0,0 +1,128 @@
+#include "parser/tree_writer.h"
+
+#include "utils/json_emitter.h"
+
+namespace jucc::parser {
+
+namespace {
+
+/**
+ * Opens a node object and writes its text. Further fields and the children
+ * array may follow before the object is closed.
+ */
+void BeginNode(utils::JsonEmitter &json, const std::string &name) {
+  json.BeginObject();
+  json.Key("text");
+  json.BeginObject();
+  json.Key("name");
+  json.String(name);
+  json.EndObject();
+}
+
+void OpenChildren(utils::JsonEmitter &json) {
+  json.Key("children");
+  json.BeginArray();
+}
+
+void CloseChildren(utils::JsonEmitter &json) {
+  json.EndArray();
+  json.EndObject();
+}
+
+}  // namespace
+
+void TreantWriter::Write(const ConcreteSyntaxTree &tree, const std::vector<std::string> &names,
+                         utils::OutputBuffer &out, const TreeWriterOptions &options) {
+  if (tree.Empty()) {
+    out.Write("{}\n");
+    return;
+  }
+  utils::JsonEmitter json(out, options.compact, options.indentation);
+
+  // one entry per node whose children are being written
+  std::vector<NodeId> frames;
+
+  const CstNode &root = tree.Node(tree.Root());
+  BeginNode(json, ConcreteSyntaxTree::SymbolName(names, root.symbol));
+  if (root.first_child != kNoNode) {
+    OpenChildren(json);
+    frames.push_back(root.first_child);
+  } else {
+    json.EndObject();
+  }
+
+  while (!frames.empty()) {
+    NodeId next = frames.back();
+    if (next == kNoNode) {
+      CloseChildren(json);
+      frames.pop_back();
+      continue;
+    }
+
+    const CstNode &child = tree.Node(next);
+    frames.back() = child.next_sibling;
+    BeginNode(json, ConcreteSyntaxTree::SymbolName(names, child.symbol));
+    if (child.first_child != kNoNode) {
+      OpenChildren(json);
+      frames.push_back(child.first_child);
+    } else {
+      json.EndObject();
+    }
+  }
+  json.Finish();
+}
+
+void TreantWriter::WriteSlice(const std::vector<SliceNode> &slice, const std::vector<std::string> &names,
+                              utils::OutputBuffer &out, const TreeWriterOptions &options) {
+  if (slice.empty()) {
+    out.Write("{}\n");
+    return;
+  }
+  utils::JsonEmitter json(out, options.compact, options.indentation);
+
+  // depths of the nodes whose children arrays are open
+  std::vector<uint32_t> open;
+  for (size_t i = 0; i < slice.size(); i++) {
+    const SliceNode &node = slice[i];
+    while (!open.empty() && open.back() >= node.depth) {
+      CloseChildren(json);
+      open.pop_back();
+    }
+
+    BeginNode(json, ConcreteSyntaxTree::SymbolName(names, node.symbol));
+    json.Key("id");
+    json.Int(node.id);
+    if (node.has_children) {
+      json.Key("has_children");
+      json.Bool(true);
+    } else if (node.token != kNoNode) {
+      json.Key("token");
+      json.Int(node.token);
+    }
+
+    if (i + 1 < slice.size() && slice[i + 1].depth > node.depth) {
+      OpenChildren(json);
+      open.push_back(node.depth);
+    } else {
+      json.EndObject();
+    }
+  }
+  while (!open.empty()) {
+    CloseChildren(json);
+    open.pop_back();
+  }
+  json.Finish();
+}
+
+bool TreantWriter::WriteFile(const ConcreteSyntaxTree &tree, const std::vector<std::string> &names,
+                             const std::string &filepath, const TreeWriterOptions &options) {
+  auto out = utils::OutputBuffer::Open(filepath);
+  if (out.Failed()) {
+    return false;
+  }
+  Write(tree, names, out, options);
+  out.Flush();
+  return !out.Failed();
+}
+
+}  // namespace jucc::parser
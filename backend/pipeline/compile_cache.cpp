@@ -0,0 +1,467 @@
+#include "pipeline/compile_cache.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <utility>
+
+#include "utils/json_emitter.h"
+#include "utils/json_reader.h"
+#include "utils/output_buffer.h"
+
+namespace jucc::pipeline {
+
+namespace {
+
+constexpr char ENTRY_FORMAT[] = "jucc-compile-cache";
+
+bool IsSpace(char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; }
+
+// 64 bit FNV-1a, seeded with the entry version so a format change moves every entry
+uint64_t HashText(std::string_view text) {
+  uint64_t hash = 14695981039346656037ULL ^ static_cast<uint64_t>(CompileCache::VERSION);
+  for (char c : text) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+template <typename Map>
+std::vector<std::string> SortedKeys(const Map &map) {
+  std::vector<std::string> keys;
+  keys.reserve(map.size());
+  for (const auto &entry : map) {
+    keys.push_back(entry.first);
+  }
+  std::sort(keys.begin(), keys.end());
+  return keys;
+}
+
+void WriteStringArray(utils::JsonEmitter &json, const std::vector<std::string> &values) {
+  json.BeginArray(true);
+  for (const auto &value : values) {
+    json.String(value);
+  }
+  json.EndArray();
+}
+
+void WriteSymbolsMap(utils::JsonEmitter &json, const utils::SymbolsMap &map) {
+  json.BeginObject();
+  for (const auto &key : SortedKeys(map)) {
+    json.Key(key);
+    WriteStringArray(json, map.at(key));
+  }
+  json.EndObject();
+}
+
+void WritePairs(utils::JsonEmitter &json, const std::vector<std::pair<std::string, std::string>> &pairs) {
+  json.BeginArray();
+  for (const auto &pair : pairs) {
+    json.BeginArray(true);
+    json.String(pair.first);
+    json.String(pair.second);
+    json.EndArray();
+  }
+  json.EndArray();
+}
+
+void WriteGrammarSize(utils::JsonEmitter &json, const utils::GrammarSize &size) {
+  json.BeginArray(true);
+  json.Int(static_cast<int64_t>(size.productions));
+  json.Int(static_cast<int64_t>(size.rules));
+  json.Int(static_cast<int64_t>(size.symbols));
+  json.EndArray();
+}
+
+void ReadStringArray(utils::JsonReader &reader, std::vector<std::string> &out) {
+  out.clear();
+  reader.BeginArray();
+  while (reader.NextElement()) {
+    out.emplace_back();
+    reader.ReadString(out.back());
+  }
+}
+
+void ReadPairs(utils::JsonReader &reader, std::vector<std::pair<std::string, std::string>> &out) {
+  out.clear();
+  reader.BeginArray();
+  while (reader.NextElement()) {
+    auto &pair = out.emplace_back();
+    reader.BeginArray();
+    reader.NextElement();
+    reader.ReadString(pair.first);
+    reader.NextElement();
+    reader.ReadString(pair.second);
+    if (reader.NextElement()) {
+      throw std::runtime_error("not a pair of names");
+    }
+  }
+}
+
+void ReadGrammarSize(utils::JsonReader &reader, utils::GrammarSize &size) {
+  size_t *fields[] = {&size.productions, &size.rules, &size.symbols};
+  reader.BeginArray();
+  for (size_t *field : fields) {
+    if (!reader.NextElement()) {
+      throw std::runtime_error("grammar size is too short");
+    }
+    *field = static_cast<size_t>(reader.ReadInt());
+  }
+  if (reader.NextElement()) {
+    throw std::runtime_error("grammar size is too long");
+  }
+}
+
+void WriteReduction(utils::JsonEmitter &json, const grammar::ReductionReport &report) {
+  json.BeginObject();
+  json.Key("unproductive");
+  WriteStringArray(json, report.unproductive);
+  json.Key("unreachable");
+  WriteStringArray(json, report.unreachable);
+  json.Key("units");
+  WritePairs(json, report.units);
+  json.Key("merged");
+  WritePairs(json, report.merged);
+  json.Key("before");
+  WriteGrammarSize(json, report.before);
+  json.Key("after");
+  WriteGrammarSize(json, report.after);
+  json.EndObject();
+}
+
+void ReadReduction(utils::JsonReader &reader, grammar::ReductionReport &report) {
+  std::string key;
+  reader.BeginObject();
+  while (reader.NextKey(key)) {
+    if (key == "unproductive") {
+      ReadStringArray(reader, report.unproductive);
+    } else if (key == "unreachable") {
+      ReadStringArray(reader, report.unreachable);
+    } else if (key == "units") {
+      ReadPairs(reader, report.units);
+    } else if (key == "merged") {
+      ReadPairs(reader, report.merged);
+    } else if (key == "before") {
+      ReadGrammarSize(reader, report.before);
+    } else if (key == "after") {
+      ReadGrammarSize(reader, report.after);
+    } else {
+      reader.Skip();
+    }
+  }
+}
+
+void WriteLeftRecursion(utils::JsonEmitter &json, const utils::LeftRecursionReport &report) {
+  json.BeginObject(true);
+  json.Key("before");
+  WriteGrammarSize(json, report.before);
+  json.Key("after");
+  WriteGrammarSize(json, report.after);
+  json.Key("components");
+  json.Int(static_cast<int64_t>(report.recursive_components));
+  json.Key("substitutions");
+  json.Int(static_cast<int64_t>(report.substitutions));
+  json.EndObject();
+}
+
+void ReadLeftRecursion(utils::JsonReader &reader, utils::LeftRecursionReport &report) {
+  std::string key;
+  reader.BeginObject();
+  while (reader.NextKey(key)) {
+    if (key == "before") {
+      ReadGrammarSize(reader, report.before);
+    } else if (key == "after") {
+      ReadGrammarSize(reader, report.after);
+    } else if (key == "components") {
+      report.recursive_components = static_cast<size_t>(reader.ReadInt());
+    } else if (key == "substitutions") {
+      report.substitutions = static_cast<size_t>(reader.ReadInt());
+    } else {
+      reader.Skip();
+    }
+  }
+}
+
+void ReadSymbolsMap(utils::JsonReader &reader, utils::SymbolsMap &map) {
+  std::string key;
+  reader.BeginObject();
+  while (reader.NextKey(key)) {
+    ReadStringArray(reader, map[key]);
+  }
+}
+
+void WriteEntry(utils::JsonEmitter &json, std::string_view normalized, const CompiledArtifacts &artifacts) {
+  json.BeginObject();
+  json.Key("format");
+  json.String(ENTRY_FORMAT);
+  json.Key("version");
+  json.Int(CompileCache::VERSION);
+  json.Key("source");
+  json.String(normalized);
+  json.Key("terminals");
+  WriteStringArray(json, artifacts.terminals);
+  json.Key("non_terminals");
+  WriteStringArray(json, artifacts.non_terminals);
+  json.Key("start_symbol");
+  json.String(artifacts.start_symbol);
+
+  json.Key("productions");
+  json.BeginArray();
+  for (const auto &production : artifacts.productions) {
+    json.BeginObject();
+    json.Key("parent");
+    json.String(production.GetParent());
+    json.Key("rules");
+    json.BeginArray();
+    for (const auto &rule : production.GetRules()) {
+      WriteStringArray(json, rule.GetEntities());
+    }
+    json.EndArray();
+    json.EndObject();
+  }
+  json.EndArray();
+  json.Key("helpers");
+  WriteStringArray(json, artifacts.generated.helpers);
+  json.Key("loops");
+  WriteStringArray(json, artifacts.generated.loops);
+  json.Key("reduction");
+  WriteReduction(json, artifacts.reduction);
+  json.Key("left_recursion");
+  WriteLeftRecursion(json, artifacts.left_recursion);
+
+  json.Key("firsts");
+  WriteSymbolsMap(json, artifacts.firsts);
+  json.Key("follows");
+  WriteSymbolsMap(json, artifacts.follows);
+
+  // every row has a cell for each column, only the non error cells are
+  // written as [production, rule]; rows and cells sorted by name
+  std::vector<std::string> columns;
+  if (!artifacts.table.empty()) {
+    columns = SortedKeys(artifacts.table.begin()->second);
+  }
+  json.Key("columns");
+  WriteStringArray(json, columns);
+  json.Key("table");
+  json.BeginObject();
+  for (const auto &non_terminal : SortedKeys(artifacts.table)) {
+    const auto &row = artifacts.table.at(non_terminal);
+    json.Key(non_terminal);
+    json.BeginObject(true);
+    for (const auto &terminal : SortedKeys(row)) {
+      const auto &cell = row.at(terminal);
+      if (cell.first == -1) {
+        continue;
+      }
+      json.Key(terminal);
+      json.BeginArray(true);
+      json.Int(cell.first);
+      json.Int(cell.second);
+      json.EndArray();
+    }
+    json.EndObject();
+  }
+  json.EndObject();
+
+  json.Key("conflicts");
+  WriteStringArray(json, artifacts.conflicts);
+  json.EndObject();
+  json.Finish();
+}
+
+}  // namespace
+
+std::string NormalizeGrammarText(std::string_view text) {
+  std::string normalized;
+  normalized.reserve(text.size());
+  size_t begin = 0;
+  while (begin < text.size()) {
+    size_t end = std::min(text.find('\n', begin), text.size());
+    std::string_view line = text.substr(begin, end - begin);
+    begin = end + 1;
+    // the same lines grammar::Parser::Parse skips
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+
+    bool first = true;
+    size_t pos = 0;
+    while (true) {
+      while (pos < line.size() && IsSpace(line[pos])) {
+        pos++;
+      }
+      size_t start = pos;
+      while (pos < line.size() && !IsSpace(line[pos])) {
+        pos++;
+      }
+      if (start == pos) {
+        break;
+      }
+      // an indented symbol starting with '#' is not a comment, keep it indented
+      if (!first || line[start] == '#') {
+        normalized += ' ';
+      }
+      normalized.append(line.substr(start, pos - start));
+      first = false;
+    }
+    if (!first) {
+      normalized += '\n';
+    }
+  }
+  return normalized;
+}
+
+std::string CompileCache::EntryPath(std::string_view normalized) const {
+  static const char digits[] = "0123456789abcdef";
+  uint64_t hash = HashText(normalized);
+  std::string name(16, '0');
+  for (size_t i = name.size(); i-- > 0; hash >>= 4) {
+    name[i] = digits[hash & 0xF];
+  }
+  return (std::filesystem::path(dir_) / (name + ".json")).string();
+}
+
+bool CompileCache::Load(std::string_view normalized, CompiledArtifacts &artifacts) const {
+  std::ifstream in(EntryPath(normalized), std::ios::binary);
+  if (!in.is_open()) {
+    return false;
+  }
+
+  CompiledArtifacts loaded;
+  std::string format;
+  int64_t version = 0;
+  std::string source;
+  try {
+    utils::JsonReader reader(in);
+    std::string key;
+    std::string name;
+    std::vector<std::string> columns;
+    reader.BeginObject();
+    while (reader.NextKey(key)) {
+      if (key == "format") {
+        reader.ReadString(format);
+      } else if (key == "version") {
+        version = reader.ReadInt();
+      } else if (key == "source") {
+        reader.ReadString(source);
+      } else if (key == "terminals") {
+        ReadStringArray(reader, loaded.terminals);
+      } else if (key == "non_terminals") {
+        ReadStringArray(reader, loaded.non_terminals);
+      } else if (key == "start_symbol") {
+        reader.ReadString(loaded.start_symbol);
+      } else if (key == "productions") {
+        reader.BeginArray();
+        while (reader.NextElement()) {
+          std::string parent;
+          grammar::Rules rules;
+          reader.BeginObject();
+          while (reader.NextKey(key)) {
+            if (key == "parent") {
+              reader.ReadString(parent);
+            } else if (key == "rules") {
+              reader.BeginArray();
+              while (reader.NextElement()) {
+                std::vector<std::string> entities;
+                ReadStringArray(reader, entities);
+                rules.emplace_back(std::move(entities));
+              }
+            } else {
+              reader.Skip();
+            }
+          }
+          loaded.productions.emplace_back(parent, std::move(rules));
+        }
+      } else if (key == "helpers") {
+        ReadStringArray(reader, loaded.generated.helpers);
+      } else if (key == "loops") {
+        ReadStringArray(reader, loaded.generated.loops);
+      } else if (key == "reduction") {
+        ReadReduction(reader, loaded.reduction);
+      } else if (key == "left_recursion") {
+        ReadLeftRecursion(reader, loaded.left_recursion);
+      } else if (key == "firsts") {
+        ReadSymbolsMap(reader, loaded.firsts);
+      } else if (key == "follows") {
+        ReadSymbolsMap(reader, loaded.follows);
+      } else if (key == "columns") {
+        ReadStringArray(reader, columns);
+      } else if (key == "table") {
+        // columns come first, see WriteEntry
+        reader.BeginObject();
+        while (reader.NextKey(name)) {
+          auto &row = loaded.table[name];
+          for (const auto &column : columns) {
+            row.emplace(column, std::make_pair(-1, -1));
+          }
+          reader.BeginObject();
+          while (reader.NextKey(key)) {
+            auto &cell = row[key];
+            reader.BeginArray();
+            reader.NextElement();
+            cell.first = static_cast<int>(reader.ReadInt());
+            reader.NextElement();
+            cell.second = static_cast<int>(reader.ReadInt());
+            if (reader.NextElement()) {
+              throw std::runtime_error("table cell is not a pair");
+            }
+          }
+        }
+      } else if (key == "conflicts") {
+        ReadStringArray(reader, loaded.conflicts);
+      } else {
+        reader.Skip();
+      }
+    }
+    reader.ExpectEnd();
+  } catch (const std::runtime_error &) {
+    // truncated or foreign file, compile again and overwrite it
+    return false;
+  }
+
+  if (format != ENTRY_FORMAT || version != VERSION || source != normalized) {
+    return false;
+  }
+  artifacts = std::move(loaded);
+  return true;
+}
+
+bool CompileCache::Store(std::string_view normalized, const CompiledArtifacts &artifacts) const {
+  std::error_code error;
+  std::filesystem::create_directories(dir_, error);
+  if (error) {
+    return false;
+  }
+
+  std::string path = EntryPath(normalized);
+  std::string temp = path + ".tmp" + std::to_string(std::random_device()());
+  {
+    auto out = utils::OutputBuffer::Open(temp);
+    if (out.Failed()) {
+      return false;
+    }
+    utils::JsonEmitter json(out, true);
+    WriteEntry(json, normalized, artifacts);
+    out.Flush();
+    if (out.Failed()) {
+      std::filesystem::remove(temp, error);
+      return false;
+    }
+  }
+
+  std::filesystem::rename(temp, path, error);
+  if (error) {
+    // renaming over an existing file fails on some platforms; another
+    // writer already stored the same entry then
+    std::filesystem::remove(temp, error);
+    return std::filesystem::exists(path, error);
+  }
+  return true;
+}
+
+}  // namespace jucc::pipeline
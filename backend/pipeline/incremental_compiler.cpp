@@ -0,0 +1,878 @@
+#include "pipeline/incremental_compiler.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include "grammar/grammar_transform.h"
+
+namespace jucc::pipeline {
+
+namespace {
+
+// as parser::ParsingTable::GenerateErrorMessage
+std::string ConflictMessage(const std::string &production, const std::string &symbol) {
+  return "parsing table error: duplicate entry in parsing table, production: " + production + " symbol: " + symbol;
+}
+
+template <typename T>
+bool AddTo(std::vector<T> &set, T value) {
+  auto it = std::lower_bound(set.begin(), set.end(), value);
+  if (it != set.end() && *it == value) {
+    return false;
+  }
+  set.insert(it, value);
+  return true;
+}
+
+template <typename T>
+bool MergeInto(std::vector<T> &set, const std::vector<T> &values) {
+  bool grew = false;
+  for (const T &value : values) {
+    grew = AddTo(set, value) || grew;
+  }
+  return grew;
+}
+
+}  // namespace
+
+IncrementalCompiler::Symbol IncrementalCompiler::Intern(const std::string &name) {
+  auto [it, inserted] = ids_.emplace(name, static_cast<Symbol>(names_.size()));
+  if (inserted) {
+    names_.push_back(name);
+    places_.emplace_back();
+    bodies_.emplace_back();
+    users_.emplace_back();
+    nullable_.push_back(0);
+    first_.emplace_back();
+    follow_.emplace_back();
+    declared_terminal_.push_back(0);
+    listed_.push_back(0);
+    synch_errors_.emplace_back();
+    cells_.emplace_back();
+  }
+  return it->second;
+}
+
+void IncrementalCompiler::Load(grammar::Parser &parser) {
+  // start over from an empty compiler
+  *this = IncrementalCompiler();
+
+  declared_non_terminals_ = parser.GetNonTerminals();
+  parsed_ = parser.GetGenerated();
+  // EBNF helpers are listed with the non terminals but not written in the text
+  declared_.insert(declared_non_terminals_.begin(), declared_non_terminals_.end());
+  for (const auto &helper : parsed_.helpers) {
+    declared_.erase(helper);
+  }
+  terminals_ = parser.GetTerminals();
+  declared_.insert(terminals_.begin(), terminals_.end());
+  declared_.emplace(grammar::EPSILON);
+  for (const auto &non_terminal : declared_non_terminals_) {
+    Intern(non_terminal);
+  }
+  // the end marker is not a declared terminal but needs a column
+  if (std::find(terminals_.begin(), terminals_.end(), utils::STRING_ENDMARKER) == terminals_.end()) {
+    terminals_.emplace_back(utils::STRING_ENDMARKER);
+  }
+  start_symbol_ = parser.GetStartSymbol();
+
+  epsilon_ = Intern(grammar::EPSILON);
+  for (const auto &terminal : terminals_) {
+    declared_terminal_[Intern(terminal)] = 1;
+  }
+  start_ = Intern(start_symbol_);
+
+  engine_ = std::make_unique<grammar::LeftRecursionEngine>(parser.GetProductions());
+  engine_->Run();
+  // one group per parent, so never more than the productions; the bound
+  // keeps -Walloc-size-larger-than from seeing an unbounded size
+  const size_t num_groups = std::min(engine_->NumGroups(), parser.GetProductions().size());
+  chains_.resize(num_groups);
+  offsets_.assign(num_groups + 1, 0);
+
+  std::vector<size_t> groups(num_groups);
+  std::iota(groups.begin(), groups.end(), 0);
+  Apply(groups);
+}
+
+bool IncrementalCompiler::Load(std::istream &grammar) {
+  grammar::Parser parser(grammar);
+  if (!parser.Parse()) {
+    error_ = "Failed to parse grammar: " + parser.GetError();
+    return false;
+  }
+  if (!parser.GetImports().empty()) {
+    error_ = "grammars with %import are not compiled incrementally";
+    return false;
+  }
+  Load(parser);
+  return true;
+}
+
+bool IncrementalCompiler::ReplaceRules(const std::string &parent, const grammar::Rules &rules) {
+  if (!engine_) {
+    error_ = "no grammar loaded";
+    return false;
+  }
+  for (const auto &rule : rules) {
+    for (const auto &entity : rule.GetEntities()) {
+      if (declared_.count(entity) == 0) {
+        error_ = "grammar parsing error: undefined symbol: " + entity;
+        return false;
+      }
+    }
+  }
+  std::vector<size_t> groups;
+  try {
+    groups = engine_->Replace(parent, rules);
+  } catch (const std::invalid_argument &e) {
+    error_ = e.what();
+    return false;
+  }
+  Apply(groups);
+  return true;
+}
+
+void IncrementalCompiler::SetBodies(Symbol parent, const grammar::Rules *rules) {
+  auto distinct = [](const std::vector<Body> &bodies) {
+    std::vector<Symbol> symbols;
+    for (const auto &body : bodies) {
+      symbols.insert(symbols.end(), body.begin(), body.end());
+    }
+    std::sort(symbols.begin(), symbols.end());
+    symbols.erase(std::unique(symbols.begin(), symbols.end()), symbols.end());
+    return symbols;
+  };
+
+  for (Symbol symbol : distinct(bodies_[parent])) {
+    auto &users = users_[symbol];
+    users.erase(std::find(users.begin(), users.end(), parent));
+  }
+  bodies_[parent].clear();
+  if (rules != nullptr) {
+    for (const auto &rule : *rules) {
+      Body body;
+      body.reserve(rule.GetEntities().size());
+      for (const auto &entity : rule.GetEntities()) {
+        body.push_back(Intern(entity));
+      }
+      bodies_[parent].push_back(std::move(body));
+    }
+  }
+  for (Symbol symbol : distinct(bodies_[parent])) {
+    users_[symbol].push_back(parent);
+  }
+}
+
+void IncrementalCompiler::Apply(const std::vector<size_t> &groups) {
+  last_edit_ = EditStats();
+  last_edit_.groups = groups.size();
+
+  // left recursion output first: new non terminals are named past all of it
+  std::vector<grammar::Productions> chains(groups.size());
+  for (size_t i = 0; i < groups.size(); i++) {
+    chains[i] = engine_->GetGroup(groups[i]);
+    for (Symbol symbol : chains_[groups[i]]) {
+      unfactored_.erase(names_[symbol]);
+    }
+    chains_[groups[i]].clear();
+    for (const auto &production : chains[i]) {
+      chains_[groups[i]].push_back(Intern(production.GetParent()));
+      unfactored_.insert(production.GetParent());
+    }
+  }
+  std::vector<grammar::Productions> blocks(groups.size());
+  for (size_t i = 0; i < groups.size(); i++) {
+    for (const auto &production : chains[i]) {
+      grammar::Productions factored = grammar::GrammarTransform::FactorProduction(production, unfactored_);
+      blocks[i].insert(blocks[i].end(), std::make_move_iterator(factored.begin()),
+                       std::make_move_iterator(factored.end()));
+    }
+  }
+
+  // parents of the old and new blocks, and which of them had a production
+  std::vector<Symbol> parents;
+  std::vector<std::vector<Symbol>> block_parents(groups.size());
+  bool resized = false;
+  for (size_t i = 0; i < groups.size(); i++) {
+    size_t group = groups[i];
+    parents.insert(parents.end(), parents_.begin() + offsets_[group], parents_.begin() + offsets_[group + 1]);
+    for (const auto &production : blocks[i]) {
+      block_parents[i].push_back(Intern(production.GetParent()));
+    }
+    parents.insert(parents.end(), block_parents[i].begin(), block_parents[i].end());
+    resized = resized || blocks[i].size() != offsets_[group + 1] - offsets_[group];
+  }
+  std::sort(parents.begin(), parents.end());
+  parents.erase(std::unique(parents.begin(), parents.end()), parents.end());
+  std::vector<char> had_production(parents.size());
+  for (size_t i = 0; i < parents.size(); i++) {
+    had_production[i] = IsNonTerminal(parents[i]) ? 1 : 0;
+  }
+
+  std::vector<char> edited(engine_->NumGroups(), 0);
+  for (size_t group : groups) {
+    edited[group] = 1;
+  }
+  for (Symbol parent : parents) {
+    auto &places = places_[parent];
+    places.erase(std::remove_if(places.begin(), places.end(), [&](Place place) { return edited[place.group] != 0; }),
+                 places.end());
+  }
+  for (size_t i = 0; i < groups.size(); i++) {
+    for (size_t index = 0; index < blocks[i].size(); index++) {
+      places_[block_parents[i][index]].push_back(
+          {static_cast<uint32_t>(groups[i]), static_cast<uint32_t>(index)});
+    }
+  }
+  for (Symbol parent : parents) {
+    std::sort(places_[parent].begin(), places_[parent].end(), [](Place a, Place b) {
+      return a.group != b.group ? a.group < b.group : a.index < b.index;
+    });
+  }
+
+  // splice the new blocks in, last first so the earlier offsets hold; when
+  // a block changed size the productions after it move, and so do the
+  // entries their rows hold
+  std::vector<size_t> old_offsets;
+  if (groups.size() == engine_->NumGroups()) {
+    // everything is new, every row gets built
+    productions_.clear();
+    parents_.clear();
+    for (size_t i = 0; i < groups.size(); i++) {
+      offsets_[i] = productions_.size();
+      productions_.insert(productions_.end(), std::make_move_iterator(blocks[i].begin()),
+                          std::make_move_iterator(blocks[i].end()));
+      parents_.insert(parents_.end(), block_parents[i].begin(), block_parents[i].end());
+    }
+    offsets_.back() = productions_.size();
+    rule_errors_.assign(productions_.size(), std::vector<std::string>());
+    resized = false;
+    blocks.clear();
+  } else if (resized) {
+    old_offsets = offsets_;
+  }
+  for (size_t i = blocks.size(); i-- > 0;) {
+    size_t begin = offsets_[groups[i]];
+    size_t end = offsets_[groups[i] + 1];
+    size_t kept = std::min(end - begin, blocks[i].size());
+    std::move(blocks[i].begin(), blocks[i].begin() + kept, productions_.begin() + begin);
+    std::copy(block_parents[i].begin(), block_parents[i].begin() + kept, parents_.begin() + begin);
+    if (kept < blocks[i].size()) {
+      productions_.insert(productions_.begin() + end, std::make_move_iterator(blocks[i].begin() + kept),
+                          std::make_move_iterator(blocks[i].end()));
+      parents_.insert(parents_.begin() + end, block_parents[i].begin() + kept, block_parents[i].end());
+      rule_errors_.insert(rule_errors_.begin() + end, blocks[i].size() - kept, std::vector<std::string>());
+    } else if (kept < end - begin) {
+      productions_.erase(productions_.begin() + begin + kept, productions_.begin() + end);
+      parents_.erase(parents_.begin() + begin + kept, parents_.begin() + end);
+      rule_errors_.erase(rule_errors_.begin() + begin + kept, rule_errors_.begin() + end);
+    }
+  }
+  if (resized) {
+    size_t next = 0;
+    for (size_t group = 0; group < engine_->NumGroups(); group++) {
+      size_t size = old_offsets[group + 1] - old_offsets[group];
+      if (next < groups.size() && groups[next] == group) {
+        size = blocks[next++].size();
+      }
+      offsets_[group + 1] = offsets_[group] + size;
+    }
+
+    // every row holding a production that moved is renumbered once, its
+    // cells in the edited groups are rebuilt anyway
+    std::vector<Symbol> moved;
+    std::vector<char> seen(names_.size(), 0);
+    for (size_t group = groups.front() + 1; group < engine_->NumGroups(); group++) {
+      if (edited[group] != 0 || offsets_[group] == old_offsets[group]) {
+        continue;
+      }
+      for (size_t p = offsets_[group]; p < offsets_[group + 1]; p++) {
+        if (seen[parents_[p]] == 0) {
+          seen[parents_[p]] = 1;
+          moved.push_back(parents_[p]);
+        }
+      }
+    }
+    for (Symbol parent : moved) {
+      if (places_[parent].size() == 1) {
+        // every entry is that one production
+        auto production = static_cast<int>(ProductionIndex(places_[parent].front()));
+        for (auto *cell : cells_[parent]) {
+          cell->first = production;
+        }
+        continue;
+      }
+      for (auto *cell : cells_[parent]) {
+        auto group = static_cast<size_t>(
+            std::upper_bound(old_offsets.begin(), old_offsets.end(), static_cast<size_t>(cell->first)) -
+            old_offsets.begin() - 1);
+        if (edited[group] == 0) {
+          cell->first = static_cast<int>(offsets_[group] + (cell->first - old_offsets[group]));
+        }
+      }
+    }
+    last_edit_.renumbered = moved.size();
+  }
+
+  // rules as the analyses see them
+  std::vector<Symbol> changed;
+  std::vector<Symbol> flipped;  // became or stopped being a non terminal
+  std::vector<Symbol> follow_seeds;
+  auto note_symbols = [&](const std::vector<Body> &bodies) {
+    for (const auto &body : bodies) {
+      for (Symbol symbol : body) {
+        if (IsNonTerminal(symbol)) {
+          follow_seeds.push_back(symbol);
+        }
+      }
+    }
+  };
+  for (size_t i = 0; i < parents.size(); i++) {
+    Symbol parent = parents[i];
+    std::vector<Body> old_bodies = bodies_[parent];
+    bool has_production = IsNonTerminal(parent);
+    SetBodies(parent,
+              has_production ? &productions_[ProductionIndex(places_[parent].front())].GetRules() : nullptr);
+    if (has_production != (had_production[i] != 0)) {
+      flipped.push_back(parent);
+    } else if (old_bodies == bodies_[parent]) {
+      continue;
+    }
+    changed.push_back(parent);
+    note_symbols(old_bodies);
+    note_symbols(bodies_[parent]);
+  }
+  last_edit_.productions = changed.size();
+  if (!flipped.empty() || groups.size() == engine_->NumGroups()) {
+    ListNonTerminals();
+  }
+
+  auto with = [&](std::vector<Symbol> symbols, const std::vector<Symbol> &more) {
+    symbols.insert(symbols.end(), more.begin(), more.end());
+    return symbols;
+  };
+
+  // nullability
+  std::unordered_map<Symbol, char> old_nullable;
+  std::vector<Symbol> nullable_changed = with(
+      Resolve(
+          changed, [&](Symbol symbol, std::vector<Symbol> &out) { NullableUsers(symbol, out); },
+          [&](Symbol symbol) {
+            old_nullable.emplace(symbol, nullable_[symbol]);
+            nullable_[symbol] = 0;
+          },
+          [&](Symbol symbol) { return GrowNullable(symbol); },
+          [&](Symbol symbol) { return old_nullable[symbol] != nullable_[symbol]; }, last_edit_.nullable),
+      flipped);
+
+  // FIRST; a change in nullability moves where the prefixes of the rules
+  // using the symbol end
+  std::vector<Symbol> first_seeds = changed;
+  for (Symbol symbol : nullable_changed) {
+    PrefixUsers(symbol, first_seeds);
+  }
+  std::unordered_map<Symbol, Set> old_first;
+  std::vector<Symbol> first_changed = with(
+      Resolve(
+          first_seeds,
+          [&](Symbol symbol, std::vector<Symbol> &out) { PrefixUsers(symbol, out); },
+          [&](Symbol symbol) {
+            old_first.emplace(symbol, std::move(first_[symbol]));
+            first_[symbol].clear();
+          },
+          [&](Symbol symbol) { return GrowFirst(symbol); },
+          [&](Symbol symbol) { return old_first[symbol] != first_[symbol]; }, last_edit_.first),
+      nullable_changed);
+
+  // FOLLOW: every non terminal whose occurrences changed, or precede a
+  // symbol whose FIRST or nullability did
+  follow_seeds.insert(follow_seeds.end(), changed.begin(), changed.end());
+  for (Symbol symbol : first_changed) {
+    for (Symbol user : users_[symbol]) {
+      for (const auto &body : bodies_[user]) {
+        auto last = std::find(body.rbegin(), body.rend(), symbol);
+        for (auto it = last == body.rend() ? body.rend() : std::next(last); it != body.rend(); ++it) {
+          if (IsNonTerminal(*it)) {
+            follow_seeds.push_back(*it);
+          }
+        }
+      }
+    }
+  }
+  std::sort(follow_seeds.begin(), follow_seeds.end());
+  follow_seeds.erase(std::unique(follow_seeds.begin(), follow_seeds.end()), follow_seeds.end());
+  std::unordered_map<Symbol, Set> old_follow;
+  std::vector<Symbol> follow_changed = Resolve(
+      follow_seeds, [&](Symbol symbol, std::vector<Symbol> &out) { TailSymbols(symbol, out); },
+      [&](Symbol symbol) {
+        old_follow.emplace(symbol, std::move(follow_[symbol]));
+        follow_[symbol].clear();
+      },
+      [&](Symbol symbol) { return GrowFollow(symbol); },
+      [&](Symbol symbol) { return old_follow[symbol] != follow_[symbol]; }, last_edit_.follow);
+
+  // table rows
+  std::vector<Symbol> rows = with(with(parents, changed), follow_changed);
+  for (Symbol symbol : first_changed) {
+    PrefixUsers(symbol, rows);
+  }
+  std::sort(rows.begin(), rows.end());
+  rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+  for (Symbol row : rows) {
+    BuildRow(row);
+  }
+  last_edit_.rows = rows.size();
+}
+
+void IncrementalCompiler::ListNonTerminals() {
+  // as grammar::Parser lists them: declared ones, then the new parents
+  // left recursion elimination made, then those left factoring made
+  std::vector<char> now(names_.size(), 0);
+  std::vector<Symbol> listed;
+  auto list = [&](Symbol symbol) {
+    if (now[symbol] == 0) {
+      now[symbol] = 1;
+      listed.push_back(symbol);
+    }
+  };
+  for (const auto &name : declared_non_terminals_) {
+    list(ids_.at(name));
+  }
+  for (const auto &chain : chains_) {
+    for (Symbol symbol : chain) {
+      list(symbol);
+    }
+  }
+  for (Symbol parent : parents_) {
+    list(parent);
+  }
+
+  std::vector<Symbol> flips;
+  for (Symbol symbol = 0; symbol < names_.size(); symbol++) {
+    if (now[symbol] != listed_[symbol]) {
+      flips.push_back(symbol);
+    }
+  }
+  listed_ = std::move(now);
+  // mostly the same list, only the names that moved are copied
+  non_terminals_.resize(listed.size());
+  for (size_t i = 0; i < listed.size(); i++) {
+    if (non_terminals_[i] != names_[listed[i]]) {
+      non_terminals_[i] = names_[listed[i]];
+    }
+  }
+  // a listed symbol without production only has a row of errors
+  for (Symbol symbol : flips) {
+    if (!IsNonTerminal(symbol)) {
+      BuildRow(symbol);
+    }
+  }
+}
+
+std::vector<IncrementalCompiler::Symbol> IncrementalCompiler::Resolve(
+    const std::vector<Symbol> &seeds, const std::function<void(Symbol, std::vector<Symbol> &)> &dependents,
+    const std::function<void(Symbol)> &reset, const std::function<bool(Symbol)> &grow,
+    const std::function<bool(Symbol)> &changed, size_t &recomputed) {
+  // the part of the dependency graph reachable from the seeds, numbered locally
+  std::unordered_map<Symbol, uint32_t> local;
+  std::vector<Symbol> nodes;
+  std::vector<std::vector<uint32_t>> edges;
+  auto visit = [&](Symbol symbol) {
+    auto [it, inserted] = local.emplace(symbol, static_cast<uint32_t>(nodes.size()));
+    if (inserted) {
+      nodes.push_back(symbol);
+    }
+    return it->second;
+  };
+  for (Symbol seed : seeds) {
+    visit(seed);
+  }
+  std::vector<Symbol> scratch;
+  for (size_t i = 0; i < nodes.size(); i++) {
+    scratch.clear();
+    dependents(nodes[i], scratch);
+    std::vector<uint32_t> out;
+    out.reserve(scratch.size());
+    for (Symbol symbol : scratch) {
+      out.push_back(visit(symbol));
+    }
+    edges.push_back(std::move(out));
+  }
+
+  // iterative Tarjan; a component comes out after every component that
+  // depends on it, so the list is walked backwards
+  const auto unvisited = static_cast<uint32_t>(nodes.size());
+  std::vector<uint32_t> order(nodes.size(), unvisited);
+  std::vector<uint32_t> low(nodes.size(), 0);
+  std::vector<char> on_stack(nodes.size(), 0);
+  std::vector<uint32_t> stack;
+  std::vector<std::pair<uint32_t, size_t>> frames;  // node, next edge
+  std::vector<std::vector<uint32_t>> components;
+  uint32_t counter = 0;
+  for (uint32_t root = 0; root < nodes.size(); root++) {
+    if (order[root] != unvisited) {
+      continue;
+    }
+    frames.emplace_back(root, 0);
+    while (!frames.empty()) {
+      auto &[node, next] = frames.back();
+      if (next == 0 && order[node] == unvisited) {
+        order[node] = low[node] = counter++;
+        stack.push_back(node);
+        on_stack[node] = 1;
+      }
+      if (next < edges[node].size()) {
+        uint32_t to = edges[node][next++];
+        if (order[to] == unvisited) {
+          frames.emplace_back(to, 0);
+        } else if (on_stack[to] != 0) {
+          low[node] = std::min(low[node], order[to]);
+        }
+        continue;
+      }
+
+      uint32_t done = node;
+      frames.pop_back();
+      if (!frames.empty()) {
+        uint32_t parent = frames.back().first;
+        low[parent] = std::min(low[parent], low[done]);
+      }
+      if (low[done] != order[done]) {
+        continue;
+      }
+      std::vector<uint32_t> component;
+      uint32_t member;
+      do {
+        member = stack.back();
+        stack.pop_back();
+        on_stack[member] = 0;
+        component.push_back(member);
+      } while (member != done);
+      components.push_back(std::move(component));
+    }
+  }
+
+  std::vector<char> dirty(nodes.size(), 0);
+  for (Symbol seed : seeds) {
+    dirty[local[seed]] = 1;
+  }
+  std::vector<Symbol> result;
+  for (auto component = components.rbegin(); component != components.rend(); ++component) {
+    if (std::none_of(component->begin(), component->end(), [&](uint32_t node) { return dirty[node] != 0; })) {
+      continue;
+    }
+    for (uint32_t node : *component) {
+      reset(nodes[node]);
+    }
+    // a single member that does not read itself is done in one pass
+    uint32_t first = component->front();
+    bool cyclic = component->size() > 1 ||
+                  std::find(edges[first].begin(), edges[first].end(), first) != edges[first].end();
+    bool grew = true;
+    while (grew) {
+      grew = false;
+      for (uint32_t node : *component) {
+        grew = grow(nodes[node]) || grew;
+      }
+      grew = grew && cyclic;
+    }
+    recomputed += component->size();
+    for (uint32_t node : *component) {
+      if (changed(nodes[node])) {
+        result.push_back(nodes[node]);
+        for (uint32_t to : edges[node]) {
+          dirty[to] = 1;
+        }
+      }
+    }
+  }
+  return result;
+}
+
+bool IncrementalCompiler::InPrefix(Symbol parent, Symbol symbol) const {
+  for (const auto &body : bodies_[parent]) {
+    for (Symbol entity : body) {
+      if (entity == symbol) {
+        return true;
+      }
+      if (entity == epsilon_) {
+        continue;
+      }
+      if (!IsNonTerminal(entity) || nullable_[entity] == 0) {
+        break;
+      }
+    }
+  }
+  return false;
+}
+
+void IncrementalCompiler::NullableUsers(Symbol symbol, std::vector<Symbol> &users) const {
+  // only a rule of nothing but non terminals can become nullable
+  for (Symbol user : users_[symbol]) {
+    for (const auto &body : bodies_[user]) {
+      if (std::find(body.begin(), body.end(), symbol) != body.end() &&
+          std::all_of(body.begin(), body.end(),
+                      [&](Symbol entity) { return entity == epsilon_ || IsNonTerminal(entity); })) {
+        users.push_back(user);
+        break;
+      }
+    }
+  }
+}
+
+void IncrementalCompiler::PrefixUsers(Symbol symbol, std::vector<Symbol> &users) const {
+  for (Symbol user : users_[symbol]) {
+    if (InPrefix(user, symbol)) {
+      users.push_back(user);
+    }
+  }
+}
+
+void IncrementalCompiler::TailSymbols(Symbol parent, std::vector<Symbol> &tails) const {
+  // the non terminals followed by a nullable suffix read FOLLOW(parent)
+  for (const auto &body : bodies_[parent]) {
+    for (auto it = body.rbegin(); it != body.rend(); ++it) {
+      if (*it == epsilon_) {
+        continue;
+      }
+      if (!IsNonTerminal(*it)) {
+        break;
+      }
+      tails.push_back(*it);
+      if (nullable_[*it] == 0) {
+        break;
+      }
+    }
+  }
+}
+
+bool IncrementalCompiler::GrowNullable(Symbol parent) {
+  if (!IsNonTerminal(parent) || nullable_[parent] != 0) {
+    return false;
+  }
+  for (const auto &body : bodies_[parent]) {
+    if (std::all_of(body.begin(), body.end(), [&](Symbol entity) {
+          return entity == epsilon_ || (IsNonTerminal(entity) && nullable_[entity] != 0);
+        })) {
+      nullable_[parent] = 1;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool IncrementalCompiler::GrowFirst(Symbol parent) {
+  if (!IsNonTerminal(parent)) {
+    return false;
+  }
+  bool grew = false;
+  Set &first = first_[parent];
+  for (const auto &body : bodies_[parent]) {
+    for (Symbol entity : body) {
+      if (entity == epsilon_) {
+        continue;
+      }
+      if (!IsNonTerminal(entity)) {
+        grew = AddTo(first, entity) || grew;
+        break;
+      }
+      if (entity != parent) {
+        grew = MergeInto(first, first_[entity]) || grew;
+      }
+      if (nullable_[entity] == 0) {
+        break;
+      }
+    }
+  }
+  return grew;
+}
+
+bool IncrementalCompiler::GrowFollow(Symbol symbol) {
+  if (!IsNonTerminal(symbol)) {
+    return false;
+  }
+  bool grew = false;
+  Set &follow = follow_[symbol];
+  if (symbol == start_) {
+    grew = AddTo(follow, ids_.at(utils::STRING_ENDMARKER)) || grew;
+  }
+  for (Symbol user : users_[symbol]) {
+    for (const auto &body : bodies_[user]) {
+      for (size_t i = 0; i < body.size(); i++) {
+        if (body[i] != symbol) {
+          continue;
+        }
+        size_t next = i + 1;
+        for (; next < body.size(); next++) {
+          Symbol entity = body[next];
+          if (entity == epsilon_) {
+            continue;
+          }
+          if (!IsNonTerminal(entity)) {
+            grew = AddTo(follow, entity) || grew;
+            break;
+          }
+          grew = MergeInto(follow, first_[entity]) || grew;
+          if (nullable_[entity] == 0) {
+            break;
+          }
+        }
+        if (next == body.size() && user != symbol) {
+          grew = MergeInto(follow, follow_[user]) || grew;
+        }
+      }
+    }
+  }
+  return grew;
+}
+
+void IncrementalCompiler::BuildRow(Symbol parent) {
+  // the cells parser::ParsingTable::BuildTable writes into this row, in
+  // the order it writes them
+  const std::string &name = names_[parent];
+  cells_[parent].clear();
+  synch_errors_[parent].clear();
+  for (Place place : places_[parent]) {
+    rule_errors_[ProductionIndex(place)].clear();
+  }
+  if (listed_[parent] == 0 && !IsNonTerminal(parent)) {
+    table_.erase(name);
+    return;
+  }
+
+  auto &row = table_[name];
+  if (listed_[parent] != 0 && row.size() == terminals_.size()) {
+    // the same columns, reset in place
+    for (auto &cell : row) {
+      cell.second = std::make_pair(-1, -1);
+    }
+  } else {
+    row.clear();
+    if (listed_[parent] != 0) {
+      for (const auto &terminal : terminals_) {
+        row[terminal] = std::make_pair(-1, -1);
+      }
+    }
+  }
+  if (listed_[parent] != 0) {
+    if (IsNonTerminal(parent) && declared_terminal_[parent] == 0) {
+      for (Symbol symbol : follow_[parent]) {
+        auto &cell = row[names_[symbol]];
+        if (cell.first != -1) {
+          synch_errors_[parent].push_back(ConflictMessage(name, names_[symbol]));
+        }
+        cell = std::make_pair(-2, -2);
+      }
+    }
+  }
+
+  for (Place place : places_[parent]) {
+    auto production = static_cast<int>(ProductionIndex(place));
+    const auto &rules = productions_[production].GetRules();
+    for (size_t rule = 0; rule < rules.size(); rule++) {
+      auto add_entry = [&](Symbol symbol) {
+        auto &cell = row[names_[symbol]];
+        if (cell.first != -1 && cell.first != -2) {
+          rule_errors_[production].push_back(ConflictMessage(name, names_[symbol]));
+        }
+        cell = std::make_pair(production, static_cast<int>(rule));
+      };
+
+      bool nullable = true;
+      for (const auto &entity : rules[rule].GetEntities()) {
+        Symbol symbol = ids_.at(entity);
+        if (symbol == epsilon_) {
+          continue;
+        }
+        if (declared_terminal_[symbol] != 0) {
+          add_entry(symbol);
+          nullable = false;
+          break;
+        }
+        if (!IsNonTerminal(symbol)) {
+          // undefined symbol, nothing can be derived past it
+          nullable = false;
+          break;
+        }
+        for (Symbol first : first_[symbol]) {
+          add_entry(first);
+        }
+        if (nullable_[symbol] == 0) {
+          nullable = false;
+          break;
+        }
+      }
+      if (nullable) {
+        for (Symbol follow : follow_[parent]) {
+          add_entry(follow);
+        }
+      }
+    }
+  }
+  for (auto &cell : row) {
+    if (cell.second.first >= 0) {
+      cells_[parent].push_back(&cell.second);
+    }
+  }
+}
+
+std::vector<std::string> IncrementalCompiler::GetConflicts() const {
+  std::vector<std::string> conflicts;
+  for (const auto &name : non_terminals_) {
+    const auto &errors = synch_errors_[ids_.at(name)];
+    conflicts.insert(conflicts.end(), errors.begin(), errors.end());
+  }
+  for (const auto &errors : rule_errors_) {
+    conflicts.insert(conflicts.end(), errors.begin(), errors.end());
+  }
+  return conflicts;
+}
+
+grammar::GeneratedSymbols IncrementalCompiler::GetGenerated() const {
+  // EBNF symbols first, then every listed non terminal that was not
+  // declared, in listing order: the parents the transforms made
+  grammar::GeneratedSymbols generated = parsed_;
+  std::unordered_set<std::string> declared(declared_non_terminals_.begin(), declared_non_terminals_.end());
+  for (const auto &name : non_terminals_) {
+    if (declared.count(name) == 0) {
+      generated.helpers.push_back(name);
+    }
+  }
+  return generated;
+}
+
+utils::SymbolsMap IncrementalCompiler::GetFirsts() const {
+  utils::SymbolsMap firsts;
+  for (Symbol parent : parents_) {
+    auto [it, inserted] = firsts.emplace(names_[parent], std::vector<std::string>());
+    if (!inserted) {
+      continue;
+    }
+    for (Symbol symbol : first_[parent]) {
+      it->second.push_back(names_[symbol]);
+    }
+    if (nullable_[parent] != 0) {
+      it->second.emplace_back(grammar::EPSILON);
+    }
+  }
+  return firsts;
+}
+
+utils::SymbolsMap IncrementalCompiler::GetFollows() const {
+  utils::SymbolsMap follows;
+  for (Symbol parent : parents_) {
+    auto [it, inserted] = follows.emplace(names_[parent], std::vector<std::string>());
+    if (!inserted) {
+      continue;
+    }
+    for (Symbol symbol : follow_[parent]) {
+      it->second.push_back(names_[symbol]);
+    }
+  }
+  return follows;
+}
+
+}  // namespace jucc::pipeline
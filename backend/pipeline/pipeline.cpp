@@ -0,0 +1,344 @@
+#include "pipeline/pipeline.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unordered_set>
+
+#include "parser/compiled_grammar.h"
+#include "parser/grammar_file.h"
+#include "pipeline/compile_cache.h"
+#include "utils/output_buffer.h"
+
+namespace jucc::pipeline {
+
+unsigned OutputFromName(const std::string &name) {
+  static const std::pair<const char *, unsigned> names[] = {
+      {"grammar", OUTPUT_GRAMMAR}, {"first-follow", OUTPUT_FIRST_FOLLOW}, {"table", OUTPUT_TABLE},
+      {"jgb", OUTPUT_GRAMMAR_FILE}, {"tokens", OUTPUT_TOKENS},            {"trace", OUTPUT_TRACE},
+      {"tree", OUTPUT_TREE},       {"tree-file", OUTPUT_TREE_FILE},       {"trace-file", OUTPUT_TRACE_FILE},
+      {"all", OUTPUT_ALL},
+  };
+  for (const auto &entry : names) {
+    if (name == entry.first) {
+      return entry.second;
+    }
+  }
+  return OUTPUT_NONE;
+}
+
+std::vector<std::string> TokenTerminals(const std::vector<lexer::TokenInfo> &tokens) {
+  std::vector<std::string> terminals;
+  terminals.reserve(tokens.size());
+  for (const auto &token : tokens) {
+    std::string type = token.type.substr(0, token.type.find(' '));
+    terminals.push_back(type == "identifier" ? "id" : type);
+  }
+  return terminals;
+}
+
+namespace {
+
+/**
+ * Appends the normalized text of every module source imports, directly or
+ * not, so that editing a module misses the cache entries of its importers.
+ * Modules that can not be read are left for the parser to report.
+ */
+void AppendImports(const std::string &source, const std::string &base_dir, std::string &modules,
+                   std::unordered_set<std::string> &seen) {
+  std::istringstream lines(source);
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (line.rfind("%import ", 0) != 0) {
+      continue;
+    }
+    std::string path = grammar::ResolveImport(base_dir, line.substr(8));
+    std::ifstream file(path);
+    if (!seen.insert(path).second || !file.is_open()) {
+      continue;
+    }
+    std::ostringstream text;
+    text << file.rdbuf();
+    std::string normalized = NormalizeGrammarText(text.str());
+    modules += "%module " + path + "\n" + normalized;
+    AppendImports(normalized, std::filesystem::path(path).parent_path().string(), modules, seen);
+  }
+}
+
+}  // namespace
+
+std::string ImportedModulesText(const std::string &grammar_text, const std::string &base_dir) {
+  std::string modules;
+  std::unordered_set<std::string> seen;
+  AppendImports(NormalizeGrammarText(grammar_text), base_dir, modules, seen);
+  return modules;
+}
+
+std::string Pipeline::OutputPath(const char *name) const {
+  if (options_.output_dir.empty() || options_.output_dir == ".") {
+    return name;
+  }
+  char last = options_.output_dir.back();
+  return options_.output_dir + (last == '/' || last == '\\' ? "" : "/") + name;
+}
+
+bool Pipeline::Fail(const std::string &what) {
+  error_ = what;
+  return false;
+}
+
+bool Pipeline::LoadGrammar(const std::string &grammar_path) {
+  std::ifstream file(grammar_path);
+  if (!file.is_open()) {
+    return Fail("Failed to parse grammar: grammar parsing error: file not found");
+  }
+  return LoadGrammar(file, std::filesystem::path(grammar_path).parent_path().string());
+}
+
+bool Pipeline::LoadGrammar(std::istream &grammar, const std::string &base_dir) {
+  // in one block, not a character at a time
+  std::ostringstream text;
+  text << grammar.rdbuf();
+  source_ = NormalizeGrammarText(text.str());
+  modules_.clear();
+  std::unordered_set<std::string> seen;
+  AppendImports(source_, base_dir, modules_, seen);
+  imports_.clear();
+  cached_ = false;
+  reduction_ = grammar::ReductionReport();
+  left_recursion_ = utils::LeftRecursionReport();
+
+  CompiledArtifacts artifacts;
+  if (!options_.cache_dir.empty() && CompileCache(options_.cache_dir).Load(CacheKey(), artifacts)) {
+    cached_ = true;
+    terminals_ = std::move(artifacts.terminals);
+    non_terminals_ = std::move(artifacts.non_terminals);
+    start_symbol_ = std::move(artifacts.start_symbol);
+    productions_ = std::move(artifacts.productions);
+    generated_ = std::move(artifacts.generated);
+    reduction_ = std::move(artifacts.reduction);
+    left_recursion_ = artifacts.left_recursion;
+    firsts_ = std::move(artifacts.firsts);
+    follows_ = std::move(artifacts.follows);
+    cached_table_ = std::move(artifacts.table);
+    cached_conflicts_ = std::move(artifacts.conflicts);
+    WriteGrammarOutput();
+    return true;
+  }
+
+  // the normalized text parses the same as the original, and is what the
+  // cache entry will be keyed by
+  std::istringstream normalized(source_);
+  grammar::Parser parser(normalized, base_dir);
+  parser.SetLog(options_.log);
+  if (!parser.Parse()) {
+    return Fail("Failed to parse grammar: " + parser.GetError());
+  }
+  if (options_.reductions != grammar::REDUCE_NONE && !parser.Reduce(options_.reductions, &reduction_)) {
+    return Fail("Failed to reduce grammar: " + parser.GetError());
+  }
+  if (options_.remove_ambiguity) {
+    if (!parser.RemoveAllPossibleAmbiguity(options_.pool, &left_recursion_)) {
+      return Fail("Failed to remove ambiguity: " + parser.GetError());
+    }
+  } else {
+    if (!parser.EliminateLeftRecursion()) {
+      return Fail("Failed to eliminate left recursion: " + parser.GetError());
+    }
+    if (!parser.ApplyLeftFactoring(options_.pool)) {
+      return Fail("Failed to apply left factoring: " + parser.GetError());
+    }
+  }
+
+  terminals_ = parser.GetTerminals();
+  non_terminals_ = parser.GetNonTerminals();
+  start_symbol_ = parser.GetStartSymbol();
+  productions_ = parser.GetProductions();
+  generated_ = parser.GetGenerated();
+  imports_ = parser.GetImports();
+  own_productions_ = productions_.size();
+  for (const auto &module : imports_) {
+    own_productions_ -= module->productions.size();
+  }
+  WriteGrammarOutput();
+  return true;
+}
+
+void Pipeline::WriteGrammarOutput() {
+  if (Wants(OUTPUT_GRAMMAR)) {
+    grammar::DumpGrammarAsJson(terminals_, non_terminals_, start_symbol_, productions_, generated_,
+                               OutputPath("grammar.json"), options_.compact_json);
+  }
+}
+
+grammar::Productions Pipeline::EmptiedProductions() const {
+  grammar::Productions emptied = productions_;
+  for (auto &prod : emptied) {
+    grammar::Rules rules = prod.GetRules();
+    for (auto &rule : rules) {
+      const auto &entities = rule.GetEntities();
+      if (entities.size() == 1 && entities[0] == std::string(grammar::EPSILON)) {
+        rule.SetEntities({});
+      }
+    }
+    prod.SetRules(rules);
+  }
+  return emptied;
+}
+
+std::string Pipeline::CacheKey() const {
+  // a reduced or differently transformed grammar compiles to something
+  // else than the text as written
+  std::string key = source_ + modules_;
+  if (options_.reductions != grammar::REDUCE_NONE) {
+    key += "%reduce " + std::to_string(options_.reductions) + "\n";
+  }
+  if (options_.remove_ambiguity) {
+    key += "%remove-ambiguity\n";
+  }
+  return key;
+}
+
+bool Pipeline::BuildTable() {
+  // FIRST / FOLLOW are computed with EPSILON bodies as empty rules, the
+  // table is built from the productions as written
+  if (!cached_ || Wants(OUTPUT_FIRST_FOLLOW)) {
+    grammar::Productions emptied = EmptiedProductions();
+    if (!cached_) {
+      std::unordered_map<std::string, bool> nullables;
+      if (imports_.empty()) {
+        nullables = utils::CalcNullables(emptied);
+        firsts_ = utils::CalcFirsts(emptied, nullables);
+      } else {
+        // imported modules bring their own, only the grammar's productions are solved
+        grammar::Productions own(productions_.begin(), productions_.begin() + own_productions_);
+        grammar::CalcModuleSummary(own, imports_, nullables, firsts_);
+        for (const auto &module : imports_) {
+          nullables.insert(module->nullables.begin(), module->nullables.end());
+          firsts_.insert(module->firsts.begin(), module->firsts.end());
+        }
+      }
+      follows_ = utils::CalcFollows(emptied, firsts_, nullables, start_symbol_);
+    }
+    if (Wants(OUTPUT_FIRST_FOLLOW) &&
+        !utils::DumpFirstFollowAsJson(OutputPath("first_follow.json"), emptied, firsts_, follows_,
+                                      options_.compact_json)) {
+      return Fail("Error writing to first_follow.json");
+    }
+  }
+
+  // the cache keeps the declared terminals, the end marker is added here
+  CompiledArtifacts artifacts;
+  if (!cached_ && !options_.cache_dir.empty()) {
+    artifacts.terminals = terminals_;
+  }
+  // the end marker is not a declared terminal but needs a column
+  if (std::find(terminals_.begin(), terminals_.end(), utils::STRING_ENDMARKER) == terminals_.end()) {
+    terminals_.emplace_back(utils::STRING_ENDMARKER);
+  }
+  table_ = parser::ParsingTable();
+  table_.SetTerminals(terminals_);
+  table_.SetNonTerminals(non_terminals_);
+  table_.SetProductions(productions_);
+  table_.SetFirsts(firsts_);
+  table_.SetFollows(follows_);
+  if (cached_) {
+    table_.SetTable(cached_table_);
+    table_.SetErrors(cached_conflicts_);
+  } else {
+    table_.BuildTable();
+    if (!options_.cache_dir.empty()) {
+      artifacts.non_terminals = non_terminals_;
+      artifacts.start_symbol = start_symbol_;
+      artifacts.productions = productions_;
+      artifacts.generated = generated_;
+      artifacts.reduction = reduction_;
+      artifacts.left_recursion = left_recursion_;
+      artifacts.firsts = firsts_;
+      artifacts.follows = follows_;
+      artifacts.table = table_.GetTable();
+      artifacts.conflicts = table_.GetErrors();
+      // a failed store only costs the next run a compile
+      CompileCache(options_.cache_dir).Store(CacheKey(), artifacts);
+    }
+  }
+  if (Wants(OUTPUT_TABLE)) {
+    table_.DumpAsSparseJson(OutputPath("parsing_table.json"), options_.compact_json);
+  }
+  if (Wants(OUTPUT_GRAMMAR_FILE)) {
+    auto compiled =
+        parser::CompiledGrammar::Compile(productions_, terminals_, start_symbol_, table_.GetTable(), generated_);
+    if (!parser::WriteGrammarFile(OutputPath("grammar.jgb"), compiled, productions_, firsts_, follows_)) {
+      return Fail("Error writing to grammar.jgb");
+    }
+  }
+
+  if (!parser_.Initialize(productions_, terminals_, non_terminals_, start_symbol_, table_.GetTable(), generated_)) {
+    return Fail("Error initializing parser");
+  }
+  return true;
+}
+
+bool Pipeline::Lex(std::istream &source) {
+  lexer::Lexer lexer;
+  while (lexer.GetToken(source) != lexer::TOK_EOF) {
+  }
+
+  tokens_ = TokenTerminals(lexer.GetTokens());
+
+  if (Wants(OUTPUT_TOKENS)) {
+    auto out = utils::OutputBuffer::Open(OutputPath("tokens.json"));
+    lexer.DumpTokensAsJson(out, options_.compact_json);
+    out.Flush();
+    if (out.Failed()) {
+      return Fail("Error writing to tokens.json");
+    }
+  }
+  return true;
+}
+
+bool Pipeline::Parse() {
+  bool wants_trace = Wants(OUTPUT_TRACE) || Wants(OUTPUT_TRACE_FILE);
+  parser_.SetTraceLevel(wants_trace ? parser::TraceLevel::FULL : parser::TraceLevel::OFF);
+  parser_.SetBuildTree(Wants(OUTPUT_TREE) || Wants(OUTPUT_TREE_FILE));
+
+  std::vector<std::string> input = tokens_;
+  input.emplace_back(utils::STRING_ENDMARKER);
+  bool accepted = parser_.Parse(input);
+
+  if (Wants(OUTPUT_TRACE)) {
+    std::ofstream trace_file(OutputPath("parse_trace.json"));
+    if (!trace_file.is_open()) {
+      return Fail("Error writing to parse_trace.json");
+    }
+    parser_.DumpTraceAsJson(trace_file, options_.compact_json);
+  }
+  if (Wants(OUTPUT_TREE) &&
+      !parser_.WriteParseTree(OutputPath("parse_tree.json"), options_.compact_json, options_.compaction)) {
+    return Fail("Error writing to parse_tree.json");
+  }
+  if (Wants(OUTPUT_TREE_FILE) && !parser_.DumpTreeFile(OutputPath("parse_tree.jst"), options_.compaction)) {
+    return Fail("Error writing to parse_tree.jst");
+  }
+  if (Wants(OUTPUT_TRACE_FILE) && !parser_.DumpTraceFile(OutputPath("parse_trace.jtr"))) {
+    return Fail("Error writing to parse_trace.jtr");
+  }
+
+  if (!accepted) {
+    return Fail("Parsing failed");
+  }
+  return true;
+}
+
+bool Pipeline::Run(const std::string &grammar_path, std::istream *source) {
+  if (!LoadGrammar(grammar_path) || !BuildTable()) {
+    return false;
+  }
+  if (source == nullptr) {
+    return true;
+  }
+  return Lex(*source) && Parse();
+}
+
+}  // namespace jucc::pipeline
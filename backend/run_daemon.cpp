@@ -0,0 +1,46 @@
+#include <iostream>
+#include <string>
+#include "include/daemon/daemon.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+// Serves framed requests (see daemon/daemon.h) on stdin / stdout until end of input or shutdown.
+// Usage: daemon_run [--threads n] [--max-sessions n] [--cache dir]
+int main(int argc, char* argv[]) {
+    jucc::daemon::DaemonOptions options;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--threads" && i + 1 < argc) {
+                options.num_threads = std::stoul(argv[++i]);
+            } else if (arg == "--max-sessions" && i + 1 < argc) {
+                options.max_sessions = std::stoul(argv[++i]);
+            } else if (arg == "--cache" && i + 1 < argc) {
+                options.cache_dir = argv[++i];
+            } else {
+                std::cerr << "Usage: " << argv[0] << " [--threads n] [--max-sessions n] [--cache dir]\n";
+                return 1;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    // stdout carries frames only, anything the stages print goes to stderr
+    std::ostream frames(std::cout.rdbuf());
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    jucc::daemon::Daemon daemon(options);
+    size_t served = daemon.Serve(std::cin, frames);
+    std::cerr << "daemon: served " << served << " requests\n";
+    return 0;
+}
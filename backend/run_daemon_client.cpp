@@ -0,0 +1,34 @@
+#include <iostream>
+#include <string>
+#include "include/daemon/daemon.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+// Test client for daemon_run, converts between one JSON request per line and frames.
+// Usage: daemon_client_run < requests.jsonl | daemon_run | daemon_client_run --decode
+int main(int argc, char* argv[]) {
+    bool decode = argc > 1 && std::string(argv[1]) == "--decode";
+#ifdef _WIN32
+    _setmode(_fileno(decode ? stdin : stdout), _O_BINARY);
+#endif
+
+    std::string payload;
+    if (decode) {
+        while (jucc::daemon::ReadFrame(std::cin, payload)) {
+            std::cout << payload << "\n";
+        }
+        return 0;
+    }
+    while (std::getline(std::cin, payload)) {
+        if (!payload.empty() && payload.back() == '\r') {
+            payload.pop_back();
+        }
+        if (!payload.empty()) {
+            jucc::daemon::WriteFrame(std::cout, payload);
+        }
+    }
+    return 0;
+}
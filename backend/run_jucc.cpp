@@ -0,0 +1,186 @@
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "include/pipeline/pipeline.h"
+#include "include/utils/thread_pool.h"
+
+namespace {
+
+void PrintUsage() {
+    std::cerr << "usage: jucc <grammar file> [source file] [--out dir] [--emit name[,name...]] [--compact]\n"
+                 "            [--compact-tree] [--cache dir] [--threads n] [--reduce name[,name...]]\n"
+                 "            [--remove-ambiguity] [--verbose]\n"
+                 "  --emit    outputs to write: grammar, first-follow, table, jgb, tokens, trace,\n"
+                 "            tree, tree-file, trace-file or all (default: none)\n"
+                 "  --compact write JSON without whitespace\n"
+                 "  --compact-tree drop epsilons, transform helpers and unary chains from exported trees\n"
+                 "  --cache   reuse grammars compiled before, keyed by their normalized text\n"
+                 "  --threads left factor productions on n threads, 0 for one per core (default: 1)\n"
+                 "  --reduce  grammar reductions to run after parsing: useless, units, duplicates\n"
+                 "            or all (default: none)\n"
+                 "  --remove-ambiguity remove left recursion with Paull's substitution on the\n"
+                 "            left recursive components and left factor with the utils transforms\n"
+                 "  --verbose report what the grammar parser reads on stderr\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // Grammar, tables, tokens and parse all stay in memory, only --emit outputs hit the disk
+    jucc::pipeline::PipelineOptions options;
+    std::string grammar_path;
+    std::string source_path;
+    size_t threads = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) {
+            options.output_dir = argv[++i];
+        } else if (arg == "--emit" && i + 1 < argc) {
+            std::string names = argv[++i];
+            size_t begin = 0;
+            while (begin <= names.size()) {
+                size_t end = names.find(',', begin);
+                if (end == std::string::npos) {
+                    end = names.size();
+                }
+                std::string name = names.substr(begin, end - begin);
+                unsigned output = jucc::pipeline::OutputFromName(name);
+                if (output == jucc::pipeline::OUTPUT_NONE) {
+                    std::cerr << "Error: unknown output " << name << "\n";
+                    PrintUsage();
+                    return 1;
+                }
+                options.outputs |= output;
+                begin = end + 1;
+            }
+        } else if (arg == "--reduce" && i + 1 < argc) {
+            std::string names = argv[++i];
+            size_t begin = 0;
+            while (begin <= names.size()) {
+                size_t end = names.find(',', begin);
+                if (end == std::string::npos) {
+                    end = names.size();
+                }
+                std::string name = names.substr(begin, end - begin);
+                unsigned reduction = jucc::grammar::ReductionFromName(name);
+                if (reduction == jucc::grammar::REDUCE_NONE) {
+                    std::cerr << "Error: unknown reduction " << name << "\n";
+                    PrintUsage();
+                    return 1;
+                }
+                options.reductions |= reduction;
+                begin = end + 1;
+            }
+        } else if (arg == "--cache" && i + 1 < argc) {
+            options.cache_dir = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            try {
+                threads = std::stoul(argv[++i]);
+            } catch (const std::exception&) {
+                PrintUsage();
+                return 1;
+            }
+        } else if (arg == "--compact") {
+            options.compact_json = true;
+        } else if (arg == "--compact-tree") {
+            options.compaction = jucc::parser::CompactionOptions::All();
+        } else if (arg == "--remove-ambiguity") {
+            options.remove_ambiguity = true;
+        } else if (arg == "--verbose") {
+            options.log = &std::cerr;
+        } else if (!arg.empty() && arg[0] == '-') {
+            PrintUsage();
+            return 1;
+        } else if (grammar_path.empty()) {
+            grammar_path = arg;
+        } else if (source_path.empty()) {
+            source_path = arg;
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if (grammar_path.empty()) {
+        PrintUsage();
+        return 1;
+    }
+
+    std::ifstream source;
+    if (!source_path.empty()) {
+        source.open(source_path);
+        if (!source.is_open()) {
+            std::cerr << "Error: Could not open " << source_path << "\n";
+            return 1;
+        }
+    }
+
+    std::unique_ptr<jucc::utils::ThreadPool> pool;
+    if (threads != 1) {
+        pool = std::make_unique<jucc::utils::ThreadPool>(threads);
+        options.pool = pool.get();
+    }
+
+    jucc::pipeline::Pipeline pipeline(options);
+    bool success = pipeline.Run(grammar_path, source_path.empty() ? nullptr : &source);
+
+    const auto& reduction = pipeline.GetReductionReport();
+    if (!reduction.Empty()) {
+        auto print_names = [](const char* what, const std::vector<std::string>& names) {
+            if (names.empty()) {
+                return;
+            }
+            std::cout << "  " << what << ":";
+            for (const auto& name : names) {
+                std::cout << " " << name;
+            }
+            std::cout << "\n";
+        };
+        auto print_pairs = [](const char* what, const char* arrow,
+                              const std::vector<std::pair<std::string, std::string>>& pairs) {
+            if (pairs.empty()) {
+                return;
+            }
+            std::cout << "  " << what << ":";
+            for (const auto& pair : pairs) {
+                std::cout << " " << pair.first << arrow << pair.second;
+            }
+            std::cout << "\n";
+        };
+        std::cout << "Reduced grammar from " << reduction.before.productions << " productions, "
+                  << reduction.before.rules << " rules to " << reduction.after.productions << " productions, "
+                  << reduction.after.rules << " rules:\n";
+        print_names("removed unproductive", reduction.unproductive);
+        print_names("removed unreachable", reduction.unreachable);
+        print_pairs("inlined unit rules", " : ", reduction.units);
+        print_pairs("merged", " into ", reduction.merged);
+    }
+
+    const auto& left_recursion = pipeline.GetLeftRecursionReport();
+    if (left_recursion.before.productions != 0) {
+        std::cout << "Removed left recursion from " << left_recursion.recursive_components << " components with "
+                  << left_recursion.substitutions << " substitutions, grammar from "
+                  << left_recursion.before.productions << " productions, " << left_recursion.before.rules
+                  << " rules to " << left_recursion.after.productions << " productions, "
+                  << left_recursion.after.rules << " rules\n";
+    }
+
+    const auto& conflicts = pipeline.GetConflicts();
+    if (!conflicts.empty()) {
+        std::cout << "Warning: Grammar is not LL(1). Found following conflicts:\n";
+        for (const auto& conflict : conflicts) {
+            std::cout << conflict << "\n";
+        }
+    }
+
+    if (!success) {
+        std::cerr << "Error: " << pipeline.GetError() << "\n";
+        return 1;
+    }
+    if (!source_path.empty()) {
+        std::cout << "✅ Input successfully parsed!\n";
+    } else {
+        std::cout << "✅ Parsing table generated successfully!\n";
+    }
+    return 0;
+}
@@ -5,15 +5,26 @@
 #include "parser/ll_parser.h"
 #include "third_party/json.hpp"
 
-int main() {
-    try {
-        // Read the parsing table
-        std::ifstream table_file("test_parsing_table.json");
-        if (!table_file.is_open()) {
-            std::cerr << "Error: Could not open test_parsing_table.json\n";
-            return 1;
+int main(int argc, char* argv[]) {
+    // --compact-tree drops epsilons, transform helpers and unary chains from parse_tree.json
+    // --grammar-file <path> maps a compiled grammar (grammar.jgb) instead of reading
+    // test_grammar.json and test_parsing_table.json
+    // --verify checks the checksum and every table entry of the grammar file before using it
+    jucc::parser::CompactionOptions compaction;
+    std::string grammar_file_path;
+    bool verify = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--compact-tree") {
+            compaction = jucc::parser::CompactionOptions::All();
+        } else if (arg == "--grammar-file" && i + 1 < argc) {
+            grammar_file_path = argv[++i];
+        } else if (arg == "--verify") {
+            verify = true;
         }
+    }
 
+    try {
         // Read the input tokens
         std::ifstream input_file("test_input_tokens.json");
         if (!input_file.is_open()) {
@@ -21,13 +32,6 @@ int main() {
     return 1;
   }
 
-        // Read the grammar for production rules
-        std::ifstream grammar_file("test_grammar.json");
-        if (!grammar_file.is_open()) {
-            std::cerr << "Error: Could not open test_grammar.json\n";
-            return 1;
-        }
-
         // Parse the input tokens from test_input_tokens.json
         std::vector<std::string> input_tokens;
         try {
@@ -47,11 +51,33 @@ int main() {
 
         // Create and initialize the parser
         jucc::parser::LLParser parser;
-        try {
-            parser.Initialize(grammar_file, table_file);
-        } catch (const std::exception& e) {
-            std::cerr << "Error initializing parser: " << e.what() << "\n";
-            return 1;
+        if (!grammar_file_path.empty()) {
+            if (!parser.LoadGrammarFile(grammar_file_path, verify)) {
+                return 1;
+            }
+        } else {
+            // Read the grammar for production rules
+            std::ifstream grammar_file("test_grammar.json");
+            if (!grammar_file.is_open()) {
+                std::cerr << "Error: Could not open test_grammar.json\n";
+                return 1;
+            }
+
+            // Read the parsing table
+            std::ifstream table_file("test_parsing_table.json");
+            if (!table_file.is_open()) {
+                std::cerr << "Error: Could not open test_parsing_table.json\n";
+                return 1;
+            }
+
+            try {
+                if (!parser.Initialize(grammar_file, table_file)) {
+                    return 1;
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "Error initializing parser: " << e.what() << "\n";
+                return 1;
+            }
         }
         
         // Parse the input
@@ -64,6 +90,21 @@ int main() {
             trace_file.close();
   }
 
+        // Parse tree built during parsing, in Treant.js format
+        if (!parser.WriteParseTree("parse_tree.json", false, compaction)) {
+            std::cerr << "Warning: could not write parse_tree.json\n";
+        }
+
+        // Node file of the tree for fetching subtrees on demand
+        if (!parser.DumpTreeFile("parse_tree.jst", compaction)) {
+            std::cerr << "Warning: could not write parse_tree.jst\n";
+        }
+
+        // Chunked copy of the trace for paging through large parses
+        if (!parser.DumpTraceFile("parse_trace.jtr")) {
+            std::cerr << "Warning: could not write parse_trace.jtr\n";
+        }
+
         if (success) {
             std::cout << "✅ Input successfully parsed!\n";
   return 0;
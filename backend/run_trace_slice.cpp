@@ -0,0 +1,41 @@
+#include <iostream>
+#include <string>
+#include "parser/trace_file.h"
+
+// Prints steps [from, to) of a chunked trace file in the parse_trace.json format.
+// Usage: trace_slice_run <parse_trace.jtr> <from> <to>
+//        trace_slice_run <parse_trace.jtr> --count
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <parse_trace.jtr> <from> <to> | --count\n";
+        return 1;
+    }
+
+    jucc::parser::TraceFileReader reader;
+    if (!reader.Open(argv[1])) {
+        std::cerr << reader.GetError() << "\n";
+        return 1;
+    }
+
+    if (std::string(argv[2]) == "--count") {
+        std::cout << "{\"steps\": " << reader.GetNumSteps() << ", \"interval\": " << reader.GetInterval() << "}\n";
+        return 0;
+    }
+
+    try {
+        uint64_t from = std::stoull(argv[2]);
+        uint64_t to = argc > 3 ? std::stoull(argv[3]) : from + 1;
+        jucc::utils::OutputBuffer out(std::cout);
+        jucc::utils::JsonEmitter json(out);
+        json.BeginArray();
+        for (const auto& entry : reader.Read(from, to)) {
+            jucc::parser::WriteTraceEntryJson(json, entry);
+        }
+        json.EndArray();
+        json.Finish();
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include <iostream>
+#include <string>
+#include "parser/tree_file.h"
+#include "parser/tree_writer.h"
+
+// Prints the subtree below a node of a parse tree file, depth levels deep, in Treant.js format.
+// Usage: tree_slice_run <parse_tree.jst> <node|root> [depth]
+//        tree_slice_run <parse_tree.jst> --count
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <parse_tree.jst> <node|root> [depth] | --count\n";
+        return 1;
+    }
+
+    jucc::parser::TreeFileReader reader;
+    if (!reader.Open(argv[1])) {
+        std::cerr << reader.GetError() << "\n";
+        return 1;
+    }
+
+    if (std::string(argv[2]) == "--count") {
+        std::cout << "{\"nodes\": " << reader.GetNumNodes() << ", \"root\": " << reader.GetRoot() << "}\n";
+        return 0;
+    }
+
+    try {
+        jucc::parser::NodeId node = std::string(argv[2]) == "root"
+                                        ? reader.GetRoot()
+                                        : static_cast<jucc::parser::NodeId>(std::stoul(argv[2]));
+        auto depth = static_cast<uint32_t>(argc > 3 ? std::stoul(argv[3]) : 1);
+        if (node >= reader.GetNumNodes()) {
+            std::cerr << "Error: no node " << argv[2] << "\n";
+            return 1;
+        }
+
+        jucc::utils::OutputBuffer out(std::cout);
+        jucc::parser::TreantWriter::WriteSlice(reader.GetSlice(node, depth), reader.GetNames(), out);
+        out.Flush();
+        if (!reader.GetError().empty()) {
+            std::cerr << reader.GetError() << "\n";
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
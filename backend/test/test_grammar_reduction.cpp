@@ -0,0 +1,196 @@
+// Property checks for grammar::ReduceGrammar on random grammars, for every
+// combination of passes:
+//   - the start symbol derives the same strings, up to a length;
+//   - with REDUCE_USELESS every non terminal left derives a string of
+//     terminals and is reachable from the start symbol;
+//   - the report measures the input and the output, and nothing it lists
+//     as removed or merged away is still a parent, but for the start symbol
+//     that is kept even when it derives nothing;
+//   - running the same passes on the output leaves it as it is.
+//
+// Arguments and output as described in test_harness.h.
+
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "grammar/grammar_reduction.h"
+#include "test/test_harness.h"
+
+namespace {
+
+using jucc::grammar::Productions;
+using jucc::grammar::ReductionReport;
+using jucc::test::ProductionsText;
+
+constexpr size_t MAX_LENGTH = 6;
+constexpr char START[] = "N0";
+
+// Terminals are the single letters a and b, so derived strings can be
+// compared as text.
+jucc::test::RuleShape Shape() {
+  jucc::test::RuleShape shape;
+  shape.terminals = {"a", "b"};
+  shape.max_extra = 2;
+  shape.epsilon_one_in = 6;
+  return shape;
+}
+
+// strings of at most MAX_LENGTH terminals every non terminal derives, as a least fixpoint
+std::map<std::string, std::set<std::string>> Languages(const Productions &productions) {
+  std::map<std::string, std::set<std::string>> languages;
+  for (const auto &production : productions) {
+    languages[production.GetParent()];
+  }
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const auto &production : productions) {
+      for (const auto &rule : production.GetRules()) {
+        std::set<std::string> derived{""};
+        for (const auto &symbol : rule.GetEntities()) {
+          if (symbol == jucc::grammar::EPSILON) {
+            continue;
+          }
+          std::set<std::string> longer;
+          auto it = languages.find(symbol);
+          for (const auto &prefix : derived) {
+            if (it == languages.end()) {
+              if (prefix.size() < MAX_LENGTH) {
+                longer.insert(prefix + symbol);
+              }
+              continue;
+            }
+            for (const auto &suffix : it->second) {
+              if (prefix.size() + suffix.size() <= MAX_LENGTH) {
+                longer.insert(prefix + suffix);
+              }
+            }
+          }
+          derived = std::move(longer);
+        }
+        for (const auto &text : derived) {
+          changed = languages[production.GetParent()].insert(text).second || changed;
+        }
+      }
+    }
+  }
+  return languages;
+}
+
+// non terminals deriving some string of terminals, as a least fixpoint
+std::set<std::string> Productive(const Productions &productions) {
+  std::set<std::string> parents;
+  for (const auto &production : productions) {
+    parents.insert(production.GetParent());
+  }
+  std::set<std::string> productive;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const auto &production : productions) {
+      for (const auto &rule : production.GetRules()) {
+        bool derives = true;
+        for (const auto &symbol : rule.GetEntities()) {
+          derives = derives && (parents.count(symbol) == 0 || productive.count(symbol) != 0);
+        }
+        if (derives) {
+          changed = productive.insert(production.GetParent()).second || changed;
+        }
+      }
+    }
+  }
+  return productive;
+}
+
+// names of every property output breaks, empty if none
+std::string Check(const Productions &input, const Productions &output, unsigned reductions,
+                  const ReductionReport &report) {
+  std::string problems;
+  if (Languages(input)[START] != Languages(output)[START]) {
+    problems += " language changed";
+  }
+
+  std::set<std::string> parents;
+  for (const auto &production : output) {
+    parents.insert(production.GetParent());
+  }
+  if ((reductions & jucc::grammar::REDUCE_USELESS) != 0) {
+    std::set<std::string> productive = Productive(output);
+    std::set<std::string> reached{START};
+    std::vector<std::string> pending{START};
+    while (!pending.empty()) {
+      std::string parent = pending.back();
+      pending.pop_back();
+      for (const auto &production : output) {
+        if (production.GetParent() != parent) {
+          continue;
+        }
+        for (const auto &rule : production.GetRules()) {
+          for (const auto &symbol : rule.GetEntities()) {
+            if (parents.count(symbol) != 0 && reached.insert(symbol).second) {
+              pending.push_back(symbol);
+            }
+          }
+        }
+      }
+    }
+    for (const auto &parent : parents) {
+      if (parent != START && productive.count(parent) == 0) {
+        problems += " " + parent + " is unproductive";
+      }
+      if (reached.count(parent) == 0) {
+        problems += " " + parent + " is unreachable";
+      }
+    }
+  }
+
+  auto same_size = [](const jucc::utils::GrammarSize &a, const jucc::utils::GrammarSize &b) {
+    return a.productions == b.productions && a.rules == b.rules && a.symbols == b.symbols;
+  };
+  if (!same_size(report.before, jucc::utils::MeasureGrammar(input)) ||
+      !same_size(report.after, jucc::utils::MeasureGrammar(output))) {
+    problems += " report sizes are wrong";
+  }
+  std::vector<std::string> removed = report.unproductive;
+  removed.insert(removed.end(), report.unreachable.begin(), report.unreachable.end());
+  for (const auto &merged : report.merged) {
+    removed.push_back(merged.first);
+  }
+  for (const auto &name : removed) {
+    if (name != START && parents.count(name) != 0) {
+      problems += " " + name + " is reported removed";
+    }
+  }
+
+  if (ProductionsText(jucc::grammar::ReduceGrammar(output, START, reductions)) != ProductionsText(output)) {
+    problems += " reducing again changes the output";
+  }
+  return problems;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const jucc::test::RuleShape shape = Shape();
+  size_t shrunk = 0;
+  auto check = [&](unsigned seed, std::mt19937 &random) {
+    Productions input = jucc::test::RandomProductions(2 + static_cast<int>(seed % 8), shape, random);
+    for (unsigned reductions = 1; reductions <= jucc::grammar::REDUCE_ALL; reductions++) {
+      ReductionReport report;
+      Productions output = jucc::grammar::ReduceGrammar(input, START, reductions, &report);
+      if (reductions == jucc::grammar::REDUCE_ALL && output.size() < input.size()) {
+        shrunk++;
+      }
+      std::string problems = Check(input, output, reductions, report);
+      if (!problems.empty()) {
+        return " reductions " + std::to_string(reductions) + ":" + problems + "\n" + ProductionsText(input);
+      }
+    }
+    return std::string();
+  };
+  return jucc::test::RunSeeds(argc, argv, 3000, check,
+                              [&] { return std::to_string(shrunk) + " shrunk by every pass"; });
+}
@@ -0,0 +1,138 @@
+#ifndef JUCC_TEST_TEST_HARNESS_H
+#define JUCC_TEST_TEST_HARNESS_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "grammar/grammar.h"
+
+/**
+ * What the randomized tests under test/ share: a generator of random
+ * grammars, a printer for what they compile to and the driver running a
+ * check over a range of seeds. Every test takes
+ *
+ *   test_<name> [grammars] [first seed]
+ *
+ * and exits with 1 after the first failures, printing the seed and the
+ * grammar that caused them, so a failure is replayed with its seed.
+ */
+
+namespace jucc::test {
+
+constexpr int MAX_REPORTED = 3;
+
+/**
+ * How RandomRules writes the rules of a non terminal Ni of N0 .. Nn-1.
+ */
+struct RuleShape {
+  std::vector<std::string> terminals;
+  int min_rules{1};
+  int max_rules{3};
+  int max_extra{3};            // symbols after the first, the count is uniform in 0 .. max_extra
+  int epsilon_one_in{0};       // a rule is EPSILON with chance 1 / epsilon_one_in, never if 0
+  int non_terminal_one_in{2};  // chance of a non terminal for every symbol but a leading one
+  // a leading symbol is N0 .. Ni one time in three and else any non terminal
+  // one time in four, which makes direct and indirect left recursion common;
+  // otherwise it is like any other symbol
+  bool leading_earlier{false};
+  // a leading non terminal is followed by a terminal, so there are no cycles of unit rules
+  bool terminal_after_leading{false};
+};
+
+inline std::string NonTerminal(int i) { return "N" + std::to_string(i); }
+
+inline grammar::Rules RandomRules(int i, int n, const RuleShape &shape, std::mt19937 &random) {
+  auto below = [&random](int bound) { return static_cast<int>(random() % static_cast<unsigned>(bound)); };
+  auto terminal = [&]() { return shape.terminals[below(static_cast<int>(shape.terminals.size()))]; };
+
+  grammar::Rules rules;
+  for (int count = shape.min_rules + below(shape.max_rules - shape.min_rules + 1); count > 0; count--) {
+    if (shape.epsilon_one_in != 0 && below(shape.epsilon_one_in) == 0) {
+      rules.emplace_back(std::vector<std::string>{grammar::EPSILON});
+      continue;
+    }
+    std::vector<std::string> entities;
+    bool leading_non_terminal = true;
+    if (shape.leading_earlier && below(3) == 0) {
+      entities.push_back(NonTerminal(below(i + 1)));
+    } else if (below(shape.leading_earlier ? 4 : shape.non_terminal_one_in) == 0) {
+      entities.push_back(NonTerminal(below(n)));
+    } else {
+      leading_non_terminal = false;
+      entities.push_back(terminal());
+    }
+    if (shape.terminal_after_leading && leading_non_terminal) {
+      entities.push_back(terminal());
+    }
+    for (int extra = below(shape.max_extra + 1); extra > 0; extra--) {
+      entities.push_back(below(shape.non_terminal_one_in) == 0 ? NonTerminal(below(n)) : terminal());
+    }
+    rules.emplace_back(entities);
+  }
+  return rules;
+}
+
+/**
+ * Productions N0 .. Nn-1, in order, each with RandomRules.
+ */
+inline grammar::Productions RandomProductions(int n, const RuleShape &shape, std::mt19937 &random) {
+  grammar::Productions productions;
+  for (int i = 0; i < n; i++) {
+    productions.emplace_back(NonTerminal(i), RandomRules(i, n, shape, random));
+  }
+  return productions;
+}
+
+/**
+ * One line per production, "parent -> | a b | c", to compare and print.
+ */
+inline std::string ProductionsText(const grammar::Productions &productions) {
+  std::string text;
+  for (const auto &production : productions) {
+    text += production.GetParent() + " ->";
+    for (const auto &rule : production.GetRules()) {
+      text += " |";
+      for (const auto &symbol : rule.GetEntities()) {
+        text += " " + symbol;
+      }
+    }
+    text += "\n";
+  }
+  return text;
+}
+
+/**
+ * Runs check for every seed of the range argv names, default_grammars
+ * seeds from 0 if it names none, until MAX_REPORTED checks failed.
+ * @param check given the seed and a generator seeded with it, returns what
+ * is wrong followed by the grammar, empty if nothing is
+ * @param counts what the test counted on the way, for the summary line
+ * @returns the exit code of the test
+ */
+inline int RunSeeds(int argc, char *argv[], unsigned default_grammars,
+                    const std::function<std::string(unsigned, std::mt19937 &)> &check,
+                    const std::function<std::string()> &counts) {
+  unsigned grammars = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : default_grammars;
+  unsigned first_seed = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : 0;
+
+  int failures = 0;
+  for (unsigned seed = first_seed; seed < first_seed + grammars && failures < MAX_REPORTED; seed++) {
+    std::mt19937 random(seed);
+    std::string problems = check(seed, random);
+    if (!problems.empty()) {
+      std::fprintf(stderr, "seed %u:%s\n", seed, problems.c_str());
+      failures++;
+    }
+  }
+
+  std::fprintf(stderr, "%u grammars, %s, %d failures\n", grammars, counts().c_str(), failures);
+  return failures == 0 ? 0 : 1;
+}
+
+}  // namespace jucc::test
+
+#endif  // JUCC_TEST_TEST_HARNESS_H
@@ -0,0 +1,196 @@
+// Checks pipeline::IncrementalCompiler against a full pipeline::Pipeline
+// rebuild: random grammars are loaded, then edited one production at a time,
+// and after every step both must give the same grammar, sets, table and
+// conflicts.
+//
+// Arguments and output as described in test_harness.h.
+
+#include <cstdio>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "pipeline/incremental_compiler.h"
+#include "pipeline/pipeline.h"
+#include "test/test_harness.h"
+
+namespace {
+
+using jucc::grammar::Productions;
+using jucc::grammar::Rules;
+using jucc::pipeline::IncrementalCompiler;
+using jucc::pipeline::Pipeline;
+using jucc::test::ProductionsText;
+
+constexpr int EDITS_PER_GRAMMAR = 6;
+
+struct RandomGrammar {
+  int num_terminals;
+  std::vector<bool> has_rules;  // a declared non terminal may have no production
+  Productions productions;      // N0 .. Nn-1, whether they have rules or not
+};
+
+std::string Terminal(int i) { return "t" + std::to_string(i); }
+
+jucc::test::RuleShape Shape(int num_terminals) {
+  jucc::test::RuleShape shape;
+  for (int t = 0; t < num_terminals; t++) {
+    shape.terminals.push_back(Terminal(t));
+  }
+  shape.max_rules = 4;
+  shape.epsilon_one_in = 7;
+  shape.leading_earlier = true;
+  return shape;
+}
+
+std::string GrammarText(const RandomGrammar &grammar) {
+  std::string text = "%terminals\n";
+  for (int t = 0; t < grammar.num_terminals; t++) {
+    text += Terminal(t) + " ";
+  }
+  text += "\n%end\n%non_terminals\n";
+  for (const auto &production : grammar.productions) {
+    text += production.GetParent() + " ";
+  }
+  text += "\n%end\n%start\nN0\n%end\n%rules\n";
+  for (size_t i = 0; i < grammar.productions.size(); i++) {
+    if (!grammar.has_rules[i]) {
+      continue;
+    }
+    for (const auto &rule : grammar.productions[i].GetRules()) {
+      text += grammar.productions[i].GetParent() + " :";
+      for (const auto &symbol : rule.GetEntities()) {
+        text += " " + symbol;
+      }
+      text += "\n";
+    }
+  }
+  return text + "%end\n";
+}
+
+// FIRST and FOLLOW hold the same symbols but not in the same order, see IncrementalCompiler
+std::map<std::string, std::set<std::string>> AsSets(const jucc::utils::SymbolsMap &map) {
+  std::map<std::string, std::set<std::string>> sets;
+  for (const auto &[name, symbols] : map) {
+    sets[name] = std::set<std::string>(symbols.begin(), symbols.end());
+  }
+  return sets;
+}
+
+// names of everything that differs from a full rebuild, empty if nothing does
+std::string Compare(const IncrementalCompiler &compiler, const RandomGrammar &grammar) {
+  std::istringstream text(GrammarText(grammar));
+  Pipeline pipeline;
+  if (!pipeline.LoadGrammar(text) || !pipeline.BuildTable()) {
+    return " pipeline: " + pipeline.GetError();
+  }
+
+  std::string differences;
+  if (ProductionsText(compiler.GetProductions()) != ProductionsText(pipeline.GetProductions())) {
+    differences += " productions";
+  }
+  if (compiler.GetNonTerminals() != pipeline.GetNonTerminals()) {
+    differences += " non_terminals";
+  }
+  auto generated = compiler.GetGenerated();
+  if (generated.helpers != pipeline.GetGenerated().helpers || generated.loops != pipeline.GetGenerated().loops) {
+    differences += " generated";
+  }
+  if (AsSets(compiler.GetFirsts()) != AsSets(pipeline.GetFirsts())) {
+    differences += " firsts";
+  }
+  if (AsSets(compiler.GetFollows()) != AsSets(pipeline.GetFollows())) {
+    differences += " follows";
+  }
+  if (compiler.GetTable() != pipeline.GetTable().GetTable()) {
+    differences += " table";
+  }
+  auto conflicts = compiler.GetConflicts();
+  if (std::multiset<std::string>(conflicts.begin(), conflicts.end()) !=
+      std::multiset<std::string>(pipeline.GetConflicts().begin(), pipeline.GetConflicts().end())) {
+    differences += " conflicts";
+  }
+  return differences;
+}
+
+// an edit using a symbol the grammar does not declare must fail as a full
+// rebuild of the edited text does, and leave the compiled grammar as it was
+std::string RejectUndeclared(IncrementalCompiler &compiler, const RandomGrammar &grammar,
+                             const jucc::test::RuleShape &shape, std::mt19937 &random) {
+  RandomGrammar edited = grammar;
+  int n = static_cast<int>(grammar.productions.size());
+  Rules rules = jucc::test::RandomRules(0, n, shape, random);
+  auto &rule = rules[random() % rules.size()];
+  std::vector<std::string> entities = rule.GetEntities();
+  entities.insert(entities.begin() + static_cast<std::ptrdiff_t>(random() % (entities.size() + 1)), "undeclared");
+  rule = jucc::grammar::Rule(entities);
+  edited.productions[0].SetRules(rules);
+
+  std::istringstream text(GrammarText(edited));
+  Pipeline pipeline;
+  if (pipeline.LoadGrammar(text)) {
+    return " pipeline accepts an undeclared symbol";
+  }
+  if (compiler.ReplaceRules(jucc::test::NonTerminal(0), rules)) {
+    return " undeclared symbol accepted";
+  }
+  if ("Failed to parse grammar: " + compiler.GetError() != pipeline.GetError()) {
+    return " undeclared symbol error: " + compiler.GetError();
+  }
+  std::string differences = Compare(compiler, grammar);
+  return differences.empty() ? differences : " after a rejected edit:" + differences;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  size_t edits = 0;
+  size_t rows = 0;
+  auto check = [&](unsigned seed, std::mt19937 &random) {
+    int n = 2 + static_cast<int>(seed % 8);
+    RandomGrammar grammar{3 + static_cast<int>(seed % 8), {}, {}};
+    const jucc::test::RuleShape shape = Shape(grammar.num_terminals);
+    for (int i = 0; i < n; i++) {
+      grammar.has_rules.push_back(i == 0 || random() % 8 != 0);
+    }
+    grammar.productions = jucc::test::RandomProductions(n, shape, random);
+
+    IncrementalCompiler compiler;
+    std::istringstream text(GrammarText(grammar));
+    if (!compiler.Load(text)) {
+      return " load failed: " + compiler.GetError() + "\n" + GrammarText(grammar);
+    }
+    std::string differences = Compare(compiler, grammar);
+    if (differences.empty()) {
+      differences = RejectUndeclared(compiler, grammar, shape, random);
+    }
+    for (int edit = 0; differences.empty() && edit < EDITS_PER_GRAMMAR; edit++) {
+      int i = 0;
+      do {
+        i = static_cast<int>(random() % n);
+      } while (!grammar.has_rules[i]);
+      grammar.productions[i].SetRules(jucc::test::RandomRules(i, n, shape, random));
+      if (!compiler.ReplaceRules(grammar.productions[i].GetParent(), grammar.productions[i].GetRules())) {
+        differences = " replace failed: " + compiler.GetError();
+        break;
+      }
+      edits++;
+      rows += compiler.GetLastEdit().rows;
+      differences = Compare(compiler, grammar);
+      if (!differences.empty()) {
+        differences = " after edit " + std::to_string(edit) + " of " + grammar.productions[i].GetParent() + ":" +
+                      differences;
+      }
+    }
+    return differences.empty() ? differences : differences + "\n" + GrammarText(grammar);
+  };
+  return jucc::test::RunSeeds(argc, argv, 1500, check, [&] {
+    char counts[96];
+    std::snprintf(counts, sizeof(counts), "%zu edits, %.2f table rows rebuilt per edit", edits,
+                  edits == 0 ? 0.0 : static_cast<double>(rows) / static_cast<double>(edits));
+    return std::string(counts);
+  });
+}
@@ -0,0 +1,162 @@
+// Property checks for left factoring, GrammarTransform::ApplyLeftFactoring
+// and utils::RemoveLeftFactors, on random grammars:
+//   - no two rules of an output production start with the same symbol;
+//   - inlining the new non terminals gives back the rules of the input
+//     production, without duplicates;
+//   - new non terminals do not take the name of an existing one;
+//   - ApplyLeftFactoring gives the same output on a thread pool.
+//
+// Arguments and output as described in test_harness.h.
+
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "grammar/grammar_transform.h"
+#include "test/test_harness.h"
+#include "utils/left_factoring.h"
+#include "utils/thread_pool.h"
+
+namespace {
+
+using jucc::grammar::GrammarTransform;
+using jucc::grammar::Production;
+using jucc::grammar::Productions;
+using jucc::grammar::Rules;
+using jucc::test::ProductionsText;
+using Symbols = std::vector<std::string>;
+
+// A few terminals and non terminals, so that rules share prefixes often.
+// One grammar in four has a parent named like the first new non terminal.
+Productions GenerateGrammar(std::mt19937 &random) {
+  jucc::test::RuleShape shape;
+  shape.terminals = {"a", "b", "c"};
+  shape.max_rules = 6;
+  shape.epsilon_one_in = 5;
+  shape.non_terminal_one_in = 3;
+  Productions productions = jucc::test::RandomProductions(1 + static_cast<int>(random() % 4), shape, random);
+  if (random() % 4 == 0) {
+    productions.emplace_back("N0_fact", Rules{jucc::grammar::Rule({"a"})});
+  }
+  return productions;
+}
+
+Symbols WithoutEpsilon(const Symbols &symbols) {
+  Symbols result;
+  for (const auto &symbol : symbols) {
+    if (symbol != jucc::grammar::EPSILON) {
+      result.push_back(symbol);
+    }
+  }
+  return result;
+}
+
+// every rule parent derives once the new non terminals in helpers are inlined
+std::set<Symbols> Inline(const std::string &parent, const std::map<std::string, const Production *> &helpers,
+                         const std::map<std::string, const Production *> &outputs) {
+  std::set<Symbols> inlined;
+  for (const auto &rule : outputs.at(parent)->GetRules()) {
+    std::set<Symbols> prefixes{{}};
+    for (const auto &symbol : WithoutEpsilon(rule.GetEntities())) {
+      std::set<Symbols> longer;
+      if (helpers.count(symbol) != 0) {
+        for (const auto &prefix : prefixes) {
+          for (const auto &suffix : Inline(symbol, helpers, outputs)) {
+            Symbols joined = prefix;
+            joined.insert(joined.end(), suffix.begin(), suffix.end());
+            longer.insert(joined);
+          }
+        }
+      } else {
+        for (auto prefix : prefixes) {
+          prefix.push_back(symbol);
+          longer.insert(prefix);
+        }
+      }
+      prefixes = std::move(longer);
+    }
+    inlined.insert(prefixes.begin(), prefixes.end());
+  }
+  return inlined;
+}
+
+// names of every property output breaks for input, empty if none
+std::string Check(const Productions &input, const Productions &output) {
+  std::string problems;
+  std::unordered_set<std::string> parents;
+  for (const auto &production : input) {
+    parents.insert(production.GetParent());
+  }
+
+  std::map<std::string, const Production *> outputs;
+  std::map<std::string, const Production *> helpers;
+  for (const auto &production : output) {
+    if (!outputs.emplace(production.GetParent(), &production).second) {
+      problems += " " + production.GetParent() + " is produced twice";
+    }
+    if (parents.count(production.GetParent()) == 0) {
+      helpers.emplace(production.GetParent(), &production);
+    }
+    std::set<std::string> leading;
+    size_t rules = 0;
+    for (const auto &rule : production.GetRules()) {
+      leading.insert(rule.GetEntities().empty() ? std::string() : rule.GetEntities()[0]);
+      rules++;
+    }
+    if (leading.size() != rules) {
+      problems += " " + production.GetParent() + " has rules with a common prefix";
+    }
+  }
+  if (!problems.empty()) {
+    return problems;
+  }
+
+  for (const auto &production : input) {
+    if (outputs.count(production.GetParent()) == 0) {
+      problems += " " + production.GetParent() + " is gone";
+      continue;
+    }
+    std::set<Symbols> rules;
+    for (const auto &rule : production.GetRules()) {
+      rules.insert(WithoutEpsilon(rule.GetEntities()));
+    }
+    if (Inline(production.GetParent(), helpers, outputs) != rules) {
+      problems += " " + production.GetParent() + " derives other rules";
+    }
+  }
+  return problems;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  jucc::utils::ThreadPool pool(3);
+  size_t added = 0;
+  auto check = [&](unsigned /*seed*/, std::mt19937 &random) {
+    Productions input = GenerateGrammar(random);
+
+    Productions factored = GrammarTransform::ApplyLeftFactoring(input);
+    added += factored.size() - input.size();
+    std::string problems = Check(input, factored);
+    if (ProductionsText(GrammarTransform::ApplyLeftFactoring(input, &pool)) != ProductionsText(factored)) {
+      problems += " differs on a thread pool";
+    }
+    if (!problems.empty()) {
+      problems = " ApplyLeftFactoring:" + problems;
+    }
+
+    // one production at a time, as RemoveAllPossibleAmbiguity uses it
+    for (const auto &production : input) {
+      std::string removed = Check({production}, jucc::utils::RemoveLeftFactors(production));
+      if (!removed.empty()) {
+        problems += " RemoveLeftFactors:" + removed;
+      }
+    }
+    return problems.empty() ? problems : problems + "\n" + ProductionsText(input);
+  };
+  return jucc::test::RunSeeds(argc, argv, 3000, check,
+                              [&] { return std::to_string(added) + " non terminals added"; });
+}
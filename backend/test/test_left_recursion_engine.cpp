@@ -0,0 +1,120 @@
+// Checks grammar::LeftRecursionEngine against the loop GrammarTransform used
+// before it: on random grammars both must give the same productions, the
+// output must have no left recursive component left, and Replace must give
+// what Run gives on the edited grammar.
+//
+// Arguments and output as described in test_harness.h.
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "grammar/grammar_transform.h"
+#include "grammar/left_recursion_engine.h"
+#include "test/test_harness.h"
+#include "utils/left_recursion.h"
+
+namespace {
+
+using jucc::grammar::GrammarTransform;
+using jucc::grammar::LeftRecursionEngine;
+using jucc::grammar::Production;
+using jucc::grammar::Productions;
+using jucc::grammar::Rules;
+using jucc::test::ProductionsText;
+
+constexpr int EDITS_PER_GRAMMAR = 4;
+
+// GrammarTransform::EliminateLeftRecursion as it was before the engine: for
+// every Ai, substitute every earlier Aj its rules start with, then remove
+// the immediate left recursion of Ai
+Productions ReferenceEliminateLeftRecursion(const Productions &productions) {
+  Productions result = productions;
+  for (size_t i = 0; i < result.size(); i++) {
+    for (size_t j = 0; j < i; j++) {
+      Production &current = result[i];
+      const Production &previous = result[j];
+      Rules rules;
+      for (const auto &rule : current.GetRules()) {
+        const auto &entities = rule.GetEntities();
+        if (!entities.empty() && entities[0] == previous.GetParent()) {
+          for (const auto &previous_rule : previous.GetRules()) {
+            std::vector<std::string> substituted = previous_rule.GetEntities();
+            substituted.insert(substituted.end(), entities.begin() + 1, entities.end());
+            rules.emplace_back(substituted);
+          }
+        } else {
+          rules.push_back(rule);
+        }
+      }
+      current.SetRules(rules);
+    }
+
+    auto transformed = GrammarTransform::EliminateImmediateLeftRecursion(result[i]);
+    if (transformed.size() > 1) {
+      result[i] = transformed[0];
+      result.insert(result.begin() + static_cast<std::ptrdiff_t>(i) + 1, transformed[1]);
+    }
+  }
+  return result;
+}
+
+// Leading non terminals are always followed by a terminal: the old loop
+// never finished on cycles of unit rules.
+jucc::test::RuleShape Shape() {
+  jucc::test::RuleShape shape;
+  for (int t = 0; t < 20; t++) {
+    shape.terminals.push_back("t" + std::to_string(t));
+  }
+  shape.leading_earlier = true;
+  shape.terminal_after_leading = true;
+  return shape;
+}
+
+Productions AllGroups(const LeftRecursionEngine &engine) {
+  Productions productions;
+  for (size_t group = 0; group < engine.NumGroups(); group++) {
+    Productions produced = engine.GetGroup(group);
+    productions.insert(productions.end(), produced.begin(), produced.end());
+  }
+  return productions;
+}
+
+// names of everything that is wrong with engine's output for productions, empty if nothing is
+std::string Check(const Productions &productions, const Productions &output) {
+  std::string problems;
+  if (ProductionsText(output) != ProductionsText(ReferenceEliminateLeftRecursion(productions))) {
+    problems += " differs from the reference loop";
+  }
+  if (!jucc::utils::LeftRecursiveComponents(output).empty()) {
+    problems += " left recursion left";
+  }
+  return problems;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const jucc::test::RuleShape shape = Shape();
+  size_t substitutions = 0;
+  auto check = [&](unsigned seed, std::mt19937 &random) {
+    int n = 2 + static_cast<int>(seed % 8);
+    Productions productions = jucc::test::RandomProductions(n, shape, random);
+
+    LeftRecursionEngine engine(productions);
+    std::string problems = Check(productions, engine.Run());
+    substitutions += engine.GetStats().substitutions;
+    for (int edit = 0; problems.empty() && edit < EDITS_PER_GRAMMAR; edit++) {
+      int i = static_cast<int>(random() % n);
+      productions[i].SetRules(jucc::test::RandomRules(i, n, shape, random));
+      engine.Replace(productions[i].GetParent(), productions[i].GetRules());
+      problems = Check(productions, AllGroups(engine));
+      if (!problems.empty()) {
+        problems = " after edit " + std::to_string(edit) + " of N" + std::to_string(i) + ":" + problems;
+      }
+    }
+    return problems.empty() ? problems : problems + "\n" + ProductionsText(productions);
+  };
+  return jucc::test::RunSeeds(argc, argv, 3000, check,
+                              [&] { return std::to_string(substitutions) + " substitutions"; });
+}
@@ -0,0 +1,69 @@
+// Checks which cells parser::ParsingTable::BuildTable fills for the
+// expression grammar once the transforms have run: the epsilon rules of
+// E_prime and T_prime own the cells of FOLLOW, ")" and "$", and are not
+// left as synch entries the driver would recover through.
+//
+//   test_parsing_table
+//
+// Exits with 1 if a cell holds something else, printing the cell.
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "pipeline/pipeline.h"
+
+namespace {
+
+constexpr char EXPRESSION_GRAMMAR[] = R"(%terminals
++ * ( ) id
+%end
+%non_terminals
+E T F
+%end
+%start
+E
+%end
+%rules
+E : E + T
+E : T
+T : T * F
+T : F
+F : ( E )
+F : id
+%end
+)";
+
+}  // namespace
+
+int main() {
+  std::istringstream text(EXPRESSION_GRAMMAR);
+  jucc::pipeline::Pipeline pipeline;
+  if (!pipeline.LoadGrammar(text) || !pipeline.BuildTable()) {
+    std::fprintf(stderr, "pipeline: %s\n", pipeline.GetError().c_str());
+    return 1;
+  }
+  if (!pipeline.GetConflicts().empty()) {
+    std::fprintf(stderr, "conflict: %s\n", pipeline.GetConflicts()[0].c_str());
+    return 1;
+  }
+
+  const auto &productions = pipeline.GetProductions();
+  const auto &table = pipeline.GetTable().GetTable();
+  int failures = 0;
+  for (const char *parent : {"E_prime", "T_prime"}) {
+    for (const char *terminal : {")", "$"}) {
+      auto [production, rule] = table.at(parent).at(terminal);
+      bool epsilon = production >= 0 && productions[production].GetParent() == parent &&
+                     productions[production].GetRules()[rule].GetEntities() ==
+                         std::vector<std::string>{jucc::grammar::EPSILON};
+      if (!epsilon) {
+        std::fprintf(stderr, "%s on %s holds (%d, %d), not its EPSILON rule\n", parent, terminal, production, rule);
+        failures++;
+      }
+    }
+  }
+
+  std::fprintf(stderr, "%d failures\n", failures);
+  return failures == 0 ? 0 : 1;
+}
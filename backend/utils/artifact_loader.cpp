@@ -0,0 +1,198 @@
+#include "utils/artifact_loader.h"
+
+#include <stdexcept>
+
+#include "utils/json_reader.h"
+
+namespace jucc::utils {
+
+namespace {
+
+void ReadStringArray(JsonReader &reader, std::vector<std::string> &out) {
+  out.clear();
+  reader.BeginArray();
+  while (reader.NextElement()) {
+    out.emplace_back();
+    reader.ReadString(out.back());
+  }
+}
+
+/**
+ * Reads { "A": ["x", "y"], ... } into map.
+ */
+void ReadSymbolsMap(JsonReader &reader, SymbolsMap &map, std::string &key) {
+  reader.BeginObject();
+  while (reader.NextKey(key)) {
+    ReadStringArray(reader, map[key]);
+  }
+}
+
+}  // namespace
+
+GrammarArtifact ArtifactLoader::LoadGrammar(std::istream &in, bool epsilon_as_empty) {
+  GrammarArtifact artifact;
+  JsonReader reader(in);
+  std::string key;
+  std::string parent;
+  std::vector<std::string> entities;
+
+  reader.BeginObject();
+  while (reader.NextKey(key)) {
+    if (key == "terminals") {
+      ReadStringArray(reader, artifact.terminals);
+    } else if (key == "non_terminals") {
+      ReadStringArray(reader, artifact.non_terminals);
+    } else if (key == "start_symbol") {
+      reader.ReadString(artifact.start_symbol);
+    } else if (key == "productions") {
+      reader.BeginArray();
+      while (reader.NextElement()) {
+        grammar::Rules rules;
+        parent.clear();
+        reader.BeginObject();
+        while (reader.NextKey(key)) {
+          if (key == "parent") {
+            reader.ReadString(parent);
+          } else if (key == "rules") {
+            reader.BeginArray();
+            while (reader.NextElement()) {
+              ReadStringArray(reader, entities);
+              if (epsilon_as_empty && entities.size() == 1 && entities[0] == grammar::EPSILON) {
+                entities.clear();
+              }
+              rules.emplace_back(std::move(entities));
+            }
+          } else {
+            reader.Skip();
+          }
+        }
+        artifact.productions.emplace_back(parent, std::move(rules));
+      }
+    } else if (key == "helpers") {
+      ReadStringArray(reader, artifact.generated.helpers);
+    } else if (key == "loops") {
+      ReadStringArray(reader, artifact.generated.loops);
+    } else {
+      reader.Skip();
+    }
+  }
+  reader.ExpectEnd();
+  return artifact;
+}
+
+void ArtifactLoader::LoadFirstFollow(std::istream &in, SymbolsMap &firsts, SymbolsMap &follows) {
+  JsonReader reader(in);
+  std::string key;
+  std::string symbol;
+
+  reader.BeginObject();
+  while (reader.NextKey(key)) {
+    if (key == "first") {
+      ReadSymbolsMap(reader, firsts, symbol);
+    } else if (key == "follow") {
+      ReadSymbolsMap(reader, follows, symbol);
+    } else {
+      reader.Skip();
+    }
+  }
+  reader.ExpectEnd();
+}
+
+TableCells ArtifactLoader::LoadParsingTable(std::istream &in) {
+  TableCells table;
+  JsonReader reader(in);
+  std::string key;
+  std::string terminal;
+  std::string value;
+  std::vector<std::string> terminals;
+  bool first = true;
+  bool sparse = false;
+
+  reader.BeginObject();
+  while (reader.NextKey(key)) {
+    // the sparse format announces itself with its first member
+    if (first && key == "format" && reader.PeekType() == JsonReader::Type::STRING) {
+      reader.ReadString(value);
+      if (value != "sparse") {
+        throw std::runtime_error("parsing table error: unknown format \"" + value + "\"");
+      }
+      sparse = true;
+      first = false;
+      continue;
+    }
+    first = false;
+
+    if (!sparse) {
+      // dense: { "E": { "id": "301", "+": "error", ... }, ... }
+      auto &row = table[key];
+      reader.BeginObject();
+      while (reader.NextKey(terminal)) {
+        reader.ReadString(value);
+        row[terminal] = DecodeTableValue(value);
+      }
+    } else if (key == "terminals") {
+      ReadStringArray(reader, terminals);
+    } else if (key == "rows") {
+      reader.BeginObject();
+      while (reader.NextKey(key)) {
+        auto &row = table[key];
+        reader.BeginObject();
+        while (reader.NextKey(value)) {
+          if (value == "cells") {
+            reader.BeginObject();
+            while (reader.NextKey(terminal)) {
+              int64_t cell = reader.ReadInt();
+              if (cell < 0) {
+                throw std::runtime_error("parsing table error: bad entry for " + key + ", " + terminal);
+              }
+              row[terminal] = {static_cast<int>(cell / 100), static_cast<int>(cell % 100)};
+            }
+          } else if (value == "synch") {
+            reader.BeginArray();
+            while (reader.NextElement()) {
+              reader.ReadString(terminal);
+              row[terminal] = {-2, -2};
+            }
+          } else {
+            reader.Skip();
+          }
+        }
+      }
+    } else {
+      reader.Skip();
+    }
+  }
+  reader.ExpectEnd();
+
+  // cells left out of the sparse format are errors
+  if (sparse) {
+    for (auto &row : table) {
+      for (const auto &t : terminals) {
+        row.second.emplace(t, std::make_pair(-1, -1));
+      }
+    }
+  }
+  return table;
+}
+
+std::pair<int, int> ArtifactLoader::DecodeTableValue(const std::string &value) {
+  if (value == "error") {
+    return {-1, -1};
+  }
+  if (value == "synch") {
+    return {-2, -2};
+  }
+  if (value.empty()) {
+    throw std::runtime_error("parsing table error: empty entry");
+  }
+  int key = 0;
+  for (char c : value) {
+    if (c < '0' || c > '9') {
+      throw std::runtime_error("parsing table error: bad entry \"" + value + "\"");
+    }
+    key = key * 10 + (c - '0');
+  }
+  return {key / 100, key % 100};
+}
+
+}  // namespace jucc::utils
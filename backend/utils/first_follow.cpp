@@ -3,71 +3,62 @@
 #include <functional>
 #include <algorithm>
 
+#include "utils/json_emitter.h"
+#include "utils/output_buffer.h"
 #include "utils/utils.h"
 
 namespace jucc::utils {
-std::unordered_map<std::string, bool> CalcNullables(const grammar::Productions &augmented_grammar) {
+std::unordered_map<std::string, bool> CalcNullables(const grammar::Productions &augmented_grammar,
+                                                    const std::unordered_map<std::string, bool> *known) {
   std::unordered_map<std::string, bool> nullables;
   // set all terminals to non - nullable
   auto terminals = GetAllTerminals(augmented_grammar);
   for (const auto &term : terminals) {
     nullables[term] = false;
   }
+  if (known != nullptr) {
+    for (const auto &[symbol, nullable] : *known) {
+      nullables[symbol] = nullable;
+    }
+  }
 
   // EPSILON is nullable by definition
   nullables[std::string(grammar::EPSILON)] = true;
 
-  // recursively compute for all non terminals
-  std::function<bool(const std::string &, std::vector<std::string> &)> calc_recursive;
-  // lambda function that returns boolean value
-  calc_recursive = [&](const std::string &key, std::vector<std::string> &path) {
-    if (find(path.begin(), path.end(), key) != path.end()) {
-      return false;
-    }
-
-    // marking current symbol as visited
-    path.push_back(key);
-
-    // registering non-terminal in FOLLOW map if encountered for the first time
-    if (nullables.find(key) != nullables.end()) {
-      path.pop_back();
-      return nullables[key];
-    }
+  // the rules of each non terminal, the first production of a parent wins as with GetRulesForParent
+  std::unordered_map<std::string, const grammar::Rules *> rules_of;
+  for (const auto &production : augmented_grammar) {
+    rules_of.emplace(production.GetParent(), &production.GetRules());
+    nullables.emplace(production.GetParent(), false);
+  }
 
-    for (const auto &rule : GetRulesForParent(augmented_grammar, key)) {
-      bool premature_termination = false;
-      for (const auto &symbol : rule.GetEntities()) {
-        // exit loop if non-nullable symbol is encountered
-        if (!calc_recursive(symbol, path)) {
-          premature_termination = true;
+  // least fixpoint: for production A -> X Y Z, A is nullable iff X, Y, Z all are nullable.
+  // Sweeping until nothing changes, a cycle can not leave a non terminal non-nullable
+  // that a later sweep finds a nullable rule for
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (const auto &[parent, rules] : rules_of) {
+      if (nullables[parent]) {
+        continue;
+      }
+      for (const auto &rule : *rules) {
+        const auto &symbols = rule.GetEntities();
+        if (std::all_of(symbols.begin(), symbols.end(),
+                        [&](const std::string &symbol) { return nullables[symbol]; })) {
+          nullables[parent] = true;
+          changed = true;
           break;
         }
       }
-
-      // for production A -> X Y Z, A is nullable iff X, Y, Z all are nullable
-      if (!premature_termination) {
-        nullables[key] = true;
-        path.pop_back();
-        return true;
-      }
     }
-
-    // by default, a symbol is considered non-nullable
-    nullables[key] = false;
-    path.pop_back();
-    return false;
-  };
-
-  for (const auto &production : augmented_grammar) {
-    std::vector<std::string> path;
-    calc_recursive(production.GetParent(), path);
   }
 
   return nullables;
 }
 
 SymbolsMap CalcFirsts(const grammar::Productions &augmented_grammar,
-                      const std::unordered_map<std::string, bool> &nullables) {
+                      const std::unordered_map<std::string, bool> &nullables, const SymbolsMap *known) {
   SymbolsMap firsts;
   // finished -> used to check if any new symbols are added to any FIRST(non-terminal) in a particular iteration
   // useful in case of cycles in productions
@@ -80,6 +71,12 @@ SymbolsMap CalcFirsts(const grammar::Productions &augmented_grammar,
   }
   // add base case for EPSILON
   firsts[std::string(grammar::EPSILON)] = {std::string(grammar::EPSILON)};
+  // symbols defined elsewhere are base cases as well
+  if (known != nullptr) {
+    for (const auto &[symbol, first] : *known) {
+      firsts[symbol] = first;
+    }
+  }
 
   /* at this point, map of FIRST only contains terminal -> {terminal} mappings */
   std::function<std::vector<std::string>(const std::string &, std::vector<std::string> &)> calc_recursive;
@@ -167,6 +164,11 @@ SymbolsMap CalcFirsts(const grammar::Productions &augmented_grammar,
     firsts.erase(term);
   }
   firsts.erase(std::string(grammar::EPSILON));
+  if (known != nullptr) {
+    for (const auto &entry : *known) {
+      firsts.erase(entry.first);
+    }
+  }
 
   return firsts;
 }
@@ -252,4 +254,35 @@ SymbolsMap CalcFollows(const grammar::Productions &augmented_grammar, const Symb
   return follows;
 }
 
+bool DumpFirstFollowAsJson(const std::string &filepath, const grammar::Productions &productions,
+                           const SymbolsMap &firsts, const SymbolsMap &follows, bool compact) {
+  auto out = OutputBuffer::Open(filepath);
+  if (out.Failed()) {
+    return false;
+  }
+  JsonEmitter json(out, compact);
+  json.BeginObject();
+  for (const auto *sets : {&firsts, &follows}) {
+    json.Key(sets == &firsts ? "first" : "follow");
+    json.BeginObject();
+    for (const auto &prod : productions) {
+      const auto &nt = prod.GetParent();
+      json.Key(nt);
+      json.BeginArray(true);
+      auto it = sets->find(nt);
+      if (it != sets->end()) {
+        for (const auto &term : it->second) {
+          json.String(term);
+        }
+      }
+      json.EndArray();
+    }
+    json.EndObject();
+  }
+  json.EndObject();
+  json.Finish();
+  out.Flush();
+  return !out.Failed();
+}
+
 }  // namespace jucc::utils
@@ -0,0 +1,208 @@
+#include "utils/json_emitter.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define JUCC_JSON_SSE2 1
+#endif
+
+namespace jucc::utils {
+
+namespace {
+
+bool NeedsEscape(unsigned char c) { return c < 0x20 || c == '"' || c == '\\'; }
+
+/**
+ * Length of the prefix of data[0, size) that needs no escaping.
+ */
+size_t PlainPrefix(const char *data, size_t size) {
+  size_t i = 0;
+#ifdef JUCC_JSON_SSE2
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1F);
+  for (; i + 16 <= size; i += 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    // unsigned c <= 0x1F is max(c, 0x1F) == 0x1F
+    __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+    auto mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+    if (mask != 0) {
+      unsigned offset = 0;
+      while ((mask & 1U) == 0) {
+        mask >>= 1;
+        offset++;
+      }
+      return i + offset;
+    }
+  }
+#else
+  // eight bytes at a time, a byte is flagged if it is a control character, " or backslash
+  constexpr uint64_t ones = 0x0101010101010101ULL;
+  constexpr uint64_t highs = 0x8080808080808080ULL;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(word));
+    uint64_t control = (word - ones * 0x20) & ~word;
+    uint64_t quote = word ^ (ones * '"');
+    uint64_t backslash = word ^ (ones * '\\');
+    uint64_t hits = (control | ((quote - ones) & ~quote) | ((backslash - ones) & ~backslash)) & highs;
+    if (hits != 0) {
+      break;
+    }
+  }
+#endif
+  while (i < size && !NeedsEscape(static_cast<unsigned char>(data[i]))) {
+    i++;
+  }
+  return i;
+}
+
+}  // namespace
+
+JsonEmitter::JsonEmitter(OutputBuffer &out, bool compact, int indentation)
+    : out_(out), compact_(compact), indentation_(indentation) {}
+
+void JsonEmitter::WriteString(OutputBuffer &out, std::string_view value) {
+  static const char hex[] = "0123456789abcdef";
+  out.Put('"');
+  const char *data = value.data();
+  size_t size = value.size();
+  while (size > 0) {
+    size_t plain = PlainPrefix(data, size);
+    out.Write(data, plain);
+    data += plain;
+    size -= plain;
+    if (size == 0) {
+      break;
+    }
+
+    auto c = static_cast<unsigned char>(*data);
+    switch (c) {
+      case '"':
+        out.Write("\\\"", 2);
+        break;
+      case '\\':
+        out.Write("\\\\", 2);
+        break;
+      case '\n':
+        out.Write("\\n", 2);
+        break;
+      case '\r':
+        out.Write("\\r", 2);
+        break;
+      case '\t':
+        out.Write("\\t", 2);
+        break;
+      case '\b':
+        out.Write("\\b", 2);
+        break;
+      case '\f':
+        out.Write("\\f", 2);
+        break;
+      default: {
+        char escaped[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+        out.Write(escaped, sizeof(escaped));
+      }
+    }
+    data++;
+    size--;
+  }
+  out.Put('"');
+}
+
+void JsonEmitter::Newline(size_t level) {
+  out_.Put('\n');
+  for (size_t i = 0; i < level * static_cast<size_t>(indentation_); i++) {
+    out_.Put(' ');
+  }
+}
+
+void JsonEmitter::BeforeValue() {
+  if (after_key_) {
+    after_key_ = false;
+    return;
+  }
+  if (scopes_.empty()) {
+    return;
+  }
+  Scope &scope = scopes_.back();
+  if (!scope.empty) {
+    out_.Put(',');
+    if (scope.single_line && !compact_) {
+      out_.Put(' ');
+    }
+  }
+  scope.empty = false;
+  if (!scope.single_line && !compact_) {
+    Newline(scopes_.size());
+  }
+}
+
+void JsonEmitter::Open(char bracket, bool single_line) {
+  BeforeValue();
+  out_.Put(bracket);
+  // everything inside a single line container stays on that line
+  single_line = single_line || (!scopes_.empty() && scopes_.back().single_line);
+  scopes_.push_back({single_line, true});
+}
+
+void JsonEmitter::Close(char bracket) {
+  Scope scope = scopes_.back();
+  scopes_.pop_back();
+  if (!scope.empty && !scope.single_line && !compact_) {
+    Newline(scopes_.size());
+  }
+  out_.Put(bracket);
+}
+
+void JsonEmitter::Key(std::string_view key) {
+  BeforeValue();
+  WriteString(out_, key);
+  out_.Put(':');
+  if (!compact_) {
+    out_.Put(' ');
+  }
+  after_key_ = true;
+}
+
+void JsonEmitter::String(std::string_view value) {
+  BeforeValue();
+  WriteString(out_, value);
+}
+
+void JsonEmitter::Int(int64_t value) {
+  BeforeValue();
+  char digits[24];
+  size_t length = 0;
+  auto magnitude = static_cast<uint64_t>(value);
+  if (value < 0) {
+    magnitude = ~magnitude + 1;
+  }
+  do {
+    digits[sizeof(digits) - 1 - length++] = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+  if (value < 0) {
+    digits[sizeof(digits) - 1 - length++] = '-';
+  }
+  out_.Write(digits + sizeof(digits) - length, length);
+}
+
+void JsonEmitter::Bool(bool value) {
+  BeforeValue();
+  out_.Write(value ? "true" : "false");
+}
+
+void JsonEmitter::Null() {
+  BeforeValue();
+  out_.Write("null");
+}
+
+void JsonEmitter::Raw(std::string_view value) {
+  BeforeValue();
+  out_.Write(value);
+}
+
+}  // namespace jucc::utils
@@ -0,0 +1,294 @@
+#include "utils/json_reader.h"
+
+#include <stdexcept>
+
+namespace jucc::utils {
+
+namespace {
+
+bool IsSpace(int c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+bool IsDelimiter(int c) { return c < 0 || IsSpace(c) || c == ',' || c == '}' || c == ']' || c == ':'; }
+
+void AppendUtf8(std::string &out, uint32_t code) {
+  if (code < 0x80) {
+    out.push_back(static_cast<char>(code));
+  } else if (code < 0x800) {
+    out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+  } else if (code < 0x10000) {
+    out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+  } else {
+    out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+  }
+}
+
+}  // namespace
+
+JsonReader::JsonReader(std::istream &in, size_t capacity) : in_(in), buffer_(capacity == 0 ? 1 : capacity) {}
+
+bool JsonReader::Fill() {
+  consumed_ += end_;
+  pos_ = 0;
+  end_ = 0;
+  in_.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+  end_ = static_cast<size_t>(in_.gcount());
+  return end_ != 0;
+}
+
+int JsonReader::Peek() {
+  while (true) {
+    while (pos_ < end_ && IsSpace(buffer_[pos_])) {
+      pos_++;
+    }
+    if (pos_ < end_) {
+      return static_cast<unsigned char>(buffer_[pos_]);
+    }
+    if (!Fill()) {
+      return -1;
+    }
+  }
+}
+
+int JsonReader::Get() {
+  int c = Peek();
+  if (c >= 0) {
+    pos_++;
+  }
+  return c;
+}
+
+void JsonReader::Expect(char c) {
+  if (Get() != c) {
+    Fail(std::string("expected '") + c + "'");
+  }
+}
+
+void JsonReader::Fail(const std::string &what) const {
+  throw std::runtime_error("json error at byte " + std::to_string(consumed_ + pos_) + ": " + what);
+}
+
+JsonReader::Type JsonReader::PeekType() {
+  int c = Peek();
+  switch (c) {
+    case -1:
+      return Type::END;
+    case '{':
+      return Type::OBJECT;
+    case '[':
+      return Type::ARRAY;
+    case '"':
+      return Type::STRING;
+    case '-':
+      return Type::NUMBER;
+    default:
+      return c >= '0' && c <= '9' ? Type::NUMBER : Type::LITERAL;
+  }
+}
+
+void JsonReader::BeginObject() {
+  Expect('{');
+  first_.push_back(true);
+}
+
+void JsonReader::BeginArray() {
+  Expect('[');
+  first_.push_back(true);
+}
+
+bool JsonReader::NextMember(char close) {
+  if (first_.empty()) {
+    Fail("no open object or array");
+  }
+  int c = Peek();
+  if (c == close) {
+    pos_++;
+    first_.pop_back();
+    return false;
+  }
+  if (!first_.back()) {
+    if (c != ',') {
+      Fail(std::string("expected ',' or '") + close + "'");
+    }
+    pos_++;
+  }
+  first_.back() = false;
+  return true;
+}
+
+bool JsonReader::NextKey(std::string &key) {
+  if (!NextMember('}')) {
+    return false;
+  }
+  ReadString(key);
+  Expect(':');
+  return true;
+}
+
+bool JsonReader::NextElement() { return NextMember(']'); }
+
+void JsonReader::ReadString(std::string &out) {
+  Expect('"');
+  out.clear();
+  while (true) {
+    if (pos_ == end_ && !Fill()) {
+      Fail("unterminated string");
+    }
+    // copy the run up to the next quote or escape in one go
+    const char *begin = buffer_.data() + pos_;
+    size_t length = end_ - pos_;
+    size_t run = 0;
+    while (run < length && begin[run] != '"' && begin[run] != '\\') {
+      run++;
+    }
+    out.append(begin, run);
+    pos_ += run;
+    if (pos_ == end_) {
+      continue;
+    }
+    if (buffer_[pos_++] == '"') {
+      return;
+    }
+    AppendEscape(out);
+  }
+}
+
+void JsonReader::AppendEscape(std::string &out) {
+  auto next = [this]() {
+    if (pos_ == end_ && !Fill()) {
+      Fail("unterminated escape");
+    }
+    return buffer_[pos_++];
+  };
+  auto hex4 = [&]() {
+    uint32_t code = 0;
+    for (int i = 0; i < 4; i++) {
+      char c = next();
+      code <<= 4;
+      if (c >= '0' && c <= '9') {
+        code |= static_cast<uint32_t>(c - '0');
+      } else if (c >= 'a' && c <= 'f') {
+        code |= static_cast<uint32_t>(c - 'a' + 10);
+      } else if (c >= 'A' && c <= 'F') {
+        code |= static_cast<uint32_t>(c - 'A' + 10);
+      } else {
+        Fail("bad \\u escape");
+      }
+    }
+    return code;
+  };
+
+  char c = next();
+  switch (c) {
+    case '"':
+    case '\\':
+    case '/':
+      out.push_back(c);
+      break;
+    case 'b':
+      out.push_back('\b');
+      break;
+    case 'f':
+      out.push_back('\f');
+      break;
+    case 'n':
+      out.push_back('\n');
+      break;
+    case 'r':
+      out.push_back('\r');
+      break;
+    case 't':
+      out.push_back('\t');
+      break;
+    case 'u': {
+      uint32_t code = hex4();
+      if (code >= 0xD800 && code < 0xDC00) {
+        // surrogate pair
+        if (next() != '\\' || next() != 'u') {
+          Fail("unpaired surrogate");
+        }
+        uint32_t low = hex4();
+        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+      }
+      AppendUtf8(out, code);
+      break;
+    }
+    default:
+      Fail(std::string("bad escape \\") + c);
+  }
+}
+
+int64_t JsonReader::ReadInt() {
+  Peek();
+  bool negative = false;
+  if (pos_ < end_ && buffer_[pos_] == '-') {
+    negative = true;
+    pos_++;
+  }
+  int64_t value = 0;
+  size_t digits = 0;
+  while (true) {
+    if (pos_ == end_ && !Fill()) {
+      break;
+    }
+    char c = buffer_[pos_];
+    if (c < '0' || c > '9') {
+      break;
+    }
+    value = value * 10 + (c - '0');
+    digits++;
+    pos_++;
+  }
+  if (digits == 0) {
+    Fail("expected an integer");
+  }
+  return negative ? -value : value;
+}
+
+void JsonReader::Skip() {
+  switch (PeekType()) {
+    case Type::OBJECT:
+      BeginObject();
+      while (NextKey(scratch_)) {
+        Skip();
+      }
+      break;
+    case Type::ARRAY:
+      BeginArray();
+      while (NextElement()) {
+        Skip();
+      }
+      break;
+    case Type::STRING:
+      ReadString(scratch_);
+      break;
+    case Type::NUMBER:
+    case Type::LITERAL:
+      // numbers with fractions or exponents, true, false, null
+      while (true) {
+        if (pos_ == end_ && !Fill()) {
+          break;
+        }
+        if (IsDelimiter(static_cast<unsigned char>(buffer_[pos_]))) {
+          break;
+        }
+        pos_++;
+      }
+      break;
+    case Type::END:
+      Fail("unexpected end of input");
+  }
+}
+
+void JsonReader::ExpectEnd() {
+  if (Peek() != -1) {
+    Fail("trailing characters");
+  }
+}
+
+}  // namespace jucc::utils
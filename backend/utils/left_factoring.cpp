@@ -7,59 +7,74 @@
 
 namespace jucc::utils {
 
-grammar::Productions RemoveLeftFactors(const grammar::Production &prod) {
-  grammar::Productions prods;
+namespace {
 
-  bool state_not_updated = false;
-  auto current_prod = prod;
-  while (!state_not_updated) {
-    auto max_common_prefix = utils::LongestCommonPrefix(current_prod).GetEntities();
-    if (max_common_prefix.empty()) {
-      state_not_updated = true;
+/**
+ * Appends to rules one rule per child of node: a chain of single children
+ * with no rule ending on it collapses into one rule, a node where rules
+ * branch or end gets a new non terminal whose production is reserved in
+ * out before its own children are visited.
+ */
+void FactorNode(const TrieManager &trie, uint32_t node, grammar::Rules &rules, grammar::Productions &out,
+                const std::function<std::string()> &new_name) {
+  for (uint32_t child = trie.GetNode(node).first_child_; child != TrieManager::NO_NODE;
+       child = trie.GetNode(child).next_sibling_) {
+    std::vector<std::string> entities{trie.GetEntity(child)};
+    uint32_t end = child;
+    // a node no rule ends on always has a child
+    while (trie.GetNode(end).ends_ == 0 && trie.GetNode(end).first_child_ == trie.GetNode(end).last_child_) {
+      end = trie.GetNode(end).first_child_;
+      entities.push_back(trie.GetEntity(end));
+    }
+    const Trie &last = trie.GetNode(end);
+    if (last.first_child_ == TrieManager::NO_NODE) {
+      rules.emplace_back(entities);
       continue;
     }
 
-    auto parent = current_prod.GetParent();                                  // similar to E
-    auto parent_dash = current_prod.GetParent() + std::string(utils::DASH);  // similar to E'
-
-    grammar::Rules parent_rules;
-    grammar::Rules parent_dash_rules;
+    std::string name = new_name();
+    entities.push_back(name);
+    rules.emplace_back(entities);
+    size_t slot = out.size();
+    out.emplace_back();
+    grammar::Rules nested;
+    FactorNode(trie, end, nested, out, new_name);
+    if (last.ends_ > 0) {
+      nested.emplace_back(grammar::Rule({std::string(grammar::EPSILON)}));
+    }
+    out[slot] = grammar::Production(name, nested);
+  }
+}
 
-    // insert the commonE' prod
-    std::vector<std::string> common_factor_with_dash(max_common_prefix.begin(), max_common_prefix.end());
-    // push E' after the common part
-    common_factor_with_dash.emplace_back(parent_dash);
-    parent_rules.emplace_back(grammar::Rule(common_factor_with_dash));
+}  // namespace
 
-    // produce two production after matching
-    for (const auto &rule : current_prod.GetRules()) {
-      if (!rule.HasPrefix(grammar::Rule(max_common_prefix))) {
-        parent_rules.emplace_back(rule);
-      } else {
-        auto new_entities = std::vector<std::string>(
-            rule.GetEntities().begin() + static_cast<int>(max_common_prefix.size()), rule.GetEntities().end());
-        if (new_entities.empty()) {
-          new_entities.emplace_back(std::string(grammar::EPSILON));
-        }
-        parent_dash_rules.emplace_back(new_entities);
-      }
-    }
+grammar::Productions FactorPrefixes(const grammar::Production &prod, const std::function<std::string()> &new_name) {
+  TrieManager trie_manager;
+  trie_manager.InsertAll(prod);
 
-    // do this recursive
-    prods.push_back(grammar::Production(parent, parent_rules));
-    current_prod = grammar::Production(parent_dash, parent_dash_rules);
+  grammar::Productions prods(1);
+  grammar::Rules rules;
+  FactorNode(trie_manager, TrieManager::ROOT, rules, prods, new_name);
+  if (trie_manager.GetNode(TrieManager::ROOT).ends_ > 0) {
+    rules.emplace_back(grammar::Rule({std::string(grammar::EPSILON)}));
   }
-  prods.push_back(current_prod);
+  prods[0] = grammar::Production(prod.GetParent(), rules);
   return prods;
 }
 
+grammar::Productions RemoveLeftFactors(const grammar::Production &prod) {
+  // E', E'' and so on, in the order they are created
+  std::string name = prod.GetParent();
+  return FactorPrefixes(prod, [&]() { return name += std::string(utils::DASH); });
+}
+
 grammar::Rule LongestCommonPrefix(const grammar::Production &prod) {
   TrieManager trie_manager;
   trie_manager.InsertAll(prod);
 
   grammar::Rule common_prefixes;
   int len = 1;
-  TrieManager::GreedyPreorder(trie_manager.GetMaster(), len, common_prefixes, true);
+  trie_manager.GreedyPreorder(TrieManager::ROOT, len, common_prefixes, true);
 
   return common_prefixes;
 }
@@ -1,8 +1,248 @@
 #include "utils/left_recursion.h"
 
 #include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "utils/thread_pool.h"
+
 namespace jucc::utils {
 
+namespace {
+
+// a rule's left corner, as far as IsRecursive is concerned
+const std::string *LeftCorner(const grammar::Rule &rule) {
+  const auto &entities = rule.GetEntities();
+  return entities.empty() ? nullptr : &entities[0];
+}
+
+}  // namespace
+
+std::vector<std::vector<size_t>> LeftRecursiveComponents(const grammar::Productions &prods) {
+  std::unordered_map<std::string, size_t> index;
+  for (size_t i = 0; i < prods.size(); i++) {
+    index.emplace(prods[i].GetParent(), i);
+  }
+  std::vector<std::vector<size_t>> edges(prods.size());
+  std::vector<bool> self_loop(prods.size(), false);
+  for (size_t i = 0; i < prods.size(); i++) {
+    for (const auto &rule : prods[i].GetRules()) {
+      const std::string *corner = LeftCorner(rule);
+      auto it = corner != nullptr ? index.find(*corner) : index.end();
+      if (it == index.end()) {
+        continue;
+      }
+      if (it->second == i) {
+        self_loop[i] = true;
+      }
+      edges[i].push_back(it->second);
+    }
+  }
+
+  // iterative Tarjan, grammars can chain further than the stack goes
+  const size_t unvisited = prods.size();
+  std::vector<size_t> order(prods.size(), unvisited);
+  std::vector<size_t> low(prods.size(), 0);
+  std::vector<bool> on_stack(prods.size(), false);
+  std::vector<size_t> stack;
+  std::vector<std::pair<size_t, size_t>> frames;  // node, next edge
+  std::vector<std::vector<size_t>> components;
+  size_t counter = 0;
+
+  for (size_t root = 0; root < prods.size(); root++) {
+    if (order[root] != unvisited) {
+      continue;
+    }
+    frames.emplace_back(root, 0);
+    while (!frames.empty()) {
+      auto &[node, next] = frames.back();
+      if (next == 0 && order[node] == unvisited) {
+        order[node] = low[node] = counter++;
+        stack.push_back(node);
+        on_stack[node] = true;
+      }
+      if (next < edges[node].size()) {
+        size_t to = edges[node][next++];
+        if (order[to] == unvisited) {
+          frames.emplace_back(to, 0);
+        } else if (on_stack[to]) {
+          low[node] = std::min(low[node], order[to]);
+        }
+        continue;
+      }
+
+      size_t done = node;
+      frames.pop_back();
+      if (!frames.empty()) {
+        size_t parent = frames.back().first;
+        low[parent] = std::min(low[parent], low[done]);
+      }
+      if (low[done] != order[done]) {
+        continue;
+      }
+      std::vector<size_t> component;
+      size_t member;
+      do {
+        member = stack.back();
+        stack.pop_back();
+        on_stack[member] = false;
+        component.push_back(member);
+      } while (member != done);
+      if (component.size() > 1 || self_loop[done]) {
+        std::sort(component.begin(), component.end());
+        components.push_back(std::move(component));
+      }
+    }
+  }
+
+  std::sort(components.begin(), components.end());
+  return components;
+}
+
+namespace {
+
+/**
+ * Paull's algorithm over the members of one component, in the given order.
+ * A rule of the i-th member starting with an earlier member gets that
+ * member's finished rules substituted for its left corner; left corners
+ * outside the component are never expanded.
+ * @return the rewritten productions of every member, in the given order.
+ */
+std::vector<grammar::Productions> EliminateInOrder(const grammar::Productions &prods,
+                                                   const std::vector<size_t> &members, size_t &substitutions) {
+  std::vector<grammar::Productions> rewritten;
+  std::unordered_map<std::string, const grammar::Rules *> finished;
+  rewritten.reserve(members.size());
+  for (size_t member : members) {
+    grammar::Rules rules = prods[member].GetRules();
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      grammar::Rules next;
+      for (const auto &rule : rules) {
+        const std::string *corner = LeftCorner(rule);
+        auto it = corner != nullptr ? finished.find(*corner) : finished.end();
+        if (it == finished.end()) {
+          next.push_back(rule);
+          continue;
+        }
+        substitutions++;
+        changed = true;
+        const auto &entities = rule.GetEntities();
+        for (const auto &replacement : *it->second) {
+          std::vector<std::string> joined = replacement.GetEntities();
+          if (joined.size() == 1 && joined[0] == std::string(grammar::EPSILON) && entities.size() > 1) {
+            joined.clear();
+          }
+          joined.insert(joined.end(), entities.begin() + 1, entities.end());
+          next.emplace_back(joined);
+        }
+      }
+      rules = std::move(next);
+    }
+
+    grammar::Production production = prods[member];
+    production.SetRules(rules);
+    rewritten.push_back(RemoveDirectLeftRecursion(production));
+    // the parent's own production comes last, after its A'@
+    finished[prods[member].GetParent()] = &rewritten.back().back().GetRules();
+  }
+  return rewritten;
+}
+
+}  // namespace
+
+GrammarSize MeasureGrammar(const grammar::Productions &prods) {
+  GrammarSize size;
+  size.productions = prods.size();
+  for (const auto &prod : prods) {
+    size.rules += prod.GetRules().size();
+    for (const auto &rule : prod.GetRules()) {
+      size.symbols += rule.GetEntities().size();
+    }
+  }
+  return size;
+}
+
+grammar::Productions RemoveIndirectLeftRecursions(const grammar::Productions &prods, LeftRecursionReport *report,
+                                                  ThreadPool *pool) {
+  auto components = LeftRecursiveComponents(prods);
+
+  // components share no production, each is rewritten by its own task
+  struct Rewrite {
+    std::vector<size_t> order;
+    std::vector<grammar::Productions> productions;
+    size_t substitutions{0};
+  };
+  std::vector<Rewrite> rewrites(components.size());
+  auto rewrite = [&](size_t c) {
+    const auto &component = components[c];
+    // candidate orders: input order, fewest rules first, fewest rules last
+    std::vector<std::vector<size_t>> orders(3, component);
+    auto by_rules = [&](size_t a, size_t b) { return prods[a].GetRules().size() < prods[b].GetRules().size(); };
+    std::stable_sort(orders[1].begin(), orders[1].end(), by_rules);
+    std::stable_sort(orders[2].begin(), orders[2].end(), [&](size_t a, size_t b) { return by_rules(b, a); });
+
+    Rewrite &best = rewrites[c];
+    size_t best_size = 0;
+    for (size_t o = 0; o < orders.size(); o++) {
+      if (std::find(orders.begin(), orders.begin() + static_cast<std::ptrdiff_t>(o), orders[o]) !=
+          orders.begin() + static_cast<std::ptrdiff_t>(o)) {
+        continue;
+      }
+      size_t count = 0;
+      auto candidate = EliminateInOrder(prods, orders[o], count);
+      size_t size = 0;
+      for (const auto &produced : candidate) {
+        GrammarSize measured = MeasureGrammar(produced);
+        size += measured.rules + measured.symbols;
+      }
+      if (o == 0 || size < best_size) {
+        best.order = orders[o];
+        best.productions = std::move(candidate);
+        best.substitutions = count;
+        best_size = size;
+      }
+    }
+  };
+  if (pool != nullptr) {
+    pool->ParallelFor(components.size(), rewrite);
+  } else {
+    for (size_t c = 0; c < components.size(); c++) {
+      rewrite(c);
+    }
+  }
+
+  // rewritten productions of every member of a component, by index
+  std::unordered_map<size_t, grammar::Productions> replaced;
+  size_t substitutions = 0;
+  for (auto &done : rewrites) {
+    substitutions += done.substitutions;
+    for (size_t i = 0; i < done.order.size(); i++) {
+      replaced.emplace(done.order[i], std::move(done.productions[i]));
+    }
+  }
+
+  grammar::Productions result;
+  result.reserve(prods.size() + replaced.size());
+  for (size_t i = 0; i < prods.size(); i++) {
+    auto it = replaced.find(i);
+    if (it == replaced.end()) {
+      result.push_back(prods[i]);
+    } else {
+      result.insert(result.end(), it->second.begin(), it->second.end());
+    }
+  }
+
+  if (report != nullptr) {
+    report->before = MeasureGrammar(prods);
+    report->after = MeasureGrammar(result);
+    report->recursive_components = components.size();
+    report->substitutions = substitutions;
+  }
+  return result;
+}
+
 grammar::Productions RemoveDirectLeftRecursion(const grammar::Production &prod) {
   if (!IsRecursive(prod)) {
     return grammar::Productions{prod};
@@ -0,0 +1,128 @@
+#include "utils/mapped_file.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace jucc::utils {
+
+MappedFile::MappedFile(MappedFile &&other) noexcept { *this = std::move(other); }
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    Close();
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+#ifdef _WIN32
+    std::swap(file_, other.file_);
+    std::swap(mapping_, other.mapping_);
+#endif
+    error_ = std::move(other.error_);
+  }
+  return *this;
+}
+
+#ifdef _WIN32
+
+void MappedFile::Close() {
+  if (data_ != nullptr) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_ != nullptr) {
+    CloseHandle(mapping_);
+  }
+  if (file_ != nullptr) {
+    CloseHandle(file_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  mapping_ = nullptr;
+  file_ = nullptr;
+}
+
+bool MappedFile::Open(const std::string &filepath) {
+  Close();
+  HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    error_ = "mapped file error: could not open " + filepath;
+    return false;
+  }
+  file_ = file;
+
+  LARGE_INTEGER size;
+  if (GetFileSizeEx(file, &size) == 0) {
+    error_ = "mapped file error: could not stat " + filepath;
+    Close();
+    return false;
+  }
+  if (size.QuadPart == 0) {
+    // an empty file can not be mapped, it reads as zero bytes
+    return true;
+  }
+
+  mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping_ != nullptr) {
+    data_ = static_cast<const char *>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+  }
+  if (data_ == nullptr) {
+    error_ = "mapped file error: could not map " + filepath;
+    Close();
+    return false;
+  }
+  size_ = static_cast<size_t>(size.QuadPart);
+  return true;
+}
+
+#else
+
+void MappedFile::Close() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+}
+
+bool MappedFile::Open(const std::string &filepath) {
+  Close();
+  int fd = ::open(filepath.c_str(), O_RDONLY);
+  if (fd < 0) {
+    error_ = "mapped file error: could not open " + filepath;
+    return false;
+  }
+
+  struct stat st {};
+  if (fstat(fd, &st) != 0) {
+    error_ = "mapped file error: could not stat " + filepath;
+    close(fd);
+    return false;
+  }
+  if (st.st_size == 0) {
+    // an empty file can not be mapped, it reads as zero bytes
+    close(fd);
+    return true;
+  }
+
+  void *data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  // the mapping keeps its own reference to the file
+  close(fd);
+  if (data == MAP_FAILED) {
+    error_ = "mapped file error: could not map " + filepath;
+    return false;
+  }
+  data_ = static_cast<const char *>(data);
+  size_ = static_cast<size_t>(st.st_size);
+  return true;
+}
+
+#endif
+
+}  // namespace jucc::utils
@@ -0,0 +1,95 @@
+#include "utils/output_buffer.h"
+
+#include <fcntl.h>
+
+#include <cerrno>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#define JUCC_WRITE _write
+#define JUCC_CLOSE _close
+#define JUCC_OPEN_FLAGS (O_WRONLY | O_CREAT | O_TRUNC | O_BINARY)
+#else
+#include <unistd.h>
+#define JUCC_WRITE write
+#define JUCC_CLOSE close
+#define JUCC_OPEN_FLAGS (O_WRONLY | O_CREAT | O_TRUNC)
+#endif
+
+namespace jucc::utils {
+
+OutputBuffer::OutputBuffer(int fd, size_t capacity) : buffer_(capacity == 0 ? 1 : capacity), fd_(fd) {
+  failed_ = fd_ < 0;
+}
+
+OutputBuffer::OutputBuffer(std::ostream &stream, size_t capacity)
+    : buffer_(capacity == 0 ? 1 : capacity), stream_(&stream) {}
+
+OutputBuffer::OutputBuffer(OutputBuffer &&other) noexcept
+    : buffer_(std::move(other.buffer_)),
+      used_(other.used_),
+      fd_(other.fd_),
+      owns_fd_(other.owns_fd_),
+      stream_(other.stream_),
+      failed_(other.failed_) {
+  other.used_ = 0;
+  other.fd_ = -1;
+  other.owns_fd_ = false;
+  other.stream_ = nullptr;
+}
+
+OutputBuffer::~OutputBuffer() {
+  Flush();
+  if (owns_fd_ && fd_ >= 0) {
+    JUCC_CLOSE(fd_);
+  }
+}
+
+OutputBuffer OutputBuffer::Open(const std::string &filepath, size_t capacity) {
+  OutputBuffer out(::open(filepath.c_str(), JUCC_OPEN_FLAGS, 0644), capacity);
+  out.owns_fd_ = true;
+  return out;
+}
+
+void OutputBuffer::WriteAll(const char *data, size_t size) {
+  if (stream_ != nullptr) {
+    stream_->write(data, static_cast<std::streamsize>(size));
+    failed_ = failed_ || !*stream_;
+    return;
+  }
+  while (size > 0 && !failed_) {
+    auto written = JUCC_WRITE(fd_, data, static_cast<unsigned>(size));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      failed_ = true;
+      break;
+    }
+    data += written;
+    size -= static_cast<size_t>(written);
+  }
+}
+
+void OutputBuffer::Drain(const char *data, size_t size) {
+  Flush();
+  if (size < buffer_.size()) {
+    std::char_traits<char>::copy(buffer_.data(), data, size);
+    used_ = size;
+    return;
+  }
+  // payloads larger than the buffer skip it
+  WriteAll(data, size);
+}
+
+void OutputBuffer::Flush() {
+  if (used_ == 0) {
+    return;
+  }
+  size_t size = used_;
+  used_ = 0;
+  WriteAll(buffer_.data(), size);
+}
+
+}  // namespace jucc::utils
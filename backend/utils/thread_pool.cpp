@@ -0,0 +1,128 @@
+#include "utils/thread_pool.h"
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <utility>
+
+namespace jucc::utils {
+
+ThreadPool::ThreadPool(size_t num_threads) {
+  if (num_threads == 0) {
+    num_threads = std::thread::hardware_concurrency();
+  }
+  if (num_threads == 0) {
+    num_threads = 1;
+  }
+  workers_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; i++) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  task_ready_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  task_ready_.notify_one();
+}
+
+void ThreadPool::Wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this]() { return tasks_.empty() && running_ == 0; });
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)> &body) {
+  if (count == 0) {
+    return;
+  }
+
+  // shared with the helper tasks, which may start after this call returned
+  struct Loop {
+    std::function<void(size_t)> body;
+    std::mutex mutex;
+    std::condition_variable finished;
+    size_t next{0};
+    size_t done{0};
+    size_t count{0};
+    std::exception_ptr error;  // first exception thrown by body
+  };
+  auto loop = std::make_shared<Loop>();
+  loop->body = body;
+  loop->count = count;
+
+  auto work = [loop]() {
+    std::unique_lock<std::mutex> lock(loop->mutex);
+    while (loop->next < loop->count) {
+      size_t index = loop->next++;
+      lock.unlock();
+      std::exception_ptr error;
+      try {
+        loop->body(index);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      if (error) {
+        // the indices nobody took yet are given up
+        if (!loop->error) {
+          loop->error = error;
+        }
+        loop->done += loop->count - loop->next;
+        loop->next = loop->count;
+      }
+      if (++loop->done == loop->count) {
+        loop->finished.notify_all();
+      }
+    }
+  };
+
+  size_t helpers = std::min(workers_.size(), count - 1);
+  for (size_t i = 0; i < helpers; i++) {
+    Submit(work);
+  }
+  work();
+
+  std::unique_lock<std::mutex> lock(loop->mutex);
+  loop->finished.wait(lock, [&loop]() { return loop->done == loop->count; });
+  // a helper starting from now on finds no index left and never calls body
+  loop->body = nullptr;
+  if (loop->error) {
+    std::rethrow_exception(loop->error);
+  }
+}
+
+void ThreadPool::WorkerLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    task_ready_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+    if (tasks_.empty()) {
+      // stopping and nothing left to run
+      return;
+    }
+    std::function<void()> task = std::move(tasks_.front());
+    tasks_.pop_front();
+    running_++;
+    lock.unlock();
+    task();
+    lock.lock();
+    running_--;
+    if (tasks_.empty() && running_ == 0) {
+      idle_.notify_all();
+    }
+  }
+}
+
+}  // namespace jucc::utils
@@ -1,23 +1,95 @@
 #include "utils/trie/memory_efficient_trie.h"
 
+#include <algorithm>
+
 namespace jucc::utils {
 
-Trie::Trie() { count_ = 0; }
+namespace {
+
+constexpr size_t INITIAL_EDGE_SLOTS = 16;
+
+uint64_t EdgeKey(uint32_t parent, uint32_t symbol) {
+  return ((static_cast<uint64_t>(parent) << 32) | symbol) + 1;
+}
 
-TrieManager::TrieManager() { master_ = NewTrieNode(); }
+}  // namespace
+
+Trie::Trie(uint32_t parent, uint32_t symbol)
+    : parent_(parent),
+      symbol_(symbol),
+      first_child_(TrieManager::NO_NODE),
+      last_child_(TrieManager::NO_NODE),
+      next_sibling_(TrieManager::NO_NODE),
+      count_(0),
+      ends_(0) {}
+
+TrieManager::TrieManager() : edge_keys_(INITIAL_EDGE_SLOTS, 0), edge_nodes_(INITIAL_EDGE_SLOTS, NO_NODE) {
+  nodes_.emplace_back(NO_NODE, 0);
+}
+
+uint32_t TrieManager::Intern(const std::string &entity) {
+  auto [it, inserted] = symbol_ids_.emplace(entity, static_cast<uint32_t>(symbols_.size()));
+  if (inserted) {
+    symbols_.push_back(entity);
+  }
+  return it->second;
+}
+
+size_t TrieManager::EdgeSlot(uint64_t key) const {
+  // Fibonacci hashing, the table size is a power of two
+  size_t mask = edge_keys_.size() - 1;
+  size_t slot = static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+  while (edge_keys_[slot] != 0 && edge_keys_[slot] != key) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+void TrieManager::GrowEdges() {
+  std::vector<uint64_t> keys(edge_keys_.size() * 2, 0);
+  std::vector<uint32_t> children(edge_nodes_.size() * 2, NO_NODE);
+  keys.swap(edge_keys_);
+  children.swap(edge_nodes_);
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (keys[i] != 0) {
+      size_t slot = EdgeSlot(keys[i]);
+      edge_keys_[slot] = keys[i];
+      edge_nodes_[slot] = children[i];
+    }
+  }
+}
 
 void TrieManager::Insert(const grammar::Rule &rule) {
-  auto *head = master_;
-  std::vector<std::string> till_keys;
+  uint32_t head = ROOT;
   for (const auto &entity : rule.GetEntities()) {
-    till_keys.push_back(entity);
-    if (head->nodes_.find(entity) == head->nodes_.end()) {
-      head->nodes_[entity] = NewTrieNode();
-      head->nodes_[entity]->keys_list_ = till_keys;
+    uint32_t symbol = Intern(entity);
+    uint64_t key = EdgeKey(head, symbol);
+    size_t slot = EdgeSlot(key);
+    if (edge_keys_[slot] == 0) {
+      auto child = static_cast<uint32_t>(nodes_.size());
+      nodes_.emplace_back(head, symbol);
+      Trie &parent = nodes_[head];
+      if (parent.last_child_ == NO_NODE) {
+        parent.first_child_ = child;
+      } else {
+        nodes_[parent.last_child_].next_sibling_ = child;
+      }
+      parent.last_child_ = child;
+
+      edge_keys_[slot] = key;
+      edge_nodes_[slot] = child;
+      // keep the table at most half full
+      if (++edge_count_ * 2 > edge_keys_.size()) {
+        GrowEdges();
+      }
+      head = child;
+    } else {
+      head = edge_nodes_[slot];
     }
-    head = head->nodes_[entity];
-    head->count_++;
+    nodes_[head].count_++;
   }
+  nodes_[head].ends_++;
+  inserted_symbols_ += rule.GetEntities().size();
 }
 
 void TrieManager::InsertAll(const grammar::Production &prod) {
@@ -26,38 +98,52 @@ void TrieManager::InsertAll(const grammar::Production &prod) {
   }
 }
 
-void TrieManager::GreedyPreorder(Trie *head, int &len, grammar::Rule &max_str, bool is_prime_head) {
-  if (head == nullptr) {
+std::vector<std::string> TrieManager::GetPrefix(uint32_t index) const {
+  std::vector<std::string> prefix;
+  for (uint32_t node = index; node != ROOT; node = nodes_[node].parent_) {
+    prefix.push_back(symbols_[nodes_[node].symbol_]);
+  }
+  std::reverse(prefix.begin(), prefix.end());
+  return prefix;
+}
+
+void TrieManager::GreedyPreorder(uint32_t head, int &len, grammar::Rule &max_str, bool is_prime_head) const {
+  if (head == NO_NODE) {
     return;
   }
+  const Trie &node = nodes_[head];
   bool state_changed = false;
   // Get the node with max count
-  if (head->count_ >= len && head->count_ != 1) {
-    len = head->count_;
+  if (node.count_ >= len && node.count_ != 1) {
+    len = node.count_;
     state_changed = true;
-    max_str.SetEntities(head->keys_list_);
+    max_str.SetEntities(GetPrefix(head));
   }
 
   if (state_changed || is_prime_head) {
-    for (const auto &node : head->nodes_) {
-      GreedyPreorder(node.second, len, max_str, false);
+    for (uint32_t child = node.first_child_; child != NO_NODE; child = nodes_[child].next_sibling_) {
+      GreedyPreorder(child, len, max_str, false);
     }
   }
 }
 
-Trie *TrieManager::NewTrieNode() {
-  Trie *t = new Trie;
-  this->gc_.push_back(t);
-  return t;
-}
-
-TrieManager::~TrieManager() {
-  // flushing
-  for (auto &node : gc_) {
-    delete node;
+TrieStats TrieManager::GetStats() const {
+  TrieStats stats;
+  stats.nodes = nodes_.size();
+  stats.symbols = symbols_.size();
+  stats.inserted_symbols = inserted_symbols_;
+  stats.bytes = nodes_.capacity() * sizeof(Trie) + edge_keys_.capacity() * sizeof(uint64_t) +
+                edge_nodes_.capacity() * sizeof(uint32_t) + symbols_.capacity() * sizeof(std::string);
+  for (const auto &symbol : symbols_) {
+    // long entities are on the heap twice, in symbols_ and as a key of symbol_ids_
+    if (symbol.capacity() > std::string().capacity()) {
+      stats.bytes += 2 * (symbol.capacity() + 1);
+    }
   }
+  // the symbol map: a key copy, the id and a next pointer per entry, plus buckets
+  stats.bytes += symbol_ids_.size() * (sizeof(std::string) + 2 * sizeof(void *)) +
+                 symbol_ids_.bucket_count() * sizeof(void *);
+  return stats;
 }
 
-Trie *TrieManager::GetMaster() const { return master_; }
-
 }  // namespace jucc::utils
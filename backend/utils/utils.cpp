@@ -3,16 +3,27 @@
 #include <algorithm>
 
 namespace jucc::utils {
-grammar::Productions RemoveAllPossibleAmbiguity(const grammar::Productions &prods) {
-  grammar::Productions clean;
-  for (const auto &prod : prods) {
-    for (const grammar::Production &lr_free : RemoveDirectLeftRecursion(prod)) {
-      // non ambiguous grammars
-      grammar::Productions nag = RemoveLeftFactors(lr_free);
-      clean.insert(clean.end(), nag.begin(), nag.end());
+grammar::Productions RemoveAllPossibleAmbiguity(const grammar::Productions &prods, ThreadPool *pool,
+                                                LeftRecursionReport *report) {
+  grammar::Productions lr_free = RemoveIndirectLeftRecursions(prods, report, pool);
+
+  // left factors of one production never depend on another
+  std::vector<grammar::Productions> factored(lr_free.size());
+  auto factor = [&](size_t i) { factored[i] = RemoveLeftFactors(lr_free[i]); };
+  if (pool != nullptr) {
+    pool->ParallelFor(lr_free.size(), factor);
+  } else {
+    for (size_t i = 0; i < lr_free.size(); i++) {
+      factor(i);
     }
   }
 
+  grammar::Productions clean;
+  for (const auto &nag : factored) {
+    // non ambiguous grammars
+    clean.insert(clean.end(), nag.begin(), nag.end());
+  }
+
   return clean;
 }
 
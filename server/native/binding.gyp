@@ -0,0 +1,57 @@
+{
+  "targets": [
+    {
+      "target_name": "jucc_native",
+      "sources": [
+        "jucc_addon.cpp",
+        "../../backend/pipeline/pipeline.cpp",
+        "../../backend/pipeline/compile_cache.cpp",
+        "../../backend/pipeline/incremental_compiler.cpp",
+        "../../backend/lexer/lexer.cpp",
+        "../../backend/symbol_table/symbol_table.cpp",
+        "../../backend/parser/parsing_table.cpp",
+        "../../backend/parser/compiled_grammar.cpp",
+        "../../backend/parser/grammar_file.cpp",
+        "../../backend/parser/ll_parser.cpp",
+        "../../backend/parser/parse_trace.cpp",
+        "../../backend/parser/trace_file.cpp",
+        "../../backend/parser/cst.cpp",
+        "../../backend/parser/cst_compaction.cpp",
+        "../../backend/parser/tree_writer.cpp",
+        "../../backend/parser/tree_file.cpp",
+        "../../backend/utils/artifact_loader.cpp",
+        "../../backend/utils/json_reader.cpp",
+        "../../backend/utils/json_emitter.cpp",
+        "../../backend/utils/output_buffer.cpp",
+        "../../backend/utils/mapped_file.cpp",
+        "../../backend/utils/first_follow.cpp",
+        "../../backend/utils/utils.cpp",
+        "../../backend/utils/thread_pool.cpp",
+        "../../backend/utils/left_recursion.cpp",
+        "../../backend/utils/left_factoring.cpp",
+        "../../backend/utils/trie/memory_efficient_trie.cpp",
+        "../../backend/grammar/grammar.cpp",
+        "../../backend/grammar/ebnf.cpp",
+        "../../backend/grammar/grammar_module.cpp",
+        "../../backend/grammar/grammar_transform.cpp",
+        "../../backend/grammar/grammar_reduction.cpp",
+        "../../backend/grammar/left_recursion_engine.cpp"
+      ],
+      "include_dirs": ["../../backend/include", "../../backend"],
+      "cflags_cc!": ["-fno-exceptions", "-fno-rtti"],
+      "cflags_cc": ["-std=c++17"],
+      "xcode_settings": {
+        "GCC_ENABLE_CPP_EXCEPTIONS": "YES",
+        "GCC_ENABLE_CPP_RTTI": "YES",
+        "CLANG_CXX_LANGUAGE_STANDARD": "c++17"
+      },
+      "msvs_settings": {
+        "VCCLCompilerTool": {
+          "ExceptionHandling": 1,
+          "RuntimeTypeInfo": "true",
+          "AdditionalOptions": ["/std:c++17"]
+        }
+      }
+    }
+  ]
+}
@@ -0,0 +1,105 @@
+// Loader for the in-process compiler addon (see jucc_addon.cpp for the API).
+// Exports null when the addon has not been built with `npm run build-native`,
+// callers then fall back to the executables.
+const path = require('path');
+
+let addon = null;
+try {
+  addon = require(path.join(__dirname, 'build', 'Release', 'jucc_native.node'));
+} catch (err) {
+  addon = null;
+}
+
+// Compiled grammars by import directory, grammar text and the text of the
+// modules it imports, so an unchanged grammar is compiled once and an edited
+// module is compiled again
+const MAX_GRAMMARS = 16;
+const grammars = new Map();
+
+function compileCached(text, baseDir = '') {
+  const key = baseDir + '\n' + text + addon.importedModules(text, { baseDir });
+  let grammar = grammars.get(key);
+  if (grammar) {
+    // keep the most recently used at the end
+    grammars.delete(key);
+    grammars.set(key, grammar);
+    return grammar;
+  }
+  grammar = addon.compile(text, { baseDir });
+  grammars.set(key, grammar);
+  grammar.catch(() => grammars.delete(key));
+  while (grammars.size > MAX_GRAMMARS) {
+    grammars.delete(grammars.keys().next().value);
+  }
+  return grammar;
+}
+
+// Decodes the ArrayBuffer returned by lex(source, { binary: true })
+function decodeTokens(buffer) {
+  const view = new DataView(buffer);
+  const decoder = new TextDecoder();
+  if (decoder.decode(new Uint8Array(buffer, 0, 4)) !== 'JCTK' || view.getUint32(4, true) !== 1) {
+    throw new Error('Not a token buffer');
+  }
+  const count = view.getUint32(8, true);
+  const strings = view.getUint32(12, true);
+  const text = (offset, length) => decoder.decode(new Uint8Array(buffer, strings + offset, length));
+  const tokens = new Array(count);
+  for (let i = 0, at = 16; i < count; i++, at += 24) {
+    tokens[i] = {
+      type: text(view.getUint32(at, true), view.getUint32(at + 4, true)),
+      value: text(view.getUint32(at + 8, true), view.getUint32(at + 12, true)),
+      line: view.getInt32(at + 16, true),
+      error: (view.getUint32(at + 20, true) & 1) !== 0
+    };
+  }
+  return tokens;
+}
+
+// Reads the .jst tree returned by parse(grammar, input, { tree: true });
+// node(id) gives { symbol, firstChild, nextSibling, token } with -1 for no node
+// and "EPSILON" for the leaves of epsilon rules, which have no name in the file
+function decodeTree(buffer) {
+  const view = new DataView(buffer);
+  const decoder = new TextDecoder();
+  if (decoder.decode(new Uint8Array(buffer, 0, 4)) !== 'JCST' || view.getUint32(4, true) !== 1) {
+    throw new Error('Not a tree buffer');
+  }
+  const numNodes = view.getUint32(8, true);
+  const root = view.getUint32(12, true);
+  let at = Number(view.getBigUint64(16, true));
+  const names = new Array(view.getUint32(at, true));
+  at += 4;
+  for (let i = 0; i < names.length; i++) {
+    const length = view.getUint32(at, true);
+    names[i] = decoder.decode(new Uint8Array(buffer, at + 4, length));
+    at += 4 + length;
+  }
+  const id = (value) => (value === 0xffffffff ? -1 : value);
+  const EPSILON_SYMBOL = 0xffff;
+  const symbol = (value) => (value === EPSILON_SYMBOL ? 'EPSILON' : names[value]);
+  return {
+    numNodes,
+    root: id(root),
+    names,
+    node(n) {
+      const record = 24 + n * 16;
+      return {
+        symbol: symbol(view.getUint16(record, true)),
+        firstChild: id(view.getUint32(record + 4, true)),
+        nextSibling: id(view.getUint32(record + 8, true)),
+        token: id(view.getUint32(record + 12, true))
+      };
+    }
+  };
+}
+
+module.exports = addon && {
+  compile: addon.compile,
+  compileCached,
+  importedModules: addon.importedModules,
+  lex: addon.lex,
+  parse: addon.parse,
+  decodeTokens,
+  decodeTree
+};
@@ -0,0 +1,547 @@
+#include <node_api.h>
+
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "parser/ll_parser.h"
+#include "parser/parse_trace.h"
+#include "parser/tree_file.h"
+#include "pipeline/pipeline.h"
+#include "utils/json_emitter.h"
+#include "utils/output_buffer.h"
+
+/**
+ * N-API addon running the compiler front end inside the node process.
+ *
+ *   compile(grammarText, {baseDir})         -> Promise<Grammar {conflicts, terminals, nonTerminals}>
+ *   importedModules(grammarText, {baseDir}) -> string
+ *   lex(source, {binary})                   -> Promise<[{type, value, line, error}] or ArrayBuffer>
+ *   parse(grammar, input, {trace, tree})    -> Promise<{accepted, steps, nodes, trace?, tree?}>
+ *
+ * baseDir is the directory %import paths in the grammar are relative to,
+ * the working directory of the process if not given. importedModules runs
+ * on the calling thread and returns the normalized text of every module the
+ * grammar imports (pipeline::ImportedModulesText), for keying compiles.
+ * input is a source program or an array of terminal names. The work of a
+ * call runs on the libuv thread pool; only turning the result into JS values
+ * happens on the main thread. Nothing is written to disk: trace entries come
+ * back in the parse_trace.json format, the tree as an ArrayBuffer holding a
+ * .jst file (parser/tree_file.h) and binary tokens as an ArrayBuffer laid
+ * out as (little endian):
+ *   header  : "JCTK", u32 version, u32 count, u32 strings_offset
+ *   tokens  : (u32 type_offset, u32 type_length, u32 value_offset, u32 value_length, i32 line, u32 flags)[count]
+ *   strings : bytes, offsets are relative to strings_offset
+ * flags bit 0 is the lexer error flag.
+ */
+
+namespace jucc::addon {
+
+namespace {
+
+constexpr char TOKENS_MAGIC[] = "JCTK";
+constexpr uint32_t TOKENS_VERSION = 1;
+constexpr uint32_t TOKENS_HEADER_SIZE = 4 * sizeof(uint32_t);
+constexpr uint32_t TOKEN_SIZE = 6 * sizeof(uint32_t);
+
+// returns nullptr from the calling function, leaving a JS exception pending, if call fails
+#define NAPI_CALL(env, call)   \
+  do {                         \
+    if ((call) != napi_ok) {   \
+      ThrowLastError(env);     \
+      return nullptr;          \
+    }                          \
+  } while (false)
+
+void ThrowLastError(napi_env env) {
+  const napi_extended_error_info *info = nullptr;
+  napi_get_last_error_info(env, &info);
+  const char *message = info != nullptr && info->error_message != nullptr ? info->error_message : "N-API call failed";
+  bool pending = false;
+  napi_is_exception_pending(env, &pending);
+  if (!pending) {
+    napi_throw_error(env, nullptr, message);
+  }
+}
+
+struct Grammar {
+  std::shared_ptr<const parser::LLGrammar> tables;  // shared by the parser of every parse
+  std::vector<std::string> conflicts;
+  size_t num_terminals;
+  size_t num_non_terminals;
+};
+
+using GrammarHandle = std::shared_ptr<const Grammar>;
+
+void FinalizeGrammar(napi_env /*env*/, void *data, void * /*hint*/) { delete static_cast<GrammarHandle *>(data); }
+
+template <typename T>
+void WritePod(utils::OutputBuffer &out, const T &value) {
+  out.Write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+void WriteTokens(utils::OutputBuffer &out, const std::vector<lexer::TokenInfo> &tokens) {
+  out.Write(TOKENS_MAGIC, sizeof(TOKENS_MAGIC) - 1);
+  WritePod(out, TOKENS_VERSION);
+  WritePod(out, static_cast<uint32_t>(tokens.size()));
+  WritePod(out, static_cast<uint32_t>(TOKENS_HEADER_SIZE + tokens.size() * TOKEN_SIZE));
+
+  uint32_t offset = 0;
+  for (const auto &token : tokens) {
+    WritePod(out, offset);
+    WritePod(out, static_cast<uint32_t>(token.type.size()));
+    offset += static_cast<uint32_t>(token.type.size());
+    WritePod(out, offset);
+    WritePod(out, static_cast<uint32_t>(token.value.size()));
+    offset += static_cast<uint32_t>(token.value.size());
+    WritePod(out, static_cast<int32_t>(token.line));
+    WritePod(out, static_cast<uint32_t>(token.error ? 1 : 0));
+  }
+  for (const auto &token : tokens) {
+    out.Write(token.type);
+    out.Write(token.value);
+  }
+}
+
+std::vector<lexer::TokenInfo> Tokenize(const std::string &source) {
+  std::istringstream input(source);
+  lexer::Lexer lexer;
+  while (lexer.GetToken(input) != lexer::TOK_EOF) {
+  }
+  return lexer.GetTokens();
+}
+
+napi_value ParseJson(napi_env env, const std::string &text) {
+  napi_value global;
+  napi_value json;
+  napi_value parse;
+  napi_value string;
+  napi_value result;
+  NAPI_CALL(env, napi_get_global(env, &global));
+  NAPI_CALL(env, napi_get_named_property(env, global, "JSON", &json));
+  NAPI_CALL(env, napi_get_named_property(env, json, "parse", &parse));
+  NAPI_CALL(env, napi_create_string_utf8(env, text.data(), text.size(), &string));
+  NAPI_CALL(env, napi_call_function(env, json, parse, 1, &string, &result));
+  return result;
+}
+
+napi_value CopyToArrayBuffer(napi_env env, const std::string &bytes) {
+  void *data = nullptr;
+  napi_value buffer;
+  NAPI_CALL(env, napi_create_arraybuffer(env, bytes.size(), &data, &buffer));
+  if (!bytes.empty()) {
+    std::memcpy(data, bytes.data(), bytes.size());
+  }
+  return buffer;
+}
+
+bool SetNamed(napi_env env, napi_value object, const char *name, napi_value value) {
+  return value != nullptr && napi_set_named_property(env, object, name, value) == napi_ok;
+}
+
+napi_value MakeUint(napi_env env, size_t value) {
+  napi_value result;
+  NAPI_CALL(env, napi_create_double(env, static_cast<double>(value), &result));
+  return result;
+}
+
+napi_value MakeBool(napi_env env, bool value) {
+  napi_value result;
+  NAPI_CALL(env, napi_get_boolean(env, value, &result));
+  return result;
+}
+
+/**
+ * Reads a JS string into out.
+ * @returns false if value is not a string
+ */
+bool GetString(napi_env env, napi_value value, std::string &out) {
+  size_t length = 0;
+  if (napi_get_value_string_utf8(env, value, nullptr, 0, &length) != napi_ok) {
+    return false;
+  }
+  // the copy is null terminated, leave room for it and drop it afterwards
+  out.resize(length + 1);
+  napi_get_value_string_utf8(env, value, out.data(), out.size(), &length);
+  out.resize(length);
+  return true;
+}
+
+/**
+ * @returns options[name] as a boolean, false if options is not an object
+ */
+bool GetOption(napi_env env, napi_value options, const char *name) {
+  napi_valuetype type = napi_undefined;
+  if (options == nullptr || napi_typeof(env, options, &type) != napi_ok || type != napi_object) {
+    return false;
+  }
+  napi_value value;
+  bool result = false;
+  if (napi_get_named_property(env, options, name, &value) != napi_ok ||
+      napi_coerce_to_bool(env, value, &value) != napi_ok || napi_get_value_bool(env, value, &result) != napi_ok) {
+    return false;
+  }
+  return result;
+}
+
+/**
+ * Sets out to options[name] if it is a string.
+ * @returns false if options is not an object or options[name] is not a string
+ */
+bool GetStringOption(napi_env env, napi_value options, const char *name, std::string &out) {
+  napi_valuetype type = napi_undefined;
+  if (options == nullptr || napi_typeof(env, options, &type) != napi_ok || type != napi_object) {
+    return false;
+  }
+  napi_value value;
+  if (napi_get_named_property(env, options, name, &value) != napi_ok ||
+      napi_typeof(env, value, &type) != napi_ok || type != napi_string) {
+    return false;
+  }
+  return GetString(env, value, out);
+}
+
+struct Work {
+  napi_async_work work{nullptr};
+  napi_deferred deferred{nullptr};
+  std::string error;  // rejects the promise if set by Execute
+
+  virtual ~Work() = default;
+
+  /**
+   * Runs on a libuv worker thread and must not touch JS values.
+   */
+  virtual void Execute() = 0;
+
+  /**
+   * Runs on the main thread once Execute is done.
+   * @returns the value the promise resolves to, nullptr with a pending exception on failure
+   */
+  virtual napi_value Result(napi_env /*env*/) = 0;
+};
+
+void ExecuteWork(napi_env /*env*/, void *data) {
+  auto *work = static_cast<Work *>(data);
+  try {
+    work->Execute();
+  } catch (const std::exception &e) {
+    work->error = e.what();
+  }
+}
+
+void CompleteWork(napi_env env, napi_status status, void *data) {
+  std::unique_ptr<Work> work(static_cast<Work *>(data));
+  napi_delete_async_work(env, work->work);
+
+  if (status == napi_ok && work->error.empty()) {
+    napi_value result = work->Result(env);
+    if (result != nullptr) {
+      napi_resolve_deferred(env, work->deferred, result);
+      return;
+    }
+  } else if (work->error.empty()) {
+    work->error = "cancelled";
+  }
+
+  napi_value error = nullptr;
+  bool pending = false;
+  napi_is_exception_pending(env, &pending);
+  if (pending) {
+    napi_get_and_clear_last_exception(env, &error);
+  } else {
+    napi_value message;
+    napi_create_string_utf8(env, work->error.data(), work->error.size(), &message);
+    napi_create_error(env, nullptr, message, &error);
+  }
+  napi_reject_deferred(env, work->deferred, error);
+}
+
+/**
+ * Queues work on the libuv thread pool.
+ * @returns a promise settled by CompleteWork
+ */
+napi_value Queue(napi_env env, std::unique_ptr<Work> work, const char *name) {
+  napi_value promise;
+  napi_value resource_name;
+  NAPI_CALL(env, napi_create_string_utf8(env, name, NAPI_AUTO_LENGTH, &resource_name));
+  NAPI_CALL(env, napi_create_async_work(env, nullptr, resource_name, ExecuteWork, CompleteWork, work.get(),
+                                        &work->work));
+  if (napi_create_promise(env, &work->deferred, &promise) != napi_ok ||
+      napi_queue_async_work(env, work->work) != napi_ok) {
+    ThrowLastError(env);
+    napi_delete_async_work(env, work->work);
+    return nullptr;
+  }
+  // owned by CompleteWork from here on
+  work.release();
+  return promise;
+}
+
+struct CompileWork : Work {
+  std::string text;
+  std::string base_dir;
+  GrammarHandle grammar;
+
+  void Execute() override {
+    std::istringstream input(text);
+    pipeline::Pipeline pipeline;
+    if (!pipeline.LoadGrammar(input, base_dir) || !pipeline.BuildTable()) {
+      error = pipeline.GetError();
+      return;
+    }
+    auto compiled = std::make_shared<Grammar>();
+    compiled->tables = pipeline.GetParser().GetGrammar();
+    compiled->conflicts = pipeline.GetConflicts();
+    compiled->num_terminals = pipeline.GetTerminals().size();
+    compiled->num_non_terminals = pipeline.GetNonTerminals().size();
+    grammar = std::move(compiled);
+  }
+
+  napi_value Result(napi_env env) override {
+    napi_value object;
+    NAPI_CALL(env, napi_create_object(env, &object));
+    auto *handle = new GrammarHandle(grammar);
+    if (napi_wrap(env, object, handle, FinalizeGrammar, nullptr, nullptr) != napi_ok) {
+      delete handle;
+      ThrowLastError(env);
+      return nullptr;
+    }
+
+    napi_value conflicts;
+    NAPI_CALL(env, napi_create_array_with_length(env, grammar->conflicts.size(), &conflicts));
+    for (size_t i = 0; i < grammar->conflicts.size(); i++) {
+      napi_value conflict;
+      const std::string &text = grammar->conflicts[i];
+      NAPI_CALL(env, napi_create_string_utf8(env, text.data(), text.size(), &conflict));
+      NAPI_CALL(env, napi_set_element(env, conflicts, static_cast<uint32_t>(i), conflict));
+    }
+    if (!SetNamed(env, object, "conflicts", conflicts) ||
+        !SetNamed(env, object, "terminals", MakeUint(env, grammar->num_terminals)) ||
+        !SetNamed(env, object, "nonTerminals", MakeUint(env, grammar->num_non_terminals))) {
+      ThrowLastError(env);
+      return nullptr;
+    }
+    return object;
+  }
+};
+
+struct LexWork : Work {
+  std::string source;
+  bool binary{false};
+  std::string output;  // tokens.json text, or binary tokens
+
+  void Execute() override {
+    std::vector<lexer::TokenInfo> tokens = Tokenize(source);
+    std::ostringstream bytes;
+    utils::OutputBuffer out(bytes);
+    if (binary) {
+      WriteTokens(out, tokens);
+    } else {
+      utils::JsonEmitter json(out, true);
+      json.BeginArray();
+      for (const auto &token : tokens) {
+        json.BeginObject();
+        json.Key("type");
+        json.String(token.type);
+        json.Key("value");
+        json.String(token.value);
+        json.Key("line");
+        json.Int(token.line);
+        json.Key("error");
+        json.Bool(token.error);
+        json.EndObject();
+      }
+      json.EndArray();
+    }
+    out.Flush();
+    output = bytes.str();
+  }
+
+  napi_value Result(napi_env env) override { return binary ? CopyToArrayBuffer(env, output) : ParseJson(env, output); }
+};
+
+struct ParseWork : Work {
+  GrammarHandle grammar;
+  bool has_source{false};
+  std::string source;
+  std::vector<std::string> tokens;
+  bool want_trace{false};
+  bool want_tree{false};
+
+  bool accepted{false};
+  size_t steps{0};
+  size_t nodes{0};
+  std::string trace;  // parse_trace.json text
+  std::string tree;   // .jst bytes
+
+  void Execute() override {
+    if (has_source) {
+      tokens = pipeline::TokenTerminals(Tokenize(source));
+    }
+    tokens.emplace_back(utils::STRING_ENDMARKER);
+
+    // only the trace, tree and driver stack of this parse are allocated
+    parser::LLParser parser(grammar->tables);
+    parser.SetTraceLevel(want_trace ? parser::TraceLevel::FULL : parser::TraceLevel::OFF);
+    parser.SetBuildTree(want_tree);
+    accepted = parser.Parse(tokens);
+    steps = parser.GetTraceSize();
+    nodes = parser.GetTree().Size();
+
+    if (want_trace) {
+      std::ostringstream bytes;
+      utils::OutputBuffer out(bytes);
+      utils::JsonEmitter json(out, true);
+      json.BeginArray();
+      for (size_t step = 0; step < steps; step++) {
+        parser::WriteTraceEntryJson(json, parser.GetTraceEntry(step));
+      }
+      json.EndArray();
+      out.Flush();
+      trace = bytes.str();
+    }
+    if (want_tree && !parser.GetTree().Empty()) {
+      std::ostringstream bytes;
+      utils::OutputBuffer out(bytes);
+      parser::WriteTreeFile(out, parser.GetTree(), parser.GetSymbolNames());
+      tree = bytes.str();
+    }
+  }
+
+  napi_value Result(napi_env env) override {
+    napi_value object;
+    NAPI_CALL(env, napi_create_object(env, &object));
+    if (!SetNamed(env, object, "accepted", MakeBool(env, accepted)) ||
+        !SetNamed(env, object, "steps", MakeUint(env, steps)) || !SetNamed(env, object, "nodes", MakeUint(env, nodes)) ||
+        (want_trace && !SetNamed(env, object, "trace", ParseJson(env, trace))) ||
+        (want_tree && !tree.empty() && !SetNamed(env, object, "tree", CopyToArrayBuffer(env, tree)))) {
+      ThrowLastError(env);
+      return nullptr;
+    }
+    return object;
+  }
+};
+
+/**
+ * Reads up to count arguments, missing ones are left as nullptr.
+ */
+bool GetArgs(napi_env env, napi_callback_info info, napi_value *args, size_t count) {
+  size_t argc = count;
+  if (napi_get_cb_info(env, info, &argc, args, nullptr, nullptr) != napi_ok) {
+    return false;
+  }
+  for (size_t i = argc; i < count; i++) {
+    args[i] = nullptr;
+  }
+  return true;
+}
+
+napi_value Compile(napi_env env, napi_callback_info info) {
+  napi_value args[2];
+  if (!GetArgs(env, info, args, 2)) {
+    ThrowLastError(env);
+    return nullptr;
+  }
+  auto work = std::make_unique<CompileWork>();
+  if (args[0] == nullptr || !GetString(env, args[0], work->text)) {
+    napi_throw_type_error(env, nullptr, "compile expects the grammar text");
+    return nullptr;
+  }
+  GetStringOption(env, args[1], "baseDir", work->base_dir);
+  return Queue(env, std::move(work), "jucc.compile");
+}
+
+napi_value ImportedModules(napi_env env, napi_callback_info info) {
+  napi_value args[2];
+  if (!GetArgs(env, info, args, 2)) {
+    ThrowLastError(env);
+    return nullptr;
+  }
+  std::string text;
+  std::string base_dir;
+  if (args[0] == nullptr || !GetString(env, args[0], text)) {
+    napi_throw_type_error(env, nullptr, "importedModules expects the grammar text");
+    return nullptr;
+  }
+  GetStringOption(env, args[1], "baseDir", base_dir);
+  std::string modules = pipeline::ImportedModulesText(text, base_dir);
+  napi_value result;
+  NAPI_CALL(env, napi_create_string_utf8(env, modules.data(), modules.size(), &result));
+  return result;
+}
+
+napi_value Lex(napi_env env, napi_callback_info info) {
+  napi_value args[2];
+  if (!GetArgs(env, info, args, 2)) {
+    ThrowLastError(env);
+    return nullptr;
+  }
+  auto work = std::make_unique<LexWork>();
+  if (args[0] == nullptr || !GetString(env, args[0], work->source)) {
+    napi_throw_type_error(env, nullptr, "lex expects the source text");
+    return nullptr;
+  }
+  work->binary = GetOption(env, args[1], "binary");
+  return Queue(env, std::move(work), "jucc.lex");
+}
+
+napi_value Parse(napi_env env, napi_callback_info info) {
+  napi_value args[3];
+  if (!GetArgs(env, info, args, 3)) {
+    ThrowLastError(env);
+    return nullptr;
+  }
+  auto work = std::make_unique<ParseWork>();
+
+  void *handle = nullptr;
+  if (args[0] == nullptr || napi_unwrap(env, args[0], &handle) != napi_ok || handle == nullptr) {
+    napi_throw_type_error(env, nullptr, "parse expects a grammar returned by compile");
+    return nullptr;
+  }
+  work->grammar = *static_cast<GrammarHandle *>(handle);
+
+  bool is_array = false;
+  if (args[1] != nullptr && napi_is_array(env, args[1], &is_array) == napi_ok && is_array) {
+    uint32_t length = 0;
+    NAPI_CALL(env, napi_get_array_length(env, args[1], &length));
+    work->tokens.resize(length);
+    for (uint32_t i = 0; i < length; i++) {
+      napi_value token;
+      NAPI_CALL(env, napi_get_element(env, args[1], i, &token));
+      if (!GetString(env, token, work->tokens[i])) {
+        napi_throw_type_error(env, nullptr, "parse expects tokens to be terminal names");
+        return nullptr;
+      }
+    }
+  } else if (args[1] != nullptr && GetString(env, args[1], work->source)) {
+    work->has_source = true;
+  } else {
+    napi_throw_type_error(env, nullptr, "parse expects a source text or an array of tokens");
+    return nullptr;
+  }
+  work->want_trace = GetOption(env, args[2], "trace");
+  work->want_tree = GetOption(env, args[2], "tree");
+  return Queue(env, std::move(work), "jucc.parse");
+}
+
+napi_value Init(napi_env env, napi_value exports) {
+  napi_property_descriptor properties[] = {
+      {"compile", nullptr, Compile, nullptr, nullptr, nullptr, napi_default, nullptr},
+      {"importedModules", nullptr, ImportedModules, nullptr, nullptr, nullptr, napi_default, nullptr},
+      {"lex", nullptr, Lex, nullptr, nullptr, nullptr, napi_default, nullptr},
+      {"parse", nullptr, Parse, nullptr, nullptr, nullptr, napi_default, nullptr},
+  };
+  NAPI_CALL(env, napi_define_properties(env, exports, sizeof(properties) / sizeof(properties[0]), properties));
+  return exports;
+}
+
+}  // namespace
+
+}  // namespace jucc::addon
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, jucc::addon::Init)
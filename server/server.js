@@ -3,6 +3,9 @@ const path = require('path');
 const fs = require('fs');
 const { exec } = require('child_process');
 
+// In-process lexer and parser, null unless native/ has been built with `npm run build-native`
+const native = require('./native');
+
 const app = express();
 
 // Use EJS as the view engine
@@ -101,6 +104,12 @@ app.post('/run-lexer', (req, res) => {
     return res.status(400).json({ error: 'No code provided.' });
   }
 
+  if (native) {
+    return native.lex(code)
+      .then(tokens => res.json({ tokens }))
+      .catch(err => res.status(500).json({ error: 'Lexer execution failed: ' + err.message }));
+  }
+
   // Step 1: Write user input to input.txt
   fs.writeFileSync(inputFilePath, code);
 
@@ -244,15 +253,46 @@ app.get("/first-follow", (req, res) => {
   });
 });
 
+// parsing_table.json lists only non-error cells ({ format: "sparse", terminals, rows }),
+// the frontend shows every cell so missing ones are filled in as "error".
+function expandParsingTable(table) {
+  if (table.format !== "sparse") {
+    return table;
+  }
+  const dense = {};
+  for (const [nonTerminal, row] of Object.entries(table.rows)) {
+    dense[nonTerminal] = {};
+    for (const terminal of table.terminals) {
+      dense[nonTerminal][terminal] = "error";
+    }
+    for (const terminal of row.synch || []) {
+      dense[nonTerminal][terminal] = "synch";
+    }
+    for (const [terminal, cell] of Object.entries(row.cells || {})) {
+      dense[nonTerminal][terminal] = String(cell);
+    }
+  }
+  return dense;
+}
+
 //parsing table route
 app.get("/parsing-table", (req, res) => {
   const backendPath = path.join(__dirname, '..', 'backend');
   const exePath = path.join(backendPath, 'parsing_table_run.exe');
   const jsonPath = path.join(backendPath, 'parsing_table.json');
   const testJsonPath = path.join(backendPath, 'test_parsing_table.json');
+  const grammarFilePath = path.join(backendPath, 'grammar.jgb');
   const buildDirPath = path.join(backendPath, 'build');
+  const buildGrammarFilePath = path.join(buildDirPath, 'test_grammar.jgb');
 
   exec(`"${exePath}"`, { cwd: backendPath }, (error, stdout, stderr) => {
+    // /run-parser prefers the compiled grammar, a copy from an earlier table must not stay behind
+    if (fs.existsSync(grammarFilePath) && !error && fs.existsSync(buildDirPath)) {
+      fs.copyFileSync(grammarFilePath, buildGrammarFilePath);
+    } else {
+      fs.rmSync(buildGrammarFilePath, { force: true });
+    }
+
     if (error) {
       console.error("Parsing table generation error:", stderr);
       return res.status(500).send("Failed to generate parsing table.");
@@ -279,8 +319,8 @@ app.get("/parsing-table", (req, res) => {
           console.log("Parsing table copied to build/test_parsing_table.json");
         }
         
-        // Return the original format to the frontend
-        res.json(originalTable);
+        // Return every cell to the frontend
+        res.json(expandParsingTable(originalTable));
       } catch (parseErr) {
         console.error("Invalid JSON format in parsing_table.json:", parseErr);
         res.status(500).send("Parsing table data is not valid JSON.");
@@ -292,6 +332,11 @@ app.get("/parsing-table", (req, res) => {
 // LL(1) Parser route
 app.post("/run-parser", async (req, res) => {
   try {
+    const grammarFilePath = path.join(__dirname, '..', 'backend', 'grammar.txt');
+    if (native && fs.existsSync(grammarFilePath)) {
+      return res.json(await parseInProcess(grammarFilePath, req.body.tokens));
+    }
+
     // First ensure the parser is built
     await buildParser();
     
@@ -372,7 +417,9 @@ app.post("/run-parser", async (req, res) => {
     // Run the parser from the build directory
     console.log("Running parser:", `"${exePath}"`);
     
-    const parserCmd = `"${exePath}" "${inputPath}" "${grammarPath}" "${parsingTablePath}" "${tracePath}"`;
+    const compiledGrammarPath = path.join(buildPath, 'test_grammar.jgb');
+    const grammarFileArg = fs.existsSync(compiledGrammarPath) ? ` --grammar-file "${compiledGrammarPath}"` : '';
+    const parserCmd = `"${exePath}" "${inputPath}" "${grammarPath}" "${parsingTablePath}" "${tracePath}"${grammarFileArg}`;
     console.log("Full parser command:", parserCmd);
     
     exec(parserCmd, { cwd: buildPath }, (error, stdout, stderr) => {
@@ -441,6 +488,110 @@ app.post("/run-parser", async (req, res) => {
   }
 });
 
+// Page through the chunked trace written next to parse_trace.json
+// GET /parse-trace?from=100&to=200 returns steps [from, to) in the parse_trace.json format,
+// GET /parse-trace?count=1 returns the number of steps.
+app.get("/parse-trace", (req, res) => {
+  const backendPath = path.join(__dirname, '..', 'backend');
+  const buildPath = path.join(backendPath, 'build');
+  const exePath = path.join(buildPath, 'trace_slice_run.exe');
+  const traceFilePath = path.join(buildPath, 'parse_trace.jtr');
+
+  if (!fs.existsSync(traceFilePath)) {
+    return res.status(404).json({ error: "No trace available. Run the parser first." });
+  }
+
+  let args;
+  if (req.query.count) {
+    args = "--count";
+  } else {
+    const from = parseInt(req.query.from, 10);
+    const to = parseInt(req.query.to, 10);
+    if (isNaN(from) || isNaN(to) || from < 0 || to < from) {
+      return res.status(400).json({ error: "Expected 0 <= from <= to." });
+    }
+    args = `${from} ${to}`;
+  }
+
+  exec(`"${exePath}" "${traceFilePath}" ${args}`, { cwd: buildPath, maxBuffer: 64 * 1024 * 1024 }, (error, stdout, stderr) => {
+    if (error) {
+      console.error("Trace slice error:", stderr);
+      return res.status(500).json({ error: "Failed to read parse trace: " + stderr });
+    }
+    try {
+      res.json(JSON.parse(stdout));
+    } catch (err) {
+      res.status(500).json({ error: "Invalid trace slice output: " + err.message });
+    }
+  });
+});
+
+// GET /parse-tree-slice?node=1234&depth=2 returns the subtree below a node in Treant.js format,
+// node defaults to the root and depth to 1. GET /parse-tree-slice?count=1 returns the number of nodes.
+app.get("/parse-tree-slice", (req, res) => {
+  const backendPath = path.join(__dirname, '..', 'backend');
+  const buildPath = path.join(backendPath, 'build');
+  const exePath = path.join(buildPath, 'tree_slice_run.exe');
+  const treeFilePath = path.join(buildPath, 'parse_tree.jst');
+
+  if (!fs.existsSync(treeFilePath)) {
+    return res.status(404).json({ error: "No parse tree available. Run the parser first." });
+  }
+
+  let args;
+  if (req.query.count) {
+    args = "--count";
+  } else {
+    const node = req.query.node === undefined ? "root" : parseInt(req.query.node, 10);
+    const depth = req.query.depth === undefined ? 1 : parseInt(req.query.depth, 10);
+    if ((node !== "root" && (isNaN(node) || node < 0)) || isNaN(depth) || depth < 0) {
+      return res.status(400).json({ error: "Expected a node id and depth >= 0." });
+    }
+    args = `${node} ${depth}`;
+  }
+
+  exec(`"${exePath}" "${treeFilePath}" ${args}`, { cwd: buildPath, maxBuffer: 64 * 1024 * 1024 }, (error, stdout, stderr) => {
+    if (error) {
+      console.error("Tree slice error:", stderr);
+      return res.status(500).json({ error: "Failed to read parse tree: " + stderr });
+    }
+    try {
+      res.json(JSON.parse(stdout));
+    } catch (err) {
+      res.status(500).json({ error: "Invalid tree slice output: " + err.message });
+    }
+  });
+});
+
+// Parses the tokens with the grammar last sent to /run-grammar without spawning the
+// parser or writing any files; responds in the same shape as the executable path
+async function parseInProcess(grammarFilePath, tokens) {
+  const grammar = await native.compileCached(await fs.promises.readFile(grammarFilePath, 'utf8'),
+                                             path.dirname(grammarFilePath));
+  const terminals = tokens && tokens.length > 0
+    ? tokens.map(token => {
+        const tokenType = token.type.split(' ')[0];
+        return tokenType === 'identifier' ? 'id' : tokenType;
+      })
+    : ['id', '+', 'id', '*', 'id'];
+
+  const result = await native.parse(grammar, terminals, { trace: true });
+  if (result.trace.length === 0) {
+    throw new Error("Parser failed with no usable trace");
+  }
+  const parseTree = generateParseTree(result.trace);
+  if (!result.accepted) {
+    return {
+      success: false,
+      message: "Parsing failed but partial trace available",
+      error: "Parsing failed",
+      parseTrace: result.trace,
+      parseTree: parseTree
+    };
+  }
+  return { success: true, parseTrace: result.trace, parseTree: parseTree };
+}
+
 // Function to generate a parse tree from trace data
 function generateParseTree(traceData) {
   // Create root node from first entry's stack_top